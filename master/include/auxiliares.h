@@ -10,9 +10,14 @@ extern t_query* _query_a_buscar;
 t_query* buscar_query_por_id(uint32_t id);
 t_worker* buscar_worker_por_fd(int fd);
 bool worker_esta_libre(void* w_void);
+void worker_ocupar_slot(t_worker* w, t_query* q);
+void worker_liberar_slot(t_worker* w, t_query* q);
+void destruir_worker(void* w_void);
 t_query* obtener_query_menor_prioridad();
 bool worker_tiene_query(void* w_void);  
 bool comparar_prioridad(void* elem1, void* elem2);
+void obtener_ip_remota(int fd, char* ip, size_t tam);
+void metricas_acumular(t_query_end_metricas* total, const t_query_end_metricas* tramo);
 
 
 #endif
\ No newline at end of file
@@ -35,17 +35,24 @@ typedef struct {
     t_estado_query estado;
     int fd_query_control;        // socket de quien la envió (-1 si no aplica)
     int fd_worker_asignado;      // socket del worker ejecutándola (-1 si no aplica)
+    int fd_worker_desalojo;      // worker que todavía no confirmó su desalojo (-1 si no aplica)
     int prioridad;
     uint32_t program_counter;    
-    char* payload;               // lo que envió el query control (texto)
+    uint32_t offset_pc;          // byte del PC en el script (lo informa el Worker al desalojar, 0 = no se sabe)
+    uint32_t version_script;     // versión del script para la que vale offset_pc
+    char ip_qc[64];              // canal directo de resultados del QC ("" = no lo pidió)
+    uint32_t puerto_qc;
+    uint32_t token_qc;
     uint64_t tiempo_entrada_ready; // Aging
+    t_query_end_metricas met_tramos; // resumen de memoria de asignaciones anteriores (desalojos)
 } t_query;
 
 typedef struct {
     int worker_id;        
     int fd;               // socket del worker
-    bool libre;           // si puede recibir una query
-    t_query* query_actual;// si está ejecutando una query
+    uint32_t slots;       // queries que puede ejecutar a la vez (HELLO_WORKER)
+    uint32_t slots_libres;// si > 0 puede recibir una query
+    t_list* queries;      // queries que está ejecutando (t_query*)
 } t_worker;
 
 // ----- FUNCIONES -----
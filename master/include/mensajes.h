@@ -9,6 +9,11 @@ typedef struct {
     uint32_t query_id;
     char filename[256];
     uint32_t pc_inicial;
+    uint32_t offset_pc;      // 0 = el Worker busca el PC en el script
+    uint32_t version_script;
+    char ip_qc[64];          // canal directo Worker -> QC (puerto_qc = 0: por el Master)
+    uint32_t puerto_qc;
+    uint32_t token_qc;
 } t_exec_query;
 
 // Struct para desalojar una query por Prioridad
@@ -1,5 +1,6 @@
 #include "../include/auxiliares.h"
 #include "../include/inicializaciones.h"
+#include <arpa/inet.h>
 
 t_query* _query_a_buscar = NULL;
 
@@ -55,7 +56,25 @@ t_worker* buscar_worker_por_fd(int fd) {
 //(PLANIFICADOR)
 bool worker_esta_libre(void* w_void) {
     t_worker* w = (t_worker*) w_void;
-    return w->libre;
+    return w->slots_libres > 0;
+}
+
+// (PLANIFICADOR / SERVIDOR) llamar con mutex_workers tomado
+void worker_ocupar_slot(t_worker* w, t_query* q) {
+    if (w->slots_libres > 0) w->slots_libres--;
+    if (q) list_add(w->queries, q);
+}
+
+void worker_liberar_slot(t_worker* w, t_query* q) {
+    if (q) list_remove_element(w->queries, q);
+    if (w->slots_libres < w->slots) w->slots_libres++;
+}
+
+// (MAIN)
+void destruir_worker(void* w_void) {
+    t_worker* w = (t_worker*) w_void;
+    list_destroy(w->queries);
+    free(w);
 }
 
 // (PLANIFICADOR)
@@ -66,10 +85,12 @@ t_query* obtener_query_menor_prioridad() {
         return NULL;
     }
 
-    t_query* q_menor = list_get(cola_exec, 0);
-    for (int i = 1; i < list_size(cola_exec); i++) {
+    // Las que ya tienen un desalojo pedido no cuentan (esperan su ACK)
+    t_query* q_menor = NULL;
+    for (int i = 0; i < list_size(cola_exec); i++) {
         t_query* q = list_get(cola_exec, i);
-        if (q->prioridad > q_menor->prioridad) {
+        if (q->fd_worker_desalojo != -1) continue;
+        if (q_menor == NULL || q->prioridad > q_menor->prioridad) {
             q_menor = q;
         }
     }
@@ -81,7 +102,10 @@ t_query* obtener_query_menor_prioridad() {
 // PLANIFICADOR)
 bool worker_tiene_query(void* w_void) {
     t_worker* w = (t_worker*) w_void;
-    return w->query_actual == _query_a_buscar;
+    for (int i = 0; i < list_size(w->queries); i++) {
+        if (list_get(w->queries, i) == _query_a_buscar) return true;
+    }
+    return false;
 }
 
 // (COLA READY)
@@ -89,4 +113,26 @@ bool comparar_prioridad(void* elem1, void* elem2) {
     t_query* q1 = (t_query*) elem1;
     t_query* q2 = (t_query*) elem2;
     return q1->prioridad < q2->prioridad;
-}
\ No newline at end of file
+}
+
+// (SERVIDOR) IP de quien está del otro lado del socket ("" si no se pudo)
+void obtener_ip_remota(int fd, char* ip, size_t tam) {
+    struct sockaddr_in dir;
+    socklen_t len = sizeof(dir);
+
+    ip[0] = '\0';
+    if (getpeername(fd, (struct sockaddr*)&dir, &len) != 0 || dir.sin_family != AF_INET) return;
+    if (!inet_ntop(AF_INET, &dir.sin_addr, ip, (socklen_t)tam)) ip[0] = '\0';
+}
+
+// (SERVIDOR) Suma el resumen de memoria de un tramo de ejecución al total
+void metricas_acumular(t_query_end_metricas* total, const t_query_end_metricas* tramo) {
+    total->hits              += tramo->hits;
+    total->misses            += tramo->misses;
+    total->reemplazos        += tramo->reemplazos;
+    total->reemplazos_sucios += tramo->reemplazos_sucios;
+    total->flushes           += tramo->flushes;
+    total->pagein_us         += tramo->pagein_us;
+    if (tramo->pagein_max_us > total->pagein_max_us) total->pagein_max_us = tramo->pagein_max_us;
+    total->retardo_us        += tramo->retardo_us;
+}
@@ -26,6 +26,24 @@ int enviar_asignacion_query_fd(int fd_worker, const t_exec_query* asignacion) {
         return -1;
     }
 
+    // Opcional: dónde empieza el PC en el script (Query desalojada). Va
+    // siempre que haya canal directo, que viene después
+    if ((asignacion->offset_pc != 0 || asignacion->puerto_qc != 0) &&
+        (paquete_cargar_uint32(&paq, asignacion->offset_pc) != 0 ||
+         paquete_cargar_uint32(&paq, asignacion->version_script) != 0)) {
+        paquete_destruir(&paq);
+        return -1;
+    }
+
+    // Opcional: canal directo al QC (el Worker le manda los READ sin pasar por acá)
+    if (asignacion->puerto_qc != 0 &&
+        (paquete_cargar_uint32(&paq, asignacion->puerto_qc) != 0 ||
+         paquete_cargar_uint32(&paq, asignacion->token_qc) != 0 ||
+         paquete_cargar_cstring(&paq, asignacion->ip_qc) != 0)) {
+        paquete_destruir(&paq);
+        return -1;
+    }
+
     
     if (enviar_paquete(fd_worker, OP_ASIGNACION_QUERY, &paq) != 0) {
         paquete_destruir(&paq);
@@ -59,30 +77,35 @@ int enviar_desalojo_por_prioridad_fd(int fd_worker, const t_desalojo_query* desa
     return 0;
 }
 
-// Envio de lectura a un QC
-int enviar_read_a_query_control(t_query* q, t_worker* w) {
-    if (!q || !w) return -1;
-    
-    t_paquete paq;
-    paquete_iniciar(&paq);
+// Envio de lectura a un QC: [u32 offset][u32 len][bytes], directo del buffer
+// recibido del Worker (los bytes pueden tener '\0')
+int enviar_read_a_query_control(t_query* q, t_worker* w, const void* lectura, uint32_t len) {
+    if (!q || !w || !lectura) return -1;
 
-    
-    if (paquete_cargar_cstring(&paq, q->payload) != 0) {
-        log_error(logger, "Error cargando payload al paquete para QC");
-        paquete_destruir(&paq);
+    struct iovec parte = { .iov_base = (void*)lectura, .iov_len = len };
+
+    if (enviar_frame_iov(q->fd_query_control, OP_READ_RESULT, &parte, 1) != 0) {
+        log_error(logger, "Error enviando OP_READ_RESULT al Query Control (fd=%d)", q->fd_query_control);
         return -1;
     }
 
-    
-    if (enviar_paquete(q->fd_query_control, OP_READ_RESULT, &paq) != 0) {
-        log_error(logger, "Error enviando OP_READ_RESULT al Query Control (fd=%d)", q->fd_query_control);
-        paquete_destruir(&paq);
+    log_info(logger, "## Se envía un mensaje de lectura de la Query %u en el Worker %d al Query Control", q->id, w->worker_id ); // OBLIGATORIO
+    return 0;
+}
+
+// Reenvío de un lote de lecturas al QC: [u32 cantidad] + cantidad x [u32 offset][u32 len][bytes].
+// Sale directo del buffer recibido del Worker (sin copiar ni armar paquete)
+int enviar_lote_lecturas_a_query_control(t_query* q, t_worker* w, const void* lecturas, uint32_t len) {
+    if (!q || !w || !lecturas) return -1;
+
+    struct iovec parte = { .iov_base = (void*)lecturas, .iov_len = len };
+
+    if (enviar_frame_iov(q->fd_query_control, OP_READ_RESULT_LOTE, &parte, 1) != 0) {
+        log_error(logger, "Error enviando OP_READ_RESULT_LOTE al Query Control (fd=%d)", q->fd_query_control);
         return -1;
     }
 
     log_info(logger, "## Se envía un mensaje de lectura de la Query %u en el Worker %d al Query Control", q->id, w->worker_id ); // OBLIGATORIO
-   
-    paquete_destruir(&paq);
     return 0;
 }
 
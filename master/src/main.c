@@ -3,6 +3,7 @@
 #include "../include/servidor.h"
 #include "../include/planificador.h"
 #include "../include/aging.h"
+#include "../include/auxiliares.h"
 
 int main(int argc, char** argv) {
      if (argc < 2) {
@@ -54,7 +55,7 @@ int main(int argc, char** argv) {
 
 
 void destruir_estructuras() {
-    list_destroy_and_destroy_elements(workers, free);
+    list_destroy_and_destroy_elements(workers, destruir_worker);
     list_destroy_and_destroy_elements(cola_ready, free);
     list_destroy_and_destroy_elements(cola_exec, free);
     list_destroy_and_destroy_elements(cola_exit, free);
@@ -41,17 +41,16 @@ void* planificador_loop(void* arg) {
                         t_desalojo_query desalojo = {0};
                         desalojo.query_id = q_menor->id;
 
-                        if (enviar_desalojo_por_prioridad_fd(w_objetivo->fd, &desalojo) == 0) {
-                            
-                            pthread_mutex_lock(&mutex_exec);
-                            list_remove_element(cola_exec, q_menor);
-                            pthread_mutex_unlock(&mutex_exec);
-
-                            q_menor->estado = READY;
-                            q_menor->fd_worker_asignado = -1;
-                            q->tiempo_entrada_ready = obtener_timestamp_ms();
-                            ready_push(q_menor); 
-
+                        // Antes de mandarlo: las lecturas que lleguen de este Worker
+                        // hasta el ACK se siguen reenviando al QC
+                        q_menor->fd_worker_desalojo = w_objetivo->fd;
+
+                        if (enviar_desalojo_por_prioridad_fd(w_objetivo->fd, &desalojo) != 0) {
+                            q_menor->fd_worker_desalojo = -1;
+                        } else {
+                            // q_menor sigue en EXEC hasta el ACK: recién ahí se conoce
+                            // su PC y vuelve a READY (servidor.c). Antes, otro slot que
+                            // se libere no debe poder reasignarla con el PC viejo.
                             sem_wait(&sem_workers); // Esperamos sem post del worker en servidor.c
                             
                             tengo_worker_libre = true;
@@ -87,19 +86,24 @@ void* planificador_loop(void* arg) {
             continue;
         }
 
-        w->libre = false;
+        worker_ocupar_slot(w, NULL);
         pthread_mutex_unlock(&mutex_workers);
 
         t_exec_query asignacion = {0};
         asignacion.query_id = q->id;
         strncpy(asignacion.filename, q->path_query, sizeof(asignacion.filename) - 1);
         asignacion.pc_inicial = q->program_counter;
+        asignacion.offset_pc = q->offset_pc;
+        asignacion.version_script = q->version_script;
+        memcpy(asignacion.ip_qc, q->ip_qc, sizeof(asignacion.ip_qc));
+        asignacion.puerto_qc = q->puerto_qc;
+        asignacion.token_qc = q->token_qc;
 
         if (enviar_asignacion_query_fd(w->fd, &asignacion) != 0) {
             log_error(logger, "Error al enviar Query %d al Worker %d", q->id, w->worker_id);
             
             pthread_mutex_lock(&mutex_workers);
-            w->libre = true;
+            worker_liberar_slot(w, NULL);
             pthread_mutex_unlock(&mutex_workers);
             
             sem_post(&sem_workers);
@@ -108,7 +112,7 @@ void* planificador_loop(void* arg) {
         }
 
         pthread_mutex_lock(&mutex_workers);
-        w->query_actual = q;
+        list_add(w->queries, q);
         pthread_mutex_unlock(&mutex_workers);
 
         q->fd_worker_asignado = w->fd;
@@ -58,13 +58,40 @@ void* atender_cliente(void* arg) {
                 q->estado = READY;
                 q->fd_query_control = cfd;
                 q->fd_worker_asignado = -1;
+                q->fd_worker_desalojo = -1;
                 q->prioridad = prioridad;
                 q->program_counter = 0;
-                q->payload = NULL;
+                q->offset_pc = 0;
+                q->version_script = 0;
+                q->ip_qc[0] = '\0';
+                q->puerto_qc = 0;
+                q->token_qc = 0;
                 q->tiempo_entrada_ready = 0; 
+                memset(&q->met_tramos, 0, sizeof(q->met_tramos));
             
                 q->tiempo_entrada_ready = obtener_timestamp_ms();
 
+                // Opcional después del path: [u32 puerto][u32 token][cstring ip] del
+                // canal directo de resultados. Sin ip se usa la dirección de la conexión
+                size_t fin_path = sizeof(uint32_t) + strnlen(path, paq.buffer.size - sizeof(uint32_t)) + 1;
+                if (fin_path + 2 * sizeof(uint32_t) <= paq.buffer.size) {
+                    const char* extra = (const char*)paq.buffer.stream + fin_path;
+                    memcpy(&q->puerto_qc, extra, sizeof(uint32_t));
+                    memcpy(&q->token_qc, extra + sizeof(uint32_t), sizeof(uint32_t));
+
+                    size_t resto = paq.buffer.size - fin_path - 2 * sizeof(uint32_t);
+                    const char* ip = extra + 2 * sizeof(uint32_t);
+                    if (resto > 0 && strnlen(ip, resto) < resto && ip[0] != '\0') {
+                        snprintf(q->ip_qc, sizeof(q->ip_qc), "%s", ip);
+                    } else {
+                        obtener_ip_remota(cfd, q->ip_qc, sizeof(q->ip_qc));
+                    }
+
+                    if (q->puerto_qc == 0 || q->ip_qc[0] == '\0') q->puerto_qc = 0;
+                    else log_debug(logger, "Query %d: canal directo de resultados en %s:%u",
+                                   q->id, q->ip_qc, q->puerto_qc);
+                }
+
                 log_info(logger, "## Se conecta un Query Control para ejecutar la Query %s con prioridad %u - Id asignado: %d. Nivel de multiprocesamiento %d", 
                         q->path_query, q->prioridad, q->id, list_size(workers)); // OBLIGATORIO
  
@@ -75,7 +102,8 @@ void* atender_cliente(void* arg) {
             }
 
             case OP_HELLO_WORKER: {
-                if (paq.buffer.size != sizeof(uint32_t)) {
+                // payload: [u32 worker_id][u32 slots opcional] (sin slots = 1)
+                if (paq.buffer.size != sizeof(uint32_t) && paq.buffer.size != 2 * sizeof(uint32_t)) {
                     log_error(logger, "Tamaño inválido HELLO_WORKER: %u", paq.buffer.size);
                     paquete_destruir(&paq); 
                     close(cfd); 
@@ -84,35 +112,57 @@ void* atender_cliente(void* arg) {
 
                 uint32_t worker_id;
                 memcpy(&worker_id, paq.buffer.stream, sizeof(worker_id));
+
+                uint32_t slots = 1;
+                if (paq.buffer.size == 2 * sizeof(uint32_t)) {
+                    memcpy(&slots, (char*)paq.buffer.stream + sizeof(uint32_t), sizeof(slots));
+                    if (slots == 0) slots = 1;
+                }
                 paquete_destruir(&paq);
 
                 t_worker* w = malloc(sizeof(t_worker));
                 w->worker_id = worker_id;
                 w->fd = cfd; 
-                w->libre = true;
-                w->query_actual = NULL;
+                w->slots = slots;
+                w->slots_libres = slots;
+                w->queries = list_create();
 
                 pthread_mutex_lock(&mutex_workers);
                 list_add(workers, w);
                 pthread_mutex_unlock(&mutex_workers);
 
-                sem_post(&sem_workers); 
+                // sem_workers cuenta slots libres, no Workers
+                for (uint32_t i = 0; i < slots; i++) sem_post(&sem_workers); 
 
                 log_info(logger, "## Se conecta el Worker %d - Cantidad total de Workers: %d", w->worker_id, list_size(workers)); // OBLIGATORIO
+                if (slots > 1) {
+                    log_info(logger, "Worker %d ejecuta hasta %u Queries en paralelo", w->worker_id, slots);
+                }
                 break;
             }
 
             case OP_READ_RESULT: {
-                uint32_t offset = 0;
+                // [u32 query_id][u32 offset][u32 len][bytes]
+                uint32_t query_id, offset_lectura, len;
 
-                uint32_t query_id;
+                if (paq.buffer.size < 3 * sizeof(uint32_t)) {
+                    log_error(logger, "Tamaño inválido para OP_READ_RESULT: %u", paq.buffer.size);
+                    paquete_destruir(&paq);
+                    break;
+                }
 
-                memcpy(&query_id, paq.buffer.stream + offset, sizeof(uint32_t));
-                offset += sizeof(uint32_t);
+                memcpy(&query_id, paq.buffer.stream, sizeof(uint32_t));
+                memcpy(&offset_lectura, (char*)paq.buffer.stream + sizeof(uint32_t), sizeof(uint32_t));
+                memcpy(&len, (char*)paq.buffer.stream + 2 * sizeof(uint32_t), sizeof(uint32_t));
 
-                const char* contenido = (char*)(paq.buffer.stream + offset);
+                if (len > paq.buffer.size - 3 * sizeof(uint32_t)) {
+                    log_error(logger, "OP_READ_RESULT de Query %u con len=%u mayor al paquete (%u)",
+                              query_id, len, paq.buffer.size);
+                    paquete_destruir(&paq);
+                    break;
+                }
 
-                log_debug(logger, "Llega READ_RESULT de Worker. QueryID=%u Contenido=\"%s\"", query_id, contenido);
+                log_debug(logger, "Llega READ_RESULT de Worker. QueryID=%u Offset=%u Bytes=%u", query_id, offset_lectura, len);
 
         
                 t_query* q = buscar_query_por_id(query_id);
@@ -124,32 +174,83 @@ void* atender_cliente(void* arg) {
                 }
 
                 // (Tolerancia sin romper) Se puede mandar la lectura al QC si se lo necesita 
-                if (q->estado == READY) {
+                // Desalojada: el Worker manda las lecturas hechas antes del ACK y
+                // retoma después de ellas, así que se reenvían hasta que llega
+                bool desalojando = (q->fd_worker_desalojo == cfd);
+                if (q->estado == READY && !desalojando) {
                     log_warning(logger, "Ignorando READ_RESULT de Query %u (encontrada en READY, fue desalojada).", query_id);
                     paquete_destruir(&paq);
                     break;
                 }
 
-                t_worker* w = buscar_worker_por_fd(q->fd_worker_asignado);
+                t_worker* w = buscar_worker_por_fd(desalojando ? cfd : q->fd_worker_asignado);
                 if (!w) {
                     log_error(logger, "No se encontró Worker asociado (fd=%d) para Query %u",
                             q->fd_worker_asignado, q->id);
                     paquete_destruir(&paq);
                     break;
                 }
-                
-                if (q->payload) free(q->payload);
-                q->payload = strdup(contenido);
-            
-                enviar_read_a_query_control(q, w); 
+
+                // El QC recibe [offset][len][bytes] tal cual llegaron (sin copiar)
+                enviar_read_a_query_control(q, w, (char*)paq.buffer.stream + sizeof(uint32_t),
+                                            paq.buffer.size - sizeof(uint32_t));
 
                 paquete_destruir(&paq);
                 break;
             }
             
+            case OP_READ_RESULT_LOTE: {
+                // [u32 query_id][u32 cantidad] + cantidad x [u32 offset][u32 len][bytes]
+                uint32_t query_id;
+
+                if (paq.buffer.size < 2 * sizeof(uint32_t)) {
+                    log_error(logger, "Tamaño inválido para OP_READ_RESULT_LOTE: %u", paq.buffer.size);
+                    paquete_destruir(&paq);
+                    break;
+                }
+                memcpy(&query_id, paq.buffer.stream, sizeof(uint32_t));
+
+                log_debug(logger, "Llega READ_RESULT_LOTE de Worker. QueryID=%u Bytes=%u", query_id, paq.buffer.size);
+
+                t_query* q = buscar_query_por_id(query_id);
+
+                if (!q) {
+                    log_error(logger, "No se encontró query %u para READ_RESULT_LOTE (ni en Exec ni en Ready)", query_id);
+                    paquete_destruir(&paq);
+                    break;
+                }
+
+                // Desalojada: el Worker manda las lecturas hechas antes del ACK y
+                // retoma después de ellas, así que se reenvían hasta que llega
+                bool desalojando = (q->fd_worker_desalojo == cfd);
+                if (q->estado == READY && !desalojando) {
+                    log_warning(logger, "Ignorando READ_RESULT_LOTE de Query %u (encontrada en READY, fue desalojada).", query_id);
+                    paquete_destruir(&paq);
+                    break;
+                }
+
+                t_worker* w = buscar_worker_por_fd(desalojando ? cfd : q->fd_worker_asignado);
+                if (!w) {
+                    log_error(logger, "No se encontró Worker asociado (fd=%d) para Query %u",
+                            q->fd_worker_asignado, q->id);
+                    paquete_destruir(&paq);
+                    break;
+                }
+
+                // El QC recibe el mismo payload sin el query_id
+                enviar_lote_lecturas_a_query_control(q, w,
+                    (char*)paq.buffer.stream + sizeof(uint32_t),
+                    paq.buffer.size - sizeof(uint32_t));
+
+                paquete_destruir(&paq);
+                break;
+            }
+
             case OP_QUERY_END: {
     
-                if (paq.buffer.size != sizeof(t_query_end)) {
+                // Un Worker nuevo agrega el resumen de memoria al final
+                if (paq.buffer.size != sizeof(t_query_end) &&
+                    paq.buffer.size != sizeof(t_query_end) + sizeof(t_query_end_metricas)) {
                     log_error(logger, "Tamaño inválido para OP_QUERY_END: %u", paq.buffer.size);
                     paquete_destruir(&paq);
                     break;
@@ -164,9 +265,32 @@ void* atender_cliente(void* arg) {
                 log_debug(logger, "Llega QUERY_END de Worker. QueryID=%u PC_final=%u Estado=%u",
                         query_id, final_pc, (unsigned)final_status);
 
-                
                 t_query* q = buscar_query_por_id(query_id);
 
+                if (paq.buffer.size > sizeof(t_query_end)) {
+                    t_query_end_metricas met;
+                    memcpy(&met, (char*)paq.buffer.stream + sizeof(t_query_end), sizeof(met));
+
+                    // Más lo de las asignaciones anteriores, si fue desalojada
+                    if (q) metricas_acumular(&met, &q->met_tramos);
+
+                    uint64_t accesos = met.hits + met.misses;
+                    log_info(logger, "Query %u memoria: hits=%llu misses=%llu (hit ratio %llu%%) "
+                             "reemplazos=%llu (sucios=%llu) flushes=%llu page-in=%llu ms (max %llu us) "
+                             "retardo=%llu ms",
+                             query_id,
+                             (unsigned long long)met.hits,
+                             (unsigned long long)met.misses,
+                             (unsigned long long)(accesos ? met.hits * 100 / accesos : 0),
+                             (unsigned long long)met.reemplazos,
+                             (unsigned long long)met.reemplazos_sucios,
+                             (unsigned long long)met.flushes,
+                             (unsigned long long)(met.pagein_us / 1000),
+                             (unsigned long long)met.pagein_max_us,
+                             (unsigned long long)(met.retardo_us / 1000));
+                }
+
+
                if (q) {
                     q->program_counter = final_pc;
                 
@@ -192,8 +316,7 @@ void* atender_cliente(void* arg) {
 
                 if (w) {
                     pthread_mutex_lock(&mutex_workers);
-                    w->libre = true;
-                    w->query_actual = NULL;
+                    worker_liberar_slot(w, q);
                     pthread_mutex_unlock(&mutex_workers);
             
                     log_info(logger, "## Se terminó la Query %u en el Worker %u", q->id, w->worker_id); // OBLIGATORIO
@@ -220,32 +343,57 @@ void* atender_cliente(void* arg) {
                 log_debug(logger, "## Worker devuelve contexto por desalojo. QueryID=%u PC=%u",
                     query_id, pc_actual);
 
+                // Opcional: [u32 offset][u32 version] del PC en el script y
+                // después el resumen de memoria del tramo que termina
+                uint32_t offset_pc = 0, version_script = 0;
+                if (paq.buffer.size >= 4 * sizeof(uint32_t)) {
+                    memcpy(&offset_pc, paq.buffer.stream + 2 * sizeof(uint32_t), sizeof(uint32_t));
+                    memcpy(&version_script, paq.buffer.stream + 3 * sizeof(uint32_t), sizeof(uint32_t));
+                }
+                bool hay_met = paq.buffer.size >= 4 * sizeof(uint32_t) + sizeof(t_query_end_metricas);
+
                 t_query* q = buscar_query_por_id(query_id);
-            
-                if (q) {
-                    q->program_counter = pc_actual;
-                } else {
-                    log_error(logger, "No se encontró query %u para actualizar PC en desalojo", query_id);
+                t_worker* w = buscar_worker_por_fd(cfd);
+
+                // Terminó (QUERY_END) antes de atender el desalojo: su slot ya
+                // se liberó y el planificador ya recibió el aviso
+                if (!q || q->estado != EXEC || q->fd_worker_desalojo != cfd) {
+                    log_warning(logger, "Ignorando ACK de desalojo de Query %u (ya no está en ejecución en ese Worker).",
+                                query_id);
+                    paquete_destruir(&paq);
+                    break;
                 }
 
-                t_worker* w = NULL;
-                w = buscar_worker_por_fd(cfd);
+                q->program_counter = pc_actual;
+                q->offset_pc = offset_pc;
+                q->version_script = version_script;
+                q->fd_worker_desalojo = -1;
+
+                if (hay_met) {
+                    t_query_end_metricas tramo;
+                    memcpy(&tramo, paq.buffer.stream + 4 * sizeof(uint32_t), sizeof(tramo));
+                    metricas_acumular(&q->met_tramos, &tramo);
+                }
 
                 if (w) {
                     pthread_mutex_lock(&mutex_workers);
-                    w->libre = true;
-                    w->query_actual = NULL;
+                    worker_liberar_slot(w, q);
                     pthread_mutex_unlock(&mutex_workers);
                 }
 
+                // Recién con el PC actualizado vuelve a READY
+                pthread_mutex_lock(&mutex_exec);
+                list_remove_element(cola_exec, q);
+                pthread_mutex_unlock(&mutex_exec);
 
-                if (q) {
-                    log_info(logger, "## Se desaloja la Query %u (%u) del Worker %d - Motivo: PRIORIDAD", 
-                    q->id, q->prioridad, w->worker_id); // OBLIGATORIO
-                } else {
-                    log_info(logger, "## Se desaloja la Query %u (?) del Worker %d - Motivo: PRIORIDAD", 
-                            query_id, w->worker_id); // OBLIGATORIO
-                }   
+                q->estado = READY;
+                q->fd_worker_asignado = -1;
+                q->tiempo_entrada_ready = obtener_timestamp_ms();
+
+                log_info(logger, "## Se desaloja la Query %u (%u) del Worker %d - Motivo: PRIORIDAD", 
+                         q->id, q->prioridad, w ? w->worker_id : -1); // OBLIGATORIO
+
+                ready_push(q);
 
                 sem_post(&sem_workers);
                 paquete_destruir(&paq);
@@ -284,8 +432,7 @@ void* atender_cliente(void* arg) {
 
                 if (w) {
                     pthread_mutex_lock(&mutex_workers);
-                    w->libre = true;
-                    w->query_actual = NULL; 
+                    worker_liberar_slot(w, q);
                     pthread_mutex_unlock(&mutex_workers);
                 }
 
@@ -324,21 +471,19 @@ void* atender_cliente(void* arg) {
 void manejar_desconexion_worker(t_worker* w) {
     pthread_mutex_lock(&mutex_exec);
 
-    t_query* q = NULL;
+    // Con varios slots el Worker puede tener más de una Query en ejecución
+    int finalizadas = 0;
     for (int i = 0; i < list_size(cola_exec); i++) {
-        t_query* aux = list_get(cola_exec, i);
-        if (aux->fd_worker_asignado == w->fd) {
-            q = aux;
-            break;
-        }
-    }
+        t_query* q = list_get(cola_exec, i);
+        if (q->fd_worker_asignado != w->fd) continue;
+        finalizadas++;
 
-    if (q) {
         log_info(logger,"## Se desconecta el Worker %d - Se finaliza la Query %u - Cantidad total de Workers: %d",
                     w->worker_id, q->id, list_size(workers) - 1 ); // OBLIGATORIO
 
         q->estado = EXIT;
         q->fd_worker_asignado = -1;
+        q->fd_worker_desalojo = -1;   // desalojo sin ACK: ya no llegan más lecturas suyas
 
         // Notificamos al QC si hay
         if (q->fd_query_control != -1) {
@@ -351,7 +496,9 @@ void manejar_desconexion_worker(t_worker* w) {
             log_debug(logger, "## Worker %d desconectado. Query %u finalizada con error (QC ya desconectado)",
                      w->worker_id, q->id);
         }
-    } else {
+    }
+
+    if (finalizadas == 0) {
         log_info(logger, "## Worker %d (fd=%d) se desconectó sin tener Query en ejecución",
                  w->worker_id, w->fd);
     }
@@ -362,7 +509,7 @@ void manejar_desconexion_worker(t_worker* w) {
     list_remove_element(workers, w);
     pthread_mutex_unlock(&mutex_workers);
 
-    free(w);
+    destruir_worker(w);
 
     log_debug(logger, "## Worker desconectado eliminado del sistema. Total de Workers: %d", list_size(workers));
 }
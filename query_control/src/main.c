@@ -4,6 +4,11 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
 #include "../../utils/src/net.h"
 #include "../../utils/src/proto.h"
 #include "../../utils/src/paquete.h"
@@ -13,8 +18,34 @@ typedef struct {
     char* ip_master;
     char* puerto_master;
     char* log_level;
+    int   canal_directo;        // 1 = los Workers mandan los READ directo acá
+    char* puerto_resultados;    // "0" = cualquiera libre
+    char* ip_resultados;        // "" = la que ve el Master en la conexión
+    char* salida_lecturas;      // NINGUNA / stdout / path de archivo
 } t_query_config;
 
+// Dónde se escriben los bytes crudos de cada READ (además del log)
+typedef struct {
+    int fd;           // -1 = sin salida
+    int posicional;   // archivo: cada lectura va en su offset (pwrite)
+} t_salida;
+
+// Canal directo de resultados abierto por un Worker. El socket es no
+// bloqueante y los frames se leen de a pedazos: un peer que manda media
+// cabecera no cuelga al QC. Hasta presentarse solo se acepta
+// OP_CANAL_RESULTADOS de 8 bytes y hay CANAL_PRESENTACION_MS para hacerlo.
+#define MAX_CANALES 8
+#define CANAL_PRESENTACION_MS 2000
+
+typedef struct {
+    int         fd;
+    int         presentado;   // ya mandó OP_CANAL_RESULTADOS con el token correcto
+    uint64_t    desde_ms;     // momento del accept
+    t_frame_hdr cab;          // frame en curso
+    uint32_t    leidos;       // bytes del frame en curso (cabecera + cuerpo)
+    char*       cuerpo;
+} t_canal;
+
 // Función para leer el archivo de configuración
 t_query_config* leer_config(const char* path) {
     t_config* cfg = config_create((char*) path);
@@ -24,6 +55,14 @@ t_query_config* leer_config(const char* path) {
     c->ip_master = strdup(config_get_string_value(cfg, "IP_MASTER"));
     c->puerto_master = strdup(config_get_string_value(cfg, "PUERTO_MASTER"));
     c->log_level = strdup(config_get_string_value(cfg, "LOG_LEVEL"));
+    c->canal_directo = config_has_property(cfg, "CANAL_DIRECTO")
+        ? config_get_int_value(cfg, "CANAL_DIRECTO") : 0;
+    c->puerto_resultados = strdup(config_has_property(cfg, "PUERTO_RESULTADOS")
+        ? config_get_string_value(cfg, "PUERTO_RESULTADOS") : "0");
+    c->ip_resultados = strdup(config_has_property(cfg, "IP_RESULTADOS")
+        ? config_get_string_value(cfg, "IP_RESULTADOS") : "");
+    c->salida_lecturas = strdup(config_has_property(cfg, "SALIDA_LECTURAS")
+        ? config_get_string_value(cfg, "SALIDA_LECTURAS") : "NINGUNA");
     config_destroy(cfg);
     return c;
 }
@@ -34,9 +73,212 @@ void destruir_config(t_query_config* c) {
     free(c->ip_master);
     free(c->puerto_master);
     free(c->log_level);
+    free(c->puerto_resultados);
+    free(c->ip_resultados);
+    free(c->salida_lecturas);
     free(c);
 }
 
+// Abre la salida de lecturas. Devuelve -1 si se pidió un archivo y no se pudo abrir
+int abrir_salida(const char* destino, t_salida* salida) {
+    salida->fd = -1;
+    salida->posicional = 0;
+
+    if (!destino || destino[0] == '\0' || strcmp(destino, "NINGUNA") == 0) return 0;
+
+    if (strcmp(destino, "stdout") == 0) {
+        salida->fd = STDOUT_FILENO;
+        return 0;
+    }
+
+    salida->fd = open(destino, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    salida->posicional = 1;
+    return salida->fd >= 0 ? 0 : -1;
+}
+
+// Log obligatorio (se corta en el primer '\0', como siempre) y bytes crudos a
+// la salida: en un archivo cada lectura queda en su offset, así una Query que
+// lee todo un File lo exporta tal cual; en stdout van en orden de llegada
+void mostrar_lectura(t_log* logger, const t_salida* salida, uint32_t offset, const char* datos, uint32_t len) {
+    log_info(logger, "## Lectura/ACK recibida: %.*s", (int)len, datos);
+    if (salida->fd < 0) return;
+    if (!salida->posicional) fflush(stdout);   // que quede después del log
+
+    uint32_t escrito = 0;
+    while (escrito < len) {
+        ssize_t n = salida->posicional
+            ? pwrite(salida->fd, datos + escrito, len - escrito, (off_t)offset + escrito)
+            : write(salida->fd, datos + escrito, len - escrito);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            log_error(logger, "No pude escribir la lectura (offset=%u) en la salida: %s", offset, strerror(errno));
+            return;
+        }
+        escrito += (uint32_t)n;
+    }
+}
+
+// Una lectura de OP_READ_RESULT: [u32 offset][u32 len][bytes]
+void mostrar_resultado(t_log* logger, const t_salida* salida, const char* p, uint32_t tam) {
+    uint32_t offset = 0, len = 0;
+    if (tam < 2 * sizeof(uint32_t)) return;
+
+    memcpy(&offset, p, sizeof(uint32_t));
+    memcpy(&len, p + sizeof(uint32_t), sizeof(uint32_t));
+    if (len > tam - 2 * sizeof(uint32_t)) return;
+
+    mostrar_lectura(logger, salida, offset, p + 2 * sizeof(uint32_t), len);
+}
+
+// Lecturas de un OP_READ_RESULT_LOTE: [u32 cantidad] + cantidad x [u32 offset][u32 len][bytes]
+void mostrar_lote(t_log* logger, const t_salida* salida, const char* p, uint32_t tam) {
+    uint32_t off = sizeof(uint32_t);
+    uint32_t cantidad = 0;
+
+    if (tam >= sizeof(uint32_t)) memcpy(&cantidad, p, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < cantidad; i++) {
+        uint32_t offset = 0, len = 0;
+        if (off + 2 * sizeof(uint32_t) > tam) break;
+        memcpy(&offset, p + off, sizeof(uint32_t));
+        memcpy(&len, p + off + sizeof(uint32_t), sizeof(uint32_t));
+        off += 2 * sizeof(uint32_t);
+        if (len > tam - off) break;
+
+        mostrar_lectura(logger, salida, offset, p + off, len);
+        off += len;
+    }
+}
+
+// Token que el Worker tiene que presentar (lo conocen solo el Master y él)
+uint32_t generar_token(void) {
+    uint32_t token = 0;
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd >= 0) {
+        if (read(fd, &token, sizeof(token)) != sizeof(token)) token = 0;
+        close(fd);
+    }
+    if (token == 0) token = (uint32_t)getpid() ^ (uint32_t)time(NULL);
+    return token;
+}
+
+static uint64_t ahora_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+void cerrar_canal(t_canal* c) {
+    close(c->fd);
+    free(c->cuerpo);
+    c->fd     = -1;
+    c->cuerpo = NULL;
+}
+
+// Lee lo que haya del frame en curso. Devuelve 1 si quedó completo, 0 si
+// falta (seguir cuando poll avise) y -1 si el canal se cerró o el frame no
+// es aceptable. La cabecera se valida antes de reservar el cuerpo.
+int leer_frame_canal(t_canal* c, t_log* logger) {
+    const uint32_t tam_cab = sizeof(t_frame_hdr);
+
+    while (1) {
+        char*    destino;
+        uint32_t falta;
+
+        if (c->leidos < tam_cab) {
+            destino = (char*)&c->cab + c->leidos;
+            falta   = tam_cab - c->leidos;
+        } else {
+            uint32_t len = ntohl(c->cab.len);
+            uint32_t hay = c->leidos - tam_cab;
+            if (hay == len) return 1;
+            destino = c->cuerpo + hay;
+            falta   = len - hay;
+        }
+
+        ssize_t r = recv(c->fd, destino, falta, 0);
+        if (r == 0) return -1;
+        if (r < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+        c->leidos += (uint32_t)r;
+
+        if (c->leidos == tam_cab) {
+            uint16_t op  = ntohs(c->cab.opcode);
+            uint32_t len = ntohl(c->cab.len);
+
+            if (!c->presentado && (op != OP_CANAL_RESULTADOS || len != 2 * sizeof(uint32_t))) {
+                log_warning(logger, "## Canal de resultados rechazado: no se presentó (OP_CODE %u, %u bytes)", op, len);
+                return -1;
+            }
+            if (len > 0 && !(c->cuerpo = malloc(len))) return -1;
+        }
+    }
+}
+
+// Atiende los frames completos de un canal directo. Devuelve 0 si el canal sigue abierto
+int atender_canal(t_canal* c, uint32_t token, const t_salida* salida, t_log* logger) {
+    int r;
+    while ((r = leer_frame_canal(c, logger)) == 1) {
+        uint16_t    op_code = ntohs(c->cab.opcode);
+        const char* p       = c->cuerpo;
+        uint32_t    tam     = ntohl(c->cab.len);
+        int         rc      = 0;
+
+        if (op_code == OP_CANAL_RESULTADOS) {
+            // [u32 query_id][u32 token]
+            uint32_t recibido = 0;
+            if (tam == 2 * sizeof(uint32_t)) memcpy(&recibido, p + sizeof(uint32_t), sizeof(uint32_t));
+            c->presentado = (recibido == token);
+            if (!c->presentado) {
+                log_warning(logger, "## Canal de resultados rechazado: token inválido");
+                rc = -1;
+            }
+        } else if (op_code == OP_READ_RESULT_LOTE && tam >= sizeof(uint32_t)) {
+            // Igual que el del Master pero con el query_id adelante
+            mostrar_lote(logger, salida, p + sizeof(uint32_t), tam - sizeof(uint32_t));
+        } else if (op_code == OP_CANAL_FIN) {
+            // Todo lo anterior ya se mostró: el Worker puede seguir con el END.
+            // El OK es lo último del canal: se manda bloqueante
+            fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) & ~O_NONBLOCK);
+            enviar_frame_iov(c->fd, OP_OK, NULL, 0);
+            rc = -1;
+        } else {
+            log_warning(logger, "## Canal de resultados: OP_CODE desconocido: %u", op_code);
+        }
+
+        free(c->cuerpo);
+        c->cuerpo = NULL;
+        c->leidos = 0;
+        if (rc != 0) return rc;
+    }
+    return r;
+}
+
+// Canal nuevo: si no hay lugar se echa al más viejo que todavía no se
+// presentó (uno que se quedó mudo no puede dejar afuera al Worker real)
+void aceptar_canal(int fd_escucha, t_canal* canales, int* cant_canales, t_log* logger) {
+    int fd = accept(fd_escucha, NULL, NULL);
+    if (fd < 0) return;
+
+    if (*cant_canales == MAX_CANALES) {
+        int viejo = -1;
+        for (int i = 0; i < *cant_canales; i++) {
+            if (canales[i].presentado) continue;
+            if (viejo < 0 || canales[i].desde_ms < canales[viejo].desde_ms) viejo = i;
+        }
+        if (viejo < 0) {
+            log_warning(logger, "## Canal de resultados rechazado: no hay lugar");
+            close(fd);
+            return;
+        }
+        log_warning(logger, "## Canal de resultados cerrado: sin presentarse y hace falta el lugar");
+        cerrar_canal(&canales[viejo]);
+        canales[viejo] = canales[--(*cant_canales)];
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    canales[(*cant_canales)++] = (t_canal){ .fd = fd, .presentado = 0, .desde_ms = ahora_ms() };
+}
+
 int main(int argc, char** argv) {
     if (argc != 4) {
         fprintf(stderr, "Uso: %s [archivo_config] [archivo_query] [prioridad]\n", argv[0]);
@@ -60,10 +302,20 @@ int main(int argc, char** argv) {
         log_level_from_string(cfg->log_level)
     );
 
+    t_salida salida;
+    if (abrir_salida(cfg->salida_lecturas, &salida) != 0) {
+        log_error(logger, "No se pudo abrir la salida de lecturas %s - Motivo: %s",
+                  cfg->salida_lecturas, strerror(errno));
+        destruir_config(cfg);
+        log_destroy(logger);
+        return EXIT_FAILURE;
+    }
+
     int fd_master = conectar_a(cfg->ip_master, cfg->puerto_master);
     if (fd_master == -1) {
         log_error(logger, "No se pudo conectar al Master (%s:%s) - Motivo: %s",
                   cfg->ip_master, cfg->puerto_master, strerror(errno));
+        if (salida.fd > STDOUT_FILENO) close(salida.fd);
         destruir_config(cfg);
         log_destroy(logger);
         return EXIT_FAILURE;
@@ -73,6 +325,28 @@ int main(int argc, char** argv) {
              "## Conexión al Master exitosa. IP: %s, Puerto: %s",
              cfg->ip_master, cfg->puerto_master);
 
+    // Canal directo (opcional): escuchamos y le pasamos puerto + token al
+    // Master, que se los da al Worker que ejecute la Query
+    int      fd_escucha = -1;
+    uint32_t puerto_resultados = 0;
+    uint32_t token = 0;
+
+    if (cfg->canal_directo) {
+        fd_escucha = escuchar_en(cfg->puerto_resultados);
+
+        struct sockaddr_in dir;
+        socklen_t len = sizeof(dir);
+        if (fd_escucha >= 0 && getsockname(fd_escucha, (struct sockaddr*)&dir, &len) == 0) {
+            puerto_resultados = ntohs(dir.sin_port);
+            token = generar_token();
+        } else {
+            log_warning(logger, "No pude escuchar en el puerto de resultados %s. Las lecturas llegan por el Master.",
+                        cfg->puerto_resultados);
+            if (fd_escucha >= 0) close(fd_escucha);
+            fd_escucha = -1;
+        }
+    }
+
     // =========================================================================
     // ENVÍO DE PAQUETE (tamaño variable): OP_SUBMIT_QUERY
     // =========================================================================
@@ -82,6 +356,11 @@ int main(int argc, char** argv) {
     // Cargamos los campos individualmente
     paquete_cargar(&paquete_envio, &prioridad, sizeof(uint32_t));
     paquete_cargar_cstring(&paquete_envio, path_query); // incluye el '\0'
+    if (fd_escucha >= 0) {
+        paquete_cargar_uint32(&paquete_envio, puerto_resultados);
+        paquete_cargar_uint32(&paquete_envio, token);
+        paquete_cargar_cstring(&paquete_envio, cfg->ip_resultados);
+    }
 
     enviar_paquete(fd_master, OP_SUBMIT_QUERY, &paquete_envio);
     log_info(logger,
@@ -91,11 +370,63 @@ int main(int argc, char** argv) {
     paquete_destruir(&paquete_envio);
     // =========================================================================
 
-    // Bucle para esperar mensajes del Master
+    // Bucle para esperar mensajes del Master (y de los canales directos)
     bool seguir       = true;
     bool recibio_end  = false;
 
+    t_canal canales[MAX_CANALES];
+    int     cant_canales = 0;
+
     while (seguir) {
+        struct pollfd pfds[2 + MAX_CANALES];
+        int n = 0;
+        pfds[n++] = (struct pollfd){ .fd = fd_master, .events = POLLIN };
+        if (fd_escucha >= 0) pfds[n++] = (struct pollfd){ .fd = fd_escucha, .events = POLLIN };
+        for (int i = 0; i < cant_canales; i++) {
+            pfds[n++] = (struct pollfd){ .fd = canales[i].fd, .events = POLLIN };
+        }
+
+        // Si hay canales sin presentar, despertar a tiempo para cortarlos
+        int espera = -1;
+        uint64_t ahora = ahora_ms();
+        for (int i = 0; i < cant_canales; i++) {
+            if (canales[i].presentado) continue;
+            uint64_t vence = canales[i].desde_ms + CANAL_PRESENTACION_MS;
+            int resta = vence > ahora ? (int)(vence - ahora) : 0;
+            if (espera < 0 || resta < espera) espera = resta;
+        }
+
+        if (poll(pfds, n, espera) < 0) {
+            if (errno == EINTR) continue;
+            log_error(logger, "poll: %s", strerror(errno));
+            break;
+        }
+
+        // Canales directos: se atienden antes que el Master (el Worker cierra
+        // el suyo antes de mandar el END)
+        int base = n - cant_canales;
+        for (int i = cant_canales - 1; i >= 0; i--) {
+            if (pfds[base + i].revents == 0) continue;
+            if (atender_canal(&canales[i], token, &salida, logger) != 0) {
+                cerrar_canal(&canales[i]);
+                canales[i] = canales[--cant_canales];
+            }
+        }
+
+        ahora = ahora_ms();
+        for (int i = cant_canales - 1; i >= 0; i--) {
+            if (canales[i].presentado || ahora < canales[i].desde_ms + CANAL_PRESENTACION_MS) continue;
+            log_warning(logger, "## Canal de resultados cerrado: no se presentó a tiempo");
+            cerrar_canal(&canales[i]);
+            canales[i] = canales[--cant_canales];
+        }
+
+        if (fd_escucha >= 0 && (pfds[1].revents & POLLIN)) {
+            aceptar_canal(fd_escucha, canales, &cant_canales, logger);
+        }
+
+        if (pfds[0].revents == 0) continue;
+
         uint16_t op_code;
         t_paquete paquete_resp;
         paquete_iniciar(&paquete_resp);
@@ -115,8 +446,12 @@ int main(int argc, char** argv) {
 
         switch (op_code) {
             case OP_READ_RESULT: {
-                char* contenido = (char*) paquete_resp.buffer.stream;
-                log_info(logger, "## Lectura/ACK recibida: %s", contenido);
+                mostrar_resultado(logger, &salida, (const char*) paquete_resp.buffer.stream, paquete_resp.buffer.size);
+                break;
+            }
+
+            case OP_READ_RESULT_LOTE: {
+                mostrar_lote(logger, &salida, (const char*) paquete_resp.buffer.stream, paquete_resp.buffer.size);
                 break;
             }
 
@@ -142,6 +477,9 @@ int main(int argc, char** argv) {
     }
 
     // Limpieza de recursos
+    for (int i = 0; i < cant_canales; i++) cerrar_canal(&canales[i]);
+    if (fd_escucha >= 0) close(fd_escucha);
+    if (salida.fd > STDOUT_FILENO) close(salida.fd);
     close(fd_master);
     destruir_config(cfg);
     log_destroy(logger);
@@ -62,3 +62,37 @@ int recv_all(int fd, void* buf, uint32_t len) {
     }
     return 0;
 }
+
+int send_iov_all(int fd, struct iovec* iov, int cant) {
+    while (cant > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = (size_t)cant;
+
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n <= 0) return -1;
+
+        // Saltear los segmentos completos y recortar el parcial
+        while (cant > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            cant--;
+        }
+        if (cant > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
+
+int recv_descartar(int fd, uint32_t len) {
+    char tmp[512];
+    while (len > 0) {
+        uint32_t n = len < sizeof(tmp) ? len : (uint32_t)sizeof(tmp);
+        if (recv_all(fd, tmp, n) != 0) return -1;
+        len -= n;
+    }
+    return 0;
+}
@@ -1,8 +1,14 @@
 #ifndef NET_H
 #define NET_H
 #include <stdint.h>
+#include <sys/uio.h>
 int conectar_a(const char* ip, const char* puerto);
 int escuchar_en(const char* puerto);
 int send_all(int fd, const void* buf, uint32_t len);
 int recv_all(int fd, void* buf, uint32_t len);
+
+// Envía todos los segmentos con writev/sendmsg (modifica 'iov' al avanzar)
+int send_iov_all(int fd, struct iovec* iov, int cant);
+// Lee y tira 'len' bytes (resto de un payload que no interesa)
+int recv_descartar(int fd, uint32_t len);
 #endif
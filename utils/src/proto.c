@@ -45,3 +45,38 @@ int recibir_paquete(int fd, uint16_t* op_code, t_paquete* paquete) {
     *op_code = op;
     return 0;
 }
+
+int enviar_frame_iov(int fd, uint16_t op_code, const struct iovec* partes, int cantidad) {
+    if (cantidad < 0 || cantidad > FRAME_MAX_PARTES) return -1;
+
+    struct iovec iov[FRAME_MAX_PARTES + 1];
+    uint32_t total = 0;
+    int n = 0;
+
+    t_frame_hdr hdr;
+    iov[n].iov_base = &hdr;
+    iov[n].iov_len  = sizeof(hdr);
+    n++;
+
+    for (int i = 0; i < cantidad; i++) {
+        if (partes[i].iov_len == 0) continue;
+        iov[n++] = partes[i];
+        total += (uint32_t)partes[i].iov_len;
+    }
+
+    hdr.opcode = htons(op_code);
+    hdr.len    = htonl(total);
+
+    return send_iov_all(fd, iov, n);
+}
+
+int recibir_cabecera(int fd, uint16_t* op_code, uint32_t* len) {
+    if (!op_code || !len) return -1;
+
+    t_frame_hdr hdr;
+    if (recv_all(fd, &hdr, sizeof(hdr)) != 0) return -1;
+
+    *op_code = ntohs(hdr.opcode);
+    *len     = ntohl(hdr.len);
+    return 0;
+}
@@ -2,6 +2,7 @@
 #define PROTO_H
 
 #include <stdint.h>
+#include <sys/uio.h>
 #include "paquete.h"
 
 #define M_MAX_PATH 4096
@@ -23,9 +24,14 @@ enum {
     
     // Worker -> Master
     OP_QUERY_END              = 8,   // Fin de Query (id, pc_final, estado)
-    OP_READ_RESULT            = 9,   // Resultado de READ (id, cstring)
-    OP_DESALOJO_PRIORIDAD_OK  = 10,  // ACK desalojo por prioridad (query_id, pc_actual)
+    OP_READ_RESULT            = 9,   // Resultado de READ (id, offset, len, bytes); Master -> QC sin el id
+    OP_DESALOJO_PRIORIDAD_OK  = 10,  // ACK desalojo por prioridad (query_id, pc_actual, offset, version, resumen opcional)
     OP_DESALOJO_CANCELACION_OK = 18, // ACK desalojo por cancelación (query_id, pc_actual)
+    OP_READ_RESULT_LOTE       = 20,  // Varios READ (id, cantidad, [offset][len][bytes]...); Master -> QC sin el id
+
+    // Worker -> Query Control (canal directo de resultados, opcional)
+    OP_CANAL_RESULTADOS = 21,  // Abre el canal (query_id, token que el QC le dio al Master)
+    OP_CANAL_FIN        = 22,  // Cierra el canal (query_id); el QC responde OP_OK
 
     // Worker -> Storage
     OP_COMMIT      = 11,
@@ -35,6 +41,7 @@ enum {
     OP_TAG         = 15,
     OP_DELETE      = 16,
     OP_CREATE      = 17,
+    OP_WRITE_PARTIAL = 19,   // Escribe solo [offset, offset+len) dentro del bloque
 
     // Respuestas genéricas
     OP_OK          = 100,
@@ -74,8 +81,32 @@ typedef struct __attribute__((__packed__)) {
     uint32_t worker_id;
 } t_get_block_size_req;
 
+// Resumen de memoria de la Query que el Worker agrega al final de
+// OP_QUERY_END (después de query_id, pc_final y estado). Un Master que no
+// lo conoce lo ignora; uno viejo de Worker manda solo los 12 bytes.
+// El ACK de desalojo por prioridad lleva el del tramo que termina (el
+// Worker lo pierde al liberar la Query): el Master los suma por Query y el
+// QUERY_END se informa con el total de todas las asignaciones.
+typedef struct __attribute__((__packed__)) {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t reemplazos;          // páginas desalojadas por misses de la Query
+    uint64_t reemplazos_sucios;   // de esas, las que hubo que persistir
+    uint64_t flushes;             // páginas de la Query persistidas en Storage
+    uint64_t pagein_us;           // tiempo total resolviendo misses
+    uint64_t pagein_max_us;
+    uint64_t retardo_us;          // retardo de memoria cobrado
+} t_query_end_metricas;
+
 // =================== API DE FRAMING ===================
 int enviar_paquete(int fd, uint16_t op_code, const t_paquete* paquete);
 int recibir_paquete(int fd, uint16_t* op_code, t_paquete* paquete);
 
+// Sin t_paquete intermedio: el payload son los segmentos 'partes' tal cual
+// están en memoria (se mandan con un solo writev junto con la cabecera)
+#define FRAME_MAX_PARTES 8
+int enviar_frame_iov(int fd, uint16_t op_code, const struct iovec* partes, int cantidad);
+// Solo la cabecera: el caller lee el payload donde le convenga (recv_all)
+int recibir_cabecera(int fd, uint16_t* op_code, uint32_t* len);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,275 @@
+// ============================================================================
+// WORKER - bench_politicas.c
+// PASO A PASO GENERAL
+// 1) Lee una traza de accesos "FILE:TAG PAGINA R|W|P" (una por línea, '#'
+//    comenta). P es un page-in por adelantado (read-ahead): si la página no
+//    está la trae avisando es_prefetch, y no cuenta como acceso
+// 2) Resuelve cada (File:Tag, página) a una ETP una sola vez
+// 3) Reproduce la traza contra cada política de reemplazo con N marcos
+// 4) Reporta hit rate, desalojos, desalojos dirty y ns por acceso
+//
+// Trazas reales: con TRAZA_PAGINAS=<archivo> en worker.cfg el Worker graba
+// sus accesos a páginas en este formato (incluye los P del read-ahead).
+//
+// Uso: bin/worker_bench <traza> <marcos> [POLITICA ...]
+//      (sin políticas, corre todas las registradas)
+// ============================================================================
+
+#include "../src/memoria_interna/memoria_politica.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint32_t etp;     // índice en el vector de ETPs
+    uint8_t  write;
+    uint8_t  prefetch;
+} t_acceso;
+
+typedef struct {
+    char*    clave;   // "FILE:TAG/PAGINA"
+    uint32_t etp;
+} t_slot;
+
+static t_slot*   g_slots     = NULL;
+static uint32_t  g_cap_slots = 0;
+
+static t_etp*    g_etps      = NULL;
+static uint32_t  g_cant_etps = 0;
+static uint32_t  g_cap_etps  = 0;
+
+static t_acceso* g_accesos   = NULL;
+static uint32_t  g_cant_acc  = 0;
+static uint32_t  g_cap_acc   = 0;
+static uint32_t  g_cant_pref = 0;   // líneas P (no cuentan para el hit rate)
+
+// ---------------------------------------------------------------------------
+// Índice (File:Tag, página) -> ETP
+// ---------------------------------------------------------------------------
+static uint32_t _hash(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void _rehash(void);
+
+static uint32_t _etp_para(const char* file, const char* tag, uint32_t pagina) {
+    char clave[1100];
+    snprintf(clave, sizeof(clave), "%s:%s/%u", file, tag, pagina);
+
+    if (g_cant_etps * 2 >= g_cap_slots) _rehash();
+
+    uint32_t i = _hash(clave) & (g_cap_slots - 1);
+    while (g_slots[i].clave) {
+        if (strcmp(g_slots[i].clave, clave) == 0) return g_slots[i].etp;
+        i = (i + 1) & (g_cap_slots - 1);
+    }
+
+    if (g_cant_etps == g_cap_etps) {
+        g_cap_etps = g_cap_etps ? g_cap_etps * 2 : 1024;
+        g_etps     = realloc(g_etps, sizeof(t_etp) * g_cap_etps);
+    }
+
+    t_etp* e = &g_etps[g_cant_etps];
+    memset(e, 0, sizeof(*e));
+    e->ft.file           = strdup(file);
+    e->ft.tag            = strdup(tag);
+    e->nro_pagina        = pagina;
+    e->id_bloque_storage = pagina;
+
+    g_slots[i].clave = strdup(clave);
+    g_slots[i].etp   = g_cant_etps;
+    return g_cant_etps++;
+}
+
+static void _rehash(void) {
+    uint32_t viejo_cap = g_cap_slots;
+    t_slot*  viejos    = g_slots;
+
+    g_cap_slots = viejo_cap ? viejo_cap * 2 : 2048;
+    g_slots     = calloc(g_cap_slots, sizeof(t_slot));
+
+    for (uint32_t j = 0; j < viejo_cap; j++) {
+        if (!viejos[j].clave) continue;
+        uint32_t i = _hash(viejos[j].clave) & (g_cap_slots - 1);
+        while (g_slots[i].clave) i = (i + 1) & (g_cap_slots - 1);
+        g_slots[i] = viejos[j];
+    }
+    free(viejos);
+}
+
+// ---------------------------------------------------------------------------
+// Carga de la traza
+// ---------------------------------------------------------------------------
+static int _cargar_traza(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+
+    char linea[1024];
+    int  nro = 0;
+    while (fgets(linea, sizeof(linea), f)) {
+        nro++;
+        char ft[512];
+        unsigned pagina;
+        char op;
+
+        if (linea[0] == '#' || linea[0] == '\n') continue;
+        if (sscanf(linea, "%511s %u %c", ft, &pagina, &op) != 3 ||
+            (op != 'R' && op != 'W' && op != 'P')) {
+            fprintf(stderr, "%s:%d: línea inválida, se ignora\n", path, nro);
+            continue;
+        }
+
+        char* sep = strchr(ft, ':');
+        const char* tag = "BASE";
+        if (sep) {
+            *sep = '\0';
+            tag  = sep + 1;
+        }
+
+        if (g_cant_acc == g_cap_acc) {
+            g_cap_acc = g_cap_acc ? g_cap_acc * 2 : 4096;
+            g_accesos = realloc(g_accesos, sizeof(t_acceso) * g_cap_acc);
+        }
+        g_accesos[g_cant_acc].etp      = _etp_para(ft, tag, pagina);
+        g_accesos[g_cant_acc].write    = (op == 'W');
+        g_accesos[g_cant_acc].prefetch = (op == 'P');
+        if (op == 'P') g_cant_pref++;
+        g_cant_acc++;
+    }
+
+    fclose(f);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Replay contra una política
+// ---------------------------------------------------------------------------
+static void _correr(const t_politica_reemplazo* pol, uint32_t cant_marcos) {
+    t_etp**   marcos     = calloc(cant_marcos, sizeof(t_etp*));
+    uint32_t  libres     = cant_marcos;
+    uint64_t  hits       = 0;
+    uint64_t  desalojos  = 0;
+    uint64_t  desalojos_dirty = 0;
+
+    for (uint32_t i = 0; i < g_cant_etps; i++) {
+        g_etps[i].presencia = 0;
+        g_etps[i].dirty     = 0;
+        g_etps[i].nro_marco = 0;
+        g_etps[i].pol_nodo  = NULL;
+    }
+
+    pol->init(cant_marcos);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (uint32_t i = 0; i < g_cant_acc; i++) {
+        t_etp* e = &g_etps[g_accesos[i].etp];
+        int    es_prefetch = g_accesos[i].prefetch;
+
+        if (e->presencia) {
+            if (es_prefetch) continue;
+            hits++;
+            pol->on_access(e);
+        } else {
+            int marco;
+            if (libres > 0) {
+                marco = (int)(cant_marcos - libres);
+                libres--;
+            } else {
+                marco = pol->pick_victim(e);
+                if (marco < 0 || (uint32_t)marco >= cant_marcos || !marcos[marco]) {
+                    fprintf(stderr, "%s: no eligió víctima válida (%d) en el acceso %u\n",
+                            pol->nombre, marco, i);
+                    break;
+                }
+                t_etp* v = marcos[marco];
+
+                desalojos++;
+                if (v->dirty) desalojos_dirty++;
+
+                pol->on_remove(v, 1);
+                v->presencia = 0;
+                v->dirty     = 0;
+            }
+
+            marcos[marco] = e;
+            e->nro_marco  = (uint32_t)marco;
+            e->presencia  = 1;
+            pol->on_insert(e, es_prefetch);
+        }
+
+        if (g_accesos[i].write) e->dirty = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+
+    uint32_t demanda = g_cant_acc - g_cant_pref;
+    printf("%-10s %10u %9.2f%% %10llu %10llu %9.1f\n",
+           pol->nombre,
+           demanda,
+           demanda ? 100.0 * (double)hits / (double)demanda : 0.0,
+           (unsigned long long)desalojos,
+           (unsigned long long)desalojos_dirty,
+           g_cant_acc ? ns / (double)g_cant_acc : 0.0);
+
+    for (uint32_t i = 0; i < g_cant_etps; i++) pol->on_forget(&g_etps[i]);
+    pol->destroy();
+    free(marcos);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Uso: %s <traza> <marcos> [POLITICA ...]\n", argv[0]);
+        return 1;
+    }
+
+    char* end = NULL;
+    long marcos = strtol(argv[2], &end, 10);
+    if (end == argv[2] || *end != '\0' || marcos <= 0) {
+        fprintf(stderr, "Cantidad de marcos inválida: %s\n", argv[2]);
+        return 1;
+    }
+
+    if (!_cargar_traza(argv[1])) return 1;
+
+    printf("Traza: %s - %u accesos, %u prefetch, %u páginas distintas, %ld marcos\n",
+           argv[1], g_cant_acc - g_cant_pref, g_cant_pref, g_cant_etps, marcos);
+    printf("%-10s %10s %10s %10s %10s %9s\n",
+           "POLITICA", "ACCESOS", "HIT", "DESALOJOS", "DIRTY", "NS/OP");
+
+    if (argc == 3) {
+        const t_politica_reemplazo* const* todas = memoria_politica_todas();
+        for (int i = 0; todas[i]; i++) _correr(todas[i], (uint32_t)marcos);
+    } else {
+        for (int i = 3; i < argc; i++) {
+            const t_politica_reemplazo* pol = memoria_politica_buscar(argv[i]);
+            if (!pol) {
+                fprintf(stderr, "Política desconocida: %s\n", argv[i]);
+                continue;
+            }
+            _correr(pol, (uint32_t)marcos);
+        }
+    }
+
+    for (uint32_t i = 0; i < g_cap_slots; i++) free(g_slots[i].clave);
+    for (uint32_t i = 0; i < g_cant_etps; i++) {
+        free(g_etps[i].ft.file);
+        free(g_etps[i].ft.tag);
+    }
+    free(g_slots);
+    free(g_etps);
+    free(g_accesos);
+    return 0;
+}
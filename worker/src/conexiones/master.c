@@ -4,8 +4,30 @@
 #include "../../utils/src/proto.h"
 #include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
 
-int enviar_hello_worker(const char* ip_master, int puerto_master, t_log* logger, uint32_t worker_id) {
+// Con varios slots de ejecución, cada Query manda READ_RESULT / END / ACK
+// desde su hilo: un mensaje tiene que salir entero antes que el siguiente
+static pthread_mutex_t g_mutex_envio = PTHREAD_MUTEX_INITIALIZER;
+
+static int _enviar_a_master(int fd_master, uint16_t op, t_paquete* p) {
+    pthread_mutex_lock(&g_mutex_envio);
+    int rc = enviar_paquete(fd_master, op, p);
+    pthread_mutex_unlock(&g_mutex_envio);
+    return rc;
+}
+
+static int _enviar_iov_a_master(int fd_master, uint16_t op, const struct iovec* partes, int cantidad) {
+    pthread_mutex_lock(&g_mutex_envio);
+    int rc = enviar_frame_iov(fd_master, op, partes, cantidad);
+    pthread_mutex_unlock(&g_mutex_envio);
+    return rc;
+}
+
+int enviar_hello_worker(const char* ip_master, int puerto_master, t_log* logger, uint32_t worker_id, uint32_t slots) {
     char pstr[16];
     snprintf(pstr, sizeof(pstr), "%d", puerto_master);
 
@@ -19,7 +41,10 @@ int enviar_hello_worker(const char* ip_master, int puerto_master, t_log* logger,
     t_paquete p;
     paquete_iniciar(&p);
 
-    if (paquete_cargar_uint32(&p, worker_id) != 0) {
+    // payload: [u32 worker_id][u32 slots] (slots solo si > 1: un Master
+    // viejo espera exactamente el worker_id)
+    if (paquete_cargar_uint32(&p, worker_id) != 0 ||
+        (slots > 1 && paquete_cargar_uint32(&p, slots) != 0)) {
         if (logger) log_error(logger, "No pude empaquetar HELLO_WORKER");
         paquete_destruir(&p);
         close(fd_master);
@@ -36,49 +61,160 @@ int enviar_hello_worker(const char* ip_master, int puerto_master, t_log* logger,
     paquete_destruir(&p);
 
     if (logger)
-        log_info(logger, "HELLO_WORKER enviado a Master (worker_id=%u)", worker_id);
+        log_info(logger, "HELLO_WORKER enviado a Master (worker_id=%u, slots=%u)", worker_id, slots);
 
     return fd_master; // fd listo para usar
 }
 
 /**
  * Enviar resultado de READ al Master.
- * payload = [u32 query_id][cstring resultado]
+ * payload = [u32 query_id][u32 offset][u32 len][bytes]
+ * Los bytes salen directo del buffer de la lectura (sin copiarlos a un paquete)
  */
-int enviar_resultado_a_master(int fd_master, int query_id, const char* result_data, t_log* logger) {
+int enviar_resultado_a_master(int fd_master, uint32_t query_id, uint32_t offset,
+                              const void* datos, uint32_t len, t_log* logger) {
     if (fd_master < 0) return -1;
 
-    t_paquete p;
-    paquete_iniciar(&p);
+    uint32_t cabecera[3] = { query_id, offset, len };
+    struct iovec partes[2] = {
+        { .iov_base = cabecera,      .iov_len = sizeof(cabecera) },
+        { .iov_base = (void*)datos,  .iov_len = len }
+    };
 
-    if (paquete_cargar_uint32(&p, (uint32_t)query_id) != 0 ||
-        paquete_cargar_cstring(&p, result_data ? result_data : "") != 0) {
+    int rc = _enviar_iov_a_master(fd_master, OP_READ_RESULT, partes, 2);
 
-        if (logger) log_error(logger, "[MASTER] No pude empaquetar READ_RESULT");
-        paquete_destruir(&p);
-        return -1;
+    if (rc != 0 && logger) {
+        log_error(logger, "[MASTER] Error enviando READ_RESULT (Q=%u)", query_id);
+    } else if (logger) {
+        log_info(logger, "[MASTER] READ_RESULT enviado (Q=%u, offset=%u, len=%u)", query_id, offset, len);
     }
 
-    int rc = enviar_paquete(fd_master, OP_READ_RESULT, &p);
-    paquete_destruir(&p);
+    return rc;
+}
+
+// ---------------------------------------------------------------------------
+// Lote de lecturas
+// ---------------------------------------------------------------------------
+struct t_lote_lecturas {
+    int             fd;         // Master, o el QC si es canal directo
+    int             directo;    // el fd es solo de esta Query (sin g_mutex_envio)
+    uint32_t        query_id;
+    uint32_t        cantidad;
+    char*           datos;      // cantidad x [u32 offset][u32 len][bytes]
+    uint32_t        tam;
+    uint32_t        cap;
+    struct timespec primera;    // cuándo se encoló la primera lectura del lote
+};
+
+static uint32_t g_lote_max_bytes = 0;   // 0 = deshabilitado
+static uint32_t g_lote_max_ms    = 50;
+
+void master_configurar_lote_lecturas(uint32_t max_bytes, uint32_t max_ms) {
+    g_lote_max_bytes = max_bytes;
+    g_lote_max_ms    = max_ms;
+}
+
+t_lote_lecturas* lote_lecturas_crear(int fd_master, uint32_t query_id) {
+    if (g_lote_max_bytes == 0) return NULL;
+
+    t_lote_lecturas* lote = calloc(1, sizeof(t_lote_lecturas));
+    if (!lote) return NULL;
+    lote->fd       = fd_master;
+    lote->query_id = query_id;
+    return lote;
+}
+
+t_lote_lecturas* lote_lecturas_crear_directo(int fd_qc, uint32_t query_id) {
+    t_lote_lecturas* lote = calloc(1, sizeof(t_lote_lecturas));
+    if (!lote) return NULL;
+    lote->fd       = fd_qc;
+    lote->directo  = 1;
+    lote->query_id = query_id;
+    return lote;
+}
+
+int lote_lecturas_agregar(t_lote_lecturas* lote, uint32_t offset, const void* datos, uint32_t len, t_log* logger) {
+    // 1) Hacer lugar para [u32 offset][u32 len][bytes]
+    uint32_t necesario = lote->tam + 2 * (uint32_t)sizeof(uint32_t) + len;
+    if (necesario > lote->cap) {
+        uint32_t cap = lote->cap ? lote->cap : 256;
+        while (cap < necesario) cap *= 2;
+        char* nuevo = realloc(lote->datos, cap);
+        if (!nuevo) {
+            if (logger) log_error(logger, "[MASTER] Sin memoria para el lote de lecturas (Q=%u)", lote->query_id);
+            return -1;
+        }
+        lote->datos = nuevo;
+        lote->cap   = cap;
+    }
 
+    // 2) Encolar
+    if (lote->cantidad == 0) clock_gettime(CLOCK_MONOTONIC, &lote->primera);
+    char* p = lote->datos + lote->tam;
+    memcpy(p, &offset, sizeof(uint32_t));
+    memcpy(p + sizeof(uint32_t), &len, sizeof(uint32_t));
+    memcpy(p + 2 * sizeof(uint32_t), datos, len);
+    lote->tam = necesario;
+    lote->cantidad++;
+
+    // 3) Umbral de tamaño (con lotes deshabilitados, un canal directo manda
+    //    cada READ apenas llega)
+    if (lote->tam >= g_lote_max_bytes) return lote_lecturas_enviar(lote, logger);
+    return 0;
+}
+
+int lote_lecturas_vencido(const t_lote_lecturas* lote) {
+    if (!lote || lote->cantidad == 0) return 0;
+
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    int64_t ms = (int64_t)(ahora.tv_sec - lote->primera.tv_sec) * 1000 +
+                 (ahora.tv_nsec - lote->primera.tv_nsec) / 1000000;
+    return ms >= (int64_t)g_lote_max_ms;
+}
+
+int lote_lecturas_enviar(t_lote_lecturas* lote, t_log* logger) {
+    if (!lote || lote->cantidad == 0) return 0;
+
+    // [u32 query_id][u32 cantidad] + las lecturas tal cual están en el buffer
+    uint32_t cabecera[2] = { lote->query_id, lote->cantidad };
+    struct iovec partes[2] = {
+        { .iov_base = cabecera,    .iov_len = sizeof(cabecera) },
+        { .iov_base = lote->datos, .iov_len = lote->tam }
+    };
+
+    int rc = lote->directo
+        ? enviar_frame_iov(lote->fd, OP_READ_RESULT_LOTE, partes, 2)
+        : _enviar_iov_a_master(lote->fd, OP_READ_RESULT_LOTE, partes, 2);
+
+    const char* destino = lote->directo ? "QC" : "MASTER";
     if (rc != 0 && logger) {
-        log_error(logger, "[MASTER] Error enviando READ_RESULT (Q=%d)", query_id);
+        log_error(logger, "[%s] Error enviando READ_RESULT_LOTE (Q=%u)", destino, lote->query_id);
     } else if (logger) {
-        log_info(logger, "[MASTER] READ_RESULT enviado (Q=%d, len=%u)", query_id, p.buffer.size);
+        log_info(logger, "[%s] READ_RESULT_LOTE enviado (Q=%u, lecturas=%u, len=%u)",
+                 destino, lote->query_id, lote->cantidad, lote->tam);
     }
 
+    lote->cantidad = 0;
+    lote->tam      = 0;
     return rc;
 }
 
+void lote_lecturas_destruir(t_lote_lecturas* lote) {
+    if (!lote) return;
+    free(lote->datos);
+    free(lote);
+}
+
 /**
  * Enviar fin de Query al Master.
- * payload = [u32 query_id][u32 pc_final][u32 estado]
+ * payload = [u32 query_id][u32 pc_final][u32 estado][t_query_end_metricas opcional]
  */
 int enviar_end_a_master(int fd_master,
                         uint32_t query_id,
                         uint32_t pc_final,
                         t_query_resultado estado,
+                        const t_query_end_metricas* met,
                         t_log* logger) {
     if (fd_master < 0) return -1;
 
@@ -87,14 +223,15 @@ int enviar_end_a_master(int fd_master,
 
     if (paquete_cargar_uint32(&p, query_id) != 0 ||
         paquete_cargar_uint32(&p, pc_final) != 0 ||
-        paquete_cargar_uint32(&p, (uint32_t)estado) != 0) {
+        paquete_cargar_uint32(&p, (uint32_t)estado) != 0 ||
+        (met && paquete_cargar_struct(&p, met, sizeof(*met)) != 0)) {
 
         if (logger) log_error(logger, "[MASTER] No pude empaquetar QUERY_END");
         paquete_destruir(&p);
         return -1;
     }
 
-    int rc = enviar_paquete(fd_master, OP_QUERY_END, &p);
+    int rc = _enviar_a_master(fd_master, OP_QUERY_END, &p);
     paquete_destruir(&p);
 
     if (rc != 0 && logger) {
@@ -115,20 +252,25 @@ int master_enviar_desalojo_ok(int fd_master, uint32_t query_id, uint32_t pc_actu
     paquete_cargar_uint32(&p, query_id);
     paquete_cargar_uint32(&p, pc_actual);
 
-    int rc = enviar_paquete(fd_master, OP_DESALOJO_PRIORIDAD_OK, &p);
+    int rc = _enviar_a_master(fd_master, OP_DESALOJO_PRIORIDAD_OK, &p);
     paquete_destruir(&p);
     return rc;
 }
 
 // Desalojo por prioridad (reencolar en READY)
-int master_enviar_desalojo_prioridad_ok(int fd_master, uint32_t query_id, uint32_t pc_actual) {
+int master_enviar_desalojo_prioridad_ok(int fd_master, uint32_t query_id, uint32_t pc_actual,
+                                        uint32_t offset, uint32_t version,
+                                        const t_query_end_metricas* met) {
     t_paquete p;
     paquete_iniciar(&p);
 
     paquete_cargar_uint32(&p, query_id);
     paquete_cargar_uint32(&p, pc_actual);
+    paquete_cargar_uint32(&p, offset);
+    paquete_cargar_uint32(&p, version);
+    if (met) paquete_cargar_struct(&p, met, sizeof(*met));
 
-    int rc = enviar_paquete(fd_master, OP_DESALOJO_PRIORIDAD_OK, &p);
+    int rc = _enviar_a_master(fd_master, OP_DESALOJO_PRIORIDAD_OK, &p);
     paquete_destruir(&p);
     return rc;
 }
@@ -141,7 +283,7 @@ int master_enviar_desalojo_cancelacion_ok(int fd_master, uint32_t query_id, uint
     paquete_cargar_uint32(&p, query_id);
     paquete_cargar_uint32(&p, pc_actual);
 
-    int rc = enviar_paquete(fd_master, OP_DESALOJO_CANCELACION_OK, &p);
+    int rc = _enviar_a_master(fd_master, OP_DESALOJO_CANCELACION_OK, &p);
     paquete_destruir(&p);
     return rc;
 }
\ No newline at end of file
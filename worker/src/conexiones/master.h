@@ -5,20 +5,51 @@
 #include <commons/log.h>
 #include "../../utils/src/proto.h"   // opcodes, t_query_resultado
 
-// Abre conexión y hace handshake HELLO (devuelve fd o -1)
-int enviar_hello_worker(const char* ip_master, int puerto_master, t_log* logger, uint32_t worker_id);
+// Abre conexión y hace handshake HELLO (devuelve fd o -1).
+// slots: Queries que el Worker ejecuta a la vez
+int enviar_hello_worker(const char* ip_master, int puerto_master, t_log* logger, uint32_t worker_id, uint32_t slots);
 
-// Resultado de READ hacia Master
-int enviar_resultado_a_master(int fd_master, int query_id, const char* result_data, t_log* logger);
+// Resultado de READ hacia Master: payload = [u32 query_id][u32 offset][u32 len][bytes]
+// (offset = dirección lógica leída; los bytes van tal cual, pueden tener '\0')
+int enviar_resultado_a_master(int fd_master, uint32_t query_id, uint32_t offset,
+                              const void* datos, uint32_t len, t_log* logger);
 
-// END de Query hacia Master
-int enviar_end_a_master(int fd_master, uint32_t query_id, uint32_t pc_final, t_query_resultado estado, t_log* logger);
+// ---------------------------------------------------------------------------
+// Lote de lecturas (LOTE_LECTURAS_BYTES > 0)
+// Los READ de una Query se juntan y salen en un OP_READ_RESULT_LOTE:
+// payload = [u32 query_id][u32 cantidad] + cantidad x [u32 offset][u32 len][bytes]
+// Se manda al llegar a LOTE_LECTURAS_BYTES o al pasar LOTE_LECTURAS_MS desde
+// la primera lectura encolada, y siempre antes del END / ACK de desalojo.
+// ---------------------------------------------------------------------------
+typedef struct t_lote_lecturas t_lote_lecturas;
+
+void master_configurar_lote_lecturas(uint32_t max_bytes, uint32_t max_ms);
+
+// NULL si los lotes están deshabilitados (cada READ sale solo)
+t_lote_lecturas* lote_lecturas_crear(int fd_master, uint32_t query_id);
+// Mismo formato por el canal directo al QC (ver query_control.h). Siempre
+// crea el lote: con LOTE_LECTURAS_BYTES = 0 cada READ sale en uno propio
+t_lote_lecturas* lote_lecturas_crear_directo(int fd_qc, uint32_t query_id);
+int  lote_lecturas_agregar(t_lote_lecturas* lote, uint32_t offset, const void* datos, uint32_t len, t_log* logger);
+int  lote_lecturas_vencido(const t_lote_lecturas* lote);
+int  lote_lecturas_enviar(t_lote_lecturas* lote, t_log* logger);   // no hace nada si está vacío
+void lote_lecturas_destruir(t_lote_lecturas* lote);
+
+// END de Query hacia Master (met != NULL: agrega el resumen de memoria)
+int enviar_end_a_master(int fd_master, uint32_t query_id, uint32_t pc_final, t_query_resultado estado,
+                        const t_query_end_metricas* met, t_log* logger);
 
 // ACK de desalojo hacia Master: payload = [u32 query_id][u32 pc_actual]
 int master_enviar_desalojo_ok(int fd_master, uint32_t query_id, uint32_t pc_actual);
 
 int master_enviar_desalojo_ok(int fd_master, uint32_t query_id, uint32_t pc_actual);
-int master_enviar_desalojo_prioridad_ok(int fd_master, uint32_t query_id, uint32_t pc_actual);
+// Por prioridad la Query se retoma: payload = [u32 query_id][u32 pc_actual]
+// [u32 offset][u32 version] (offset del PC en el script, lo reenvía el Master
+// en la próxima ASIGNACION_QUERY) y, si met != NULL, el resumen de memoria del
+// tramo, que el Master suma para el QUERY_END
+int master_enviar_desalojo_prioridad_ok(int fd_master, uint32_t query_id, uint32_t pc_actual,
+                                        uint32_t offset, uint32_t version,
+                                        const t_query_end_metricas* met);
 int master_enviar_desalojo_cancelacion_ok(int fd_master, uint32_t query_id, uint32_t pc_actual);
 
 #endif // WORKER_MASTER_H
\ No newline at end of file
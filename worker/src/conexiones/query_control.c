@@ -0,0 +1,71 @@
+// ============================================================================
+// WORKER - query_control.c
+// PASO A PASO GENERAL
+// 1) Conectar al endpoint que mandó el Master y presentarse con el token
+// 2) Cerrar: OP_CANAL_FIN y esperar el OP_OK del QC (en corrutina se
+//    suspende mientras tanto, como con Storage)
+// ============================================================================
+
+#include "query_control.h"
+#include "../../../utils/src/proto.h"
+#include "../../../utils/src/net.h"
+#include "../query_interpreter/corrutinas.h"
+
+#include <poll.h>
+#include <stdio.h>
+#include <unistd.h>
+
+int query_control_abrir_canal(const t_canal_qc* canal, uint32_t query_id, t_log* logger) {
+    if (!canal || !canal->ip || canal->puerto == 0) return -1;
+
+    // 1) Conectar
+    char pstr[16];
+    snprintf(pstr, sizeof(pstr), "%u", canal->puerto);
+
+    int fd = conectar_a(canal->ip, pstr);
+    if (fd < 0) {
+        if (logger) log_warning(logger, "[QC] No pude abrir el canal directo %s:%s (Q=%u). Los READ van por el Master.",
+                                canal->ip, pstr, query_id);
+        return -1;
+    }
+
+    // 2) Presentarse: [u32 query_id][u32 token]
+    uint32_t hola[2] = { query_id, canal->token };
+    struct iovec parte = { .iov_base = hola, .iov_len = sizeof(hola) };
+
+    if (enviar_frame_iov(fd, OP_CANAL_RESULTADOS, &parte, 1) != 0) {
+        if (logger) log_warning(logger, "[QC] Error presentando el canal directo (Q=%u). Los READ van por el Master.",
+                                query_id);
+        close(fd);
+        return -1;
+    }
+
+    if (logger) log_info(logger, "[QC] Canal directo abierto con %s:%s (Q=%u)", canal->ip, pstr, query_id);
+    return fd;
+}
+
+int query_control_cerrar_canal(int* fd, uint32_t query_id, t_log* logger) {
+    if (!fd || *fd < 0) return 0;
+
+    // 1) Avisar que no hay más lecturas
+    struct iovec parte = { .iov_base = &query_id, .iov_len = sizeof(query_id) };
+    int rc = enviar_frame_iov(*fd, OP_CANAL_FIN, &parte, 1);
+
+    // 2) Esperar el OK: recién ahí el QC mostró todo lo que mandamos
+    uint16_t op  = 0;
+    uint32_t len = 0;
+    if (rc == 0) {
+        corrutina_esperar_fd(*fd, POLLIN);
+        rc = recibir_cabecera(*fd, &op, &len);
+        if (rc == 0 && len > 0) rc = recv_descartar(*fd, len);
+        if (rc == 0 && op != OP_OK) rc = -1;
+    }
+
+    if (rc != 0 && logger) {
+        log_error(logger, "[QC] El canal directo no confirmó el cierre (Q=%u)", query_id);
+    }
+
+    close(*fd);
+    *fd = -1;
+    return rc;
+}
@@ -0,0 +1,33 @@
+// ============================================================================
+// WORKER - query_control.h
+// PASO A PASO GENERAL
+// 1) Canal directo de resultados hacia el Query Control (opcional): el QC
+//    escucha, le pasa (puerto, token) al Master en el SUBMIT y el Master se
+//    los reenvía al Worker en la ASIGNACION_QUERY
+// 2) Al arrancar la Query el Worker se conecta y se presenta con
+//    OP_CANAL_RESULTADOS [query_id][token]
+// 3) Los READ salen por ahí como OP_READ_RESULT_LOTE (ver lote_lecturas en
+//    master.h); el Master queda solo para END y desalojos
+// 4) Antes del END / ACK de desalojo se cierra con OP_CANAL_FIN y se espera
+//    el OP_OK: el QC ya mostró todas las lecturas cuando le llega el END
+// ============================================================================
+
+#ifndef WORKER_QUERY_CONTROL_H
+#define WORKER_QUERY_CONTROL_H
+
+#include <stdint.h>
+#include <commons/log.h>
+
+typedef struct {
+    char*    ip;       // NULL = sin canal directo (los READ van por el Master)
+    uint32_t puerto;
+    uint32_t token;
+} t_canal_qc;
+
+// Devuelve el fd del canal o -1 (no hay canal o no se pudo abrir)
+int  query_control_abrir_canal(const t_canal_qc* canal, uint32_t query_id, t_log* logger);
+
+// Espera que el QC confirme que recibió todo y cierra. *fd queda en -1
+int  query_control_cerrar_canal(int* fd, uint32_t query_id, t_log* logger);
+
+#endif // WORKER_QUERY_CONTROL_H
@@ -6,17 +6,28 @@
 // 3) Envía pedidos a Storage y espera OK/ERROR
 // 4) Obtiene BLOCK_SIZE
 // 5) Ejecuta CREATE / TAG / TRUNCATE / COMMIT / DELETE
-// 6) Ejecuta READ_BLOCK y WRITE_BLOCK
+// 6) Ejecuta READ_BLOCK y WRITE_BLOCK (individual o en lote) sin t_paquete:
+//    el pedido se arma como iovec (el marco se manda directo desde memoria) y
+//    el bloque leído se recibe directo en el marco destino
+// 7) Suma bloques, bytes y latencia de cada transferencia a las métricas
+// 8) Antes de leer cada respuesta, una Query que corre en corrutina se
+//    suspende hasta que haya datos (ver corrutinas.c)
 // ============================================================================
 
 #include "storage.h"
 #include "../../../utils/src/proto.h"
 #include "../../../utils/src/paquete.h"
+#include "../../../utils/src/net.h"
+#include "../memoria_interna/memoria_metricas.h"
+#include "../query_interpreter/corrutinas.h"
 
+#include <poll.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <sys/uio.h>
 #include <commons/log.h>
 
 #define W_PATH_MAX M_MAX_PATH
@@ -57,6 +68,23 @@ typedef struct {
     uint32_t len;
 } t_write_req_net;
 
+typedef struct {
+    uint32_t query_id;
+    char     path[W_PATH_MAX];
+    uint32_t block_idx;
+    uint32_t offset;
+    uint32_t len;
+} t_write_partial_req_net;
+
+// Los pedidos de bloque se mandan por partes (ver _enviar_pedido_bloque):
+// el layout tiene que seguir siendo [query_id][path][campos u32...]
+_Static_assert(offsetof(t_read_req_net, block_idx) == sizeof(uint32_t) + W_PATH_MAX,
+               "t_read_req_net: layout inesperado");
+_Static_assert(offsetof(t_write_req_net, len) == sizeof(uint32_t) * 2 + W_PATH_MAX,
+               "t_write_req_net: layout inesperado");
+_Static_assert(offsetof(t_write_partial_req_net, len) == sizeof(uint32_t) * 3 + W_PATH_MAX,
+               "t_write_partial_req_net: layout inesperado");
+
 typedef struct __attribute__((__packed__)) {
     uint32_t query_id;
     char     path[W_PATH_MAX];
@@ -110,6 +138,8 @@ static int esperar_ok_error(int fd, t_log* logger, const char* ctx) {
     t_paquete resp;
     paquete_iniciar(&resp);
 
+    corrutina_esperar_fd(fd, POLLIN);   // en corrutina: otra Query usa el hilo mientras tanto
+
     if (recibir_paquete(fd, &op_resp, &resp) != 0) {
         if (logger) log_error(logger, "[STORAGE] %s: error recibiendo respuesta.", ctx);
         paquete_destruir(&resp);
@@ -140,6 +170,88 @@ static int esperar_ok_error(int fd, t_log* logger, const char* ctx) {
     return 0;
 }
 
+// Relleno del path de ancho fijo (se manda desde acá en lugar de memset)
+static const char g_ceros[W_PATH_MAX];
+
+// Pedido de bloque: [query_id][path + ceros hasta W_PATH_MAX][campos][datos]
+// en un solo writev, sin copiar los datos a un buffer intermedio
+static int _enviar_pedido_bloque(
+    int             fd,
+    uint16_t        op,
+    uint32_t        query_id,
+    file_tag_t      ft,
+    const uint32_t* campos,
+    int             cant_campos,
+    const char*     datos,
+    uint32_t        size
+) {
+    char path[W_PATH_MAX];
+    build_path(path, sizeof(path), ft);
+    size_t n = strlen(path);
+
+    struct iovec partes[5] = {
+        { .iov_base = &query_id,       .iov_len = sizeof(uint32_t) },
+        { .iov_base = path,            .iov_len = n },
+        { .iov_base = (void*)g_ceros,  .iov_len = W_PATH_MAX - n },
+        { .iov_base = (void*)campos,   .iov_len = sizeof(uint32_t) * (size_t)cant_campos },
+        { .iov_base = (void*)datos,    .iov_len = datos ? size : 0 }
+    };
+    return enviar_frame_iov(fd, op, partes, 5);
+}
+
+// Respuesta de READ_BLOCK: el payload va directo a 'destino'.
+// Devuelve 1 si llegó el bloque, 0 si Storage respondió otra cosa (payload
+// descartado) y -1 si se cortó la conexión.
+static int _recibir_bloque(int fd, char* destino, uint32_t max_bytes, uint16_t* op_out) {
+    uint16_t op  = 0;
+    uint32_t len = 0;
+
+    corrutina_esperar_fd(fd, POLLIN);
+    if (recibir_cabecera(fd, &op, &len) != 0) return -1;
+    *op_out = op;
+
+    if (op != OP_BLOCK_DATA || len < max_bytes) {
+        return recv_descartar(fd, len) == 0 ? 0 : -1;
+    }
+
+    if (recv_all(fd, destino, max_bytes) != 0) return -1;
+    if (recv_descartar(fd, len - max_bytes) != 0) return -1;
+    return 1;
+}
+
+// Métricas de bloques transferidos; en un lote la latencia de cada bloque es
+// el promedio del lote (los pedidos viajan encadenados)
+static void _contar_io(int escritura, uint32_t bloques, uint64_t bytes, uint64_t desde_us) {
+    if (bloques == 0) return;
+
+    uint64_t prom = (memoria_metricas_ahora_us() - desde_us) / bloques;
+    for (uint32_t i = 0; i < bloques; i++) {
+        memoria_metricas_latencia(escritura ? LAT_STORAGE_ESCRITURA : LAT_STORAGE_LECTURA, prom);
+    }
+    memoria_metricas_sumar(escritura ? MET_BLOQUES_ESCRITOS : MET_BLOQUES_LEIDOS, bloques);
+    memoria_metricas_sumar(escritura ? MET_BYTES_ESCRITOS : MET_BYTES_LEIDOS, bytes);
+}
+
+// WRITE_BLOCK o WRITE_PARTIAL, mandando 'origen' tal cual (puede ser el marco)
+static int _enviar_escritura(
+    int          fd,
+    uint32_t     query_id,
+    file_tag_t   ft,
+    uint32_t     block_id,
+    int          parcial,
+    uint32_t     offset,
+    const char*  origen,
+    uint32_t     size
+) {
+    if (parcial) {
+        uint32_t campos[3] = { block_id, offset, size };
+        return _enviar_pedido_bloque(fd, OP_WRITE_PARTIAL, query_id, ft, campos, 3, origen, size);
+    }
+
+    uint32_t campos[2] = { block_id, size };
+    return _enviar_pedido_bloque(fd, OP_WRITE_BLOCK, query_id, ft, campos, 2, origen, size);
+}
+
 // ---------------------------------------------------------------------------
 // GET BLOCK SIZE (HANDSHAKE)
 // ---------------------------------------------------------------------------
@@ -374,71 +486,91 @@ int storage_io_read_block(
     char*      destino,
     uint32_t   max_bytes
 ) {
-    char path[W_PATH_MAX];
-    build_path(path, sizeof(path), ft);
-
-    t_read_req_net req;
-    memset(&req, 0, sizeof(req));
-    req.query_id = g_worker_query_id;
-    strncpy(req.path, path, sizeof(req.path) - 1);
-    req.block_idx = block_id;
-
-    t_paquete p;
-    paquete_iniciar(&p);
-
-    if (paquete_cargar_struct(&p, &req, sizeof(req)) != 0) {
-        if (logger) log_error(logger, "[STORAGE] READ_BLOCK: error armando paquete.");
-        paquete_destruir(&p);
-        return 0;
-    }
+    uint64_t t0 = memoria_metricas_ahora_us();
 
-    if (enviar_paquete(fd_storage, OP_READ_BLOCK, &p) != 0) {
+    if (_enviar_pedido_bloque(fd_storage, OP_READ_BLOCK, g_worker_query_id, ft,
+                              &block_id, 1, NULL, 0) != 0) {
         if (logger) log_error(logger, "[STORAGE] READ_BLOCK: error enviando OP_READ_BLOCK.");
-        paquete_destruir(&p);
         return 0;
     }
-    paquete_destruir(&p);
 
     uint16_t op_resp = 0;
-    t_paquete resp;
-    paquete_iniciar(&resp);
+    int rc = _recibir_bloque(fd_storage, destino, max_bytes, &op_resp);
 
-    if (recibir_paquete(fd_storage, &op_resp, &resp) != 0) {
+    if (rc < 0) {
         if (logger) log_error(logger, "[STORAGE] READ_BLOCK: error recibiendo respuesta.");
-        paquete_destruir(&resp);
         return 0;
     }
 
-    if (op_resp == OP_ERROR) {
-        if (logger) log_error(logger, "[STORAGE] READ_BLOCK devolvió OP_ERROR.");
-        paquete_destruir(&resp);
-        return 0;
-    }
+    if (rc == 0) {
+        if (!logger) return 0;
 
-    if (op_resp != OP_BLOCK_DATA) {
-        if (logger) {
+        if (op_resp == OP_ERROR) {
+            log_error(logger, "[STORAGE] READ_BLOCK devolvió OP_ERROR.");
+        } else if (op_resp != OP_BLOCK_DATA) {
             log_error(
                 logger,
                 "[STORAGE] READ_BLOCK: opcode inesperado %hu (esperaba OP_BLOCK_DATA).",
                 op_resp
             );
+        } else {
+            log_error(logger, "[STORAGE] READ_BLOCK: error leyendo datos.");
         }
-        paquete_destruir(&resp);
         return 0;
     }
 
-    resp.offset = 0;
-    void* raw = paquete_leer_struct(&resp, max_bytes);
-    if (!raw) {
-        if (logger) log_error(logger, "[STORAGE] READ_BLOCK: error leyendo datos.");
-        paquete_destruir(&resp);
-        return 0;
+    _contar_io(0, 1, max_bytes, t0);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// READ BLOCK EN LOTE
+// ---------------------------------------------------------------------------
+int storage_io_read_blocks(
+    t_bloque_lectura* bloques,
+    int               cantidad,
+    int               fd_storage,
+    t_log*            logger
+) {
+    if (!bloques || cantidad <= 0) return 0;
+
+    uint64_t t0 = memoria_metricas_ahora_us();
+
+    // 1) Enviar todos los pedidos sin esperar respuesta
+    int enviados = 0;
+    for (int i = 0; i < cantidad; i++) {
+        t_bloque_lectura* b = &bloques[i];
+        b->ok = 0;
+
+        if (_enviar_pedido_bloque(fd_storage, OP_READ_BLOCK, b->query_id, b->ft,
+                                  &b->block_id, 1, NULL, 0) != 0) {
+            if (logger) log_error(logger, "[STORAGE] READ_BLOCK (lote): error enviando OP_READ_BLOCK.");
+            break;
+        }
+        enviados++;
     }
 
-    memcpy(destino, raw, max_bytes);
-    free(raw);
-    paquete_destruir(&resp);
-    return 1;
+    // 2) Recolectar las respuestas en el mismo orden de envío (cada bloque
+    //    se recibe directo en su destino)
+    int leidos = 0;
+    uint64_t bytes = 0;
+    for (int i = 0; i < enviados; i++) {
+        uint16_t op_resp = 0;
+        int rc = _recibir_bloque(fd_storage, bloques[i].destino, bloques[i].max_bytes, &op_resp);
+
+        if (rc < 0) {
+            if (logger) log_error(logger, "[STORAGE] READ_BLOCK (lote): error recibiendo respuesta.");
+            return -1;
+        }
+        if (rc == 1) {
+            bloques[i].ok = 1;
+            leidos++;
+            bytes += bloques[i].max_bytes;
+        }
+    }
+
+    _contar_io(0, (uint32_t)leidos, bytes, t0);
+    return (enviados < cantidad) ? -1 : leidos;
 }
 
 // ---------------------------------------------------------------------------
@@ -452,39 +584,99 @@ int storage_io_write_block(
     int          fd_storage,
     t_log*       logger
 ) {
-    char path[W_PATH_MAX];
-    build_path(path, sizeof(path), ft);
+    uint64_t t0 = memoria_metricas_ahora_us();
 
-    t_write_req_net req;
-    memset(&req, 0, sizeof(req));
-    req.query_id = g_worker_query_id;
-    strncpy(req.path, path, sizeof(req.path) - 1);
-    req.block_idx = block_id;
-    req.len       = size;
+    if (_enviar_escritura(fd_storage, g_worker_query_id, ft, block_id, 0, 0, origen, size) != 0) {
+        if (logger) log_error(logger, "[STORAGE] WRITE_BLOCK: error enviando OP_WRITE_BLOCK.");
+        return 0;
+    }
 
-    t_paquete p;
-    paquete_iniciar(&p);
+    int ok = esperar_ok_error(fd_storage, logger, "WRITE_BLOCK");
+    if (ok == 1) _contar_io(1, 1, size, t0);
+    return ok;
+}
 
-    if (paquete_cargar_struct(&p, &req, sizeof(req)) != 0) {
-        if (logger) log_error(logger, "[STORAGE] WRITE_BLOCK: error armando cabecera.");
-        paquete_destruir(&p);
+// ---------------------------------------------------------------------------
+// WRITE PARTIAL: solo el rango modificado; Storage lo combina con el bloque
+// ---------------------------------------------------------------------------
+int storage_io_write_partial(
+    file_tag_t   ft,
+    uint32_t     block_id,
+    uint32_t     offset,
+    const char*  origen,
+    uint32_t     size,
+    int          fd_storage,
+    t_log*       logger
+) {
+    uint64_t t0 = memoria_metricas_ahora_us();
+
+    if (_enviar_escritura(fd_storage, g_worker_query_id, ft, block_id, 1, offset, origen, size) != 0) {
+        if (logger) log_error(logger, "[STORAGE] WRITE_PARTIAL: error enviando OP_WRITE_PARTIAL.");
         return 0;
     }
 
-    if (size > 0) {
-        if (paquete_cargar_datos(&p, origen, size) != 0) {
-            if (logger) log_error(logger, "[STORAGE] WRITE_BLOCK: error cargando datos.");
-            paquete_destruir(&p);
-            return 0;
+    int ok = esperar_ok_error(fd_storage, logger, "WRITE_PARTIAL");
+    if (ok == 1) _contar_io(1, 1, size, t0);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// WRITE BLOCK EN LOTE
+// ---------------------------------------------------------------------------
+int storage_io_write_blocks(
+    t_bloque_escritura* bloques,
+    int                 cantidad,
+    int                 fd_storage,
+    t_log*              logger
+) {
+    if (!bloques || cantidad <= 0) return 0;
+
+    uint64_t t0 = memoria_metricas_ahora_us();
+
+    // 1) Enviar todos los pedidos sin esperar respuesta
+    int enviados = 0;
+    for (int i = 0; i < cantidad; i++) {
+        t_bloque_escritura* b = &bloques[i];
+        b->ok = 0;
+
+        if (_enviar_escritura(fd_storage, b->query_id, b->ft, b->block_id, b->parcial,
+                              b->offset, b->origen, b->size) != 0) {
+            if (logger) log_error(logger, "[STORAGE] WRITE_BLOCK (lote): error enviando pedido de escritura.");
+            break;
         }
+        enviados++;
     }
 
-    if (enviar_paquete(fd_storage, OP_WRITE_BLOCK, &p) != 0) {
-        if (logger) log_error(logger, "[STORAGE] WRITE_BLOCK: error enviando OP_WRITE_BLOCK.");
-        paquete_destruir(&p);
-        return 0;
+    // 2) Recolectar las respuestas en el mismo orden de envío
+    int confirmados = 0;
+    uint64_t bytes = 0;
+    for (int i = 0; i < enviados; i++) {
+        uint16_t op_resp = 0;
+        t_paquete resp;
+        paquete_iniciar(&resp);
+
+        corrutina_esperar_fd(fd_storage, POLLIN);
+        if (recibir_paquete(fd_storage, &op_resp, &resp) != 0) {
+            if (logger) log_error(logger, "[STORAGE] WRITE_BLOCK (lote): error recibiendo respuesta.");
+            paquete_destruir(&resp);
+            return -1;
+        }
+
+        if (op_resp == OP_OK) {
+            bloques[i].ok = 1;
+            confirmados++;
+            bytes += bloques[i].size;
+        } else if (logger) {
+            log_error(
+                logger,
+                "[STORAGE] WRITE_BLOCK (lote) bloque %u devolvió opcode %hu.",
+                bloques[i].block_id,
+                op_resp
+            );
+        }
+        paquete_destruir(&resp);
     }
-    paquete_destruir(&p);
 
-    return esperar_ok_error(fd_storage, logger, "WRITE_BLOCK");
+    _contar_io(1, (uint32_t)confirmados, bytes, t0);
+    return (enviados < cantidad) ? -1 : confirmados;
 }
@@ -64,4 +64,61 @@ int storage_io_write_block(
     t_log*       logger
 );
 
+// Escribe solo el rango [offset, offset+size) del bloque (OP_WRITE_PARTIAL).
+// Storage combina el rango con el contenido actual del bloque.
+int storage_io_write_partial(
+    file_tag_t   ft,
+    uint32_t     block_id,
+    uint32_t     offset,
+    const char*  origen,
+    uint32_t     size,
+    int          fd_storage,
+    t_log*       logger
+);
+
+// ---------------------------------------------------------------------------
+// Lectura en lote: mismo esquema que la escritura en lote. Un OP_ERROR en un
+// bloque (ej: fuera del tamaño del archivo) no corta el lote.
+// ---------------------------------------------------------------------------
+typedef struct {
+    file_tag_t  ft;
+    uint32_t    block_id;
+    uint32_t    query_id;
+    char*       destino;
+    uint32_t    max_bytes;
+    int         ok;         // salida: 1 si llegó OP_BLOCK_DATA completo
+} t_bloque_lectura;
+
+// Devuelve la cantidad de bloques leídos, o -1 si se cortó la conexión.
+int storage_io_read_blocks(
+    t_bloque_lectura* bloques,
+    int               cantidad,
+    int               fd_storage,
+    t_log*            logger
+);
+
+// ---------------------------------------------------------------------------
+// Escritura en lote: se envían todos los WRITE_BLOCK seguidos y después se
+// esperan las respuestas en el mismo orden (Storage responde en orden por
+// conexión). Cada bloque lleva su propio query_id.
+// ---------------------------------------------------------------------------
+typedef struct {
+    file_tag_t  ft;
+    uint32_t    block_id;
+    uint32_t    query_id;
+    const char* origen;
+    uint32_t    size;
+    uint8_t     parcial;    // 1 = OP_WRITE_PARTIAL de [offset, offset+size)
+    uint32_t    offset;
+    int         ok;         // salida: 1 si Storage respondió OP_OK
+} t_bloque_escritura;
+
+// Devuelve la cantidad de bloques confirmados, o -1 si se cortó la conexión.
+int storage_io_write_blocks(
+    t_bloque_escritura* bloques,
+    int                 cantidad,
+    int                 fd_storage,
+    t_log*              logger
+);
+
 #endif // WORKER_STORAGE_H
\ No newline at end of file
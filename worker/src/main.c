@@ -3,6 +3,8 @@
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
 
 #include <commons/log.h>
 #include <commons/config.h>
@@ -14,17 +16,27 @@
 #include "conexiones/master.h"
 #include "conexiones/storage.h"
 #include "memoria_interna/memoria_interna.h"
-#include "query_interpreter/query_interpreter.h"
+#include "memoria_interna/memoria_writeback.h"
+#include "memoria_interna/memoria_retardo.h"
+#include "memoria_interna/memoria_metricas.h"
+#include "memoria_interna/memoria_compartida.h"
+#include "query_interpreter/query_slots.h"
+#include "query_interpreter/query_programa.h"
 
 // ============================================================================
 // WORKER - main.c
 // PASO A PASO GENERAL
 // 1) Configuración inicial y lectura de config
 // 2) Conexión a Storage y handshake de BLOCK_SIZE
-// 3) Inicialización de memoria interna
-// 4) Conexión a Master (HELLO_WORKER)
-// 5) Loop principal: recibir mensajes del Master (asignación / desalojo)
-// 6) Liberación ordenada de recursos al finalizar
+// 3) Inicialización de memoria interna (+ writeback en segundo plano y
+//    endpoint de métricas)
+// 4) Slots de ejecución (SLOTS_EJECUCION hilos, cada uno con
+//    CORRUTINAS_POR_SLOT Queries que se turnan mientras esperan I/O) y
+//    lotes de lecturas hacia el Master (LOTE_LECTURAS_BYTES / _MS)
+// 5) Conexión a Master (HELLO_WORKER con la cantidad de slots)
+// 6) Loop principal: recibir mensajes del Master y despacharlos a los slots
+//    (asignación / desalojo)
+// 7) Liberación ordenada de recursos al finalizar
 // ============================================================================
 
 // ----------------- Globals -----------------
@@ -37,6 +49,7 @@ static void sig_handler(int sig) {
     (void)sig;
 
     memoria_flush_global();
+    memoria_compartida_desconectar();
 
     if (g_logger) log_info(g_logger, "Signal recibida. Cerrando Worker…");
     if (g_fd_master  >= 0) close(g_fd_master);
@@ -82,6 +95,34 @@ static int cfg_get_int_chk(t_config* cfg, const char* key, const char* nombre_cf
     return 0;
 }
 
+// Tamaños en bytes: no entran en un int (TAM_MEMORIA de más de 2 GB)
+static int cfg_get_size_chk(t_config* cfg, const char* key, const char* nombre_cfg, size_t* out) {
+    const char* s = cfg_get_str(cfg, key, nombre_cfg);
+    if (!s) return -1;
+    char* end = NULL;
+    errno = 0;
+    unsigned long long val = strtoull(s, &end, 10);
+    if (end == s || *end != '\0' || s[0] == '-' || errno == ERANGE || val > SIZE_MAX) {
+        fprintf(stderr, "[CFG] Clave '%s' debe ser un tamaño en bytes válido (valor: '%s')\n", key, s);
+        return -1;
+    }
+    *out = (size_t)val;
+    return 0;
+}
+
+// Clave opcional: si no está en el archivo se usa el valor por defecto
+static int cfg_get_int_opt(t_config* cfg, const char* key, const char* nombre_cfg, int def, int* out) {
+    *out = def;
+    if (!config_has_property(cfg, (char*) key)) return 0;
+    return cfg_get_int_chk(cfg, key, nombre_cfg, out);
+}
+
+static const char* cfg_get_str_opt(t_config* cfg, const char* key, const char* def) {
+    if (!config_has_property(cfg, (char*) key)) return def;
+    const char* v = config_get_string_value(cfg, (char*) key);
+    return v ? v : def;
+}
+
 // ----------------- Lectores de payload -----------------
 static int leer_u32(const t_paquete* p, size_t* off, uint32_t* out) {
     if (!p || !out || !off) return -1;
@@ -151,14 +192,47 @@ int main(int argc, char** argv) {
     const char* puerto_storage_s = cfg_get_str(cfg, "PUERTO_STORAGE", ruta_cfg);
     const char* algoritmo_rep    = cfg_get_str(cfg, "ALGORITMO_REEMPLAZO", ruta_cfg);
     const char* path_scripts     = cfg_get_str(cfg, "PATH_SCRIPTS", ruta_cfg);
+    const char* asignador_mem    = cfg_get_str_opt(cfg, "MEMORIA_ASIGNADOR", "MALLOC");
+    const char* retardo_modo     = cfg_get_str_opt(cfg, "RETARDO_MODO", "SIMULADO");
+    const char* stats_socket     = cfg_get_str_opt(cfg, "STATS_SOCKET", "");
+    const char* mem_compartida   = cfg_get_str_opt(cfg, "MEMORIA_COMPARTIDA", "");
+    const char* traza_paginas    = cfg_get_str_opt(cfg, "TRAZA_PAGINAS", "");
 
-    int tam_memoria    = 0;
+    size_t tam_memoria = 0;
     int retardo_mem_ms = 0;
+    int wb_intervalo = 0, wb_ratio = 0, wb_edad = 0, wb_lote = 0;
+    int ra_max = 0, ra_precision = 0;
+    int nodo_numa = -1;
+    int escritura_parcial = 0;
+    int compartir_tag = 1;
+    int dedup_bloques = 0;
+    int traza_eventos = 0;
+    int compartida_bloques = 0;
+    int slots_ejecucion = 1;
+    int corrutinas_por_slot = 1;
+    int lote_lecturas_bytes = 0;
+    int lote_lecturas_ms    = 50;
 
     if (!ip_master || !puerto_master_s || !ip_storage || !puerto_storage_s ||
         !algoritmo_rep || !path_scripts ||
-        cfg_get_int_chk(cfg, "TAM_MEMORIA",     ruta_cfg, &tam_memoria) ||
-        cfg_get_int_chk(cfg, "RETARDO_MEMORIA", ruta_cfg, &retardo_mem_ms)) {
+        cfg_get_size_chk(cfg, "TAM_MEMORIA",    ruta_cfg, &tam_memoria) ||
+        cfg_get_int_chk(cfg, "RETARDO_MEMORIA", ruta_cfg, &retardo_mem_ms) ||
+        cfg_get_int_opt(cfg, "WRITEBACK_INTERVALO_MS", ruta_cfg, 0,  &wb_intervalo) ||
+        cfg_get_int_opt(cfg, "WRITEBACK_RATIO_DIRTY",  ruta_cfg, 50, &wb_ratio) ||
+        cfg_get_int_opt(cfg, "WRITEBACK_EDAD_MS",      ruta_cfg, 0,  &wb_edad) ||
+        cfg_get_int_opt(cfg, "WRITEBACK_LOTE",         ruta_cfg, 4,  &wb_lote) ||
+        cfg_get_int_opt(cfg, "READAHEAD_MAX_PAGINAS",  ruta_cfg, 0,  &ra_max) ||
+        cfg_get_int_opt(cfg, "READAHEAD_PRECISION_MIN", ruta_cfg, 50, &ra_precision) ||
+        cfg_get_int_opt(cfg, "MEMORIA_NODO_NUMA",      ruta_cfg, -1, &nodo_numa) ||
+        cfg_get_int_opt(cfg, "ESCRITURA_PARCIAL",      ruta_cfg, 0,  &escritura_parcial) ||
+        cfg_get_int_opt(cfg, "COMPARTIR_TAG",          ruta_cfg, 1,  &compartir_tag) ||
+        cfg_get_int_opt(cfg, "DEDUP_BLOQUES",          ruta_cfg, 0,  &dedup_bloques) ||
+        cfg_get_int_opt(cfg, "TRAZA_EVENTOS",          ruta_cfg, 1024, &traza_eventos) ||
+        cfg_get_int_opt(cfg, "MEMORIA_COMPARTIDA_BLOQUES", ruta_cfg, 1024, &compartida_bloques) ||
+        cfg_get_int_opt(cfg, "SLOTS_EJECUCION",        ruta_cfg, 1,  &slots_ejecucion) ||
+        cfg_get_int_opt(cfg, "CORRUTINAS_POR_SLOT",    ruta_cfg, 1,  &corrutinas_por_slot) ||
+        cfg_get_int_opt(cfg, "LOTE_LECTURAS_BYTES",    ruta_cfg, 0,  &lote_lecturas_bytes) ||
+        cfg_get_int_opt(cfg, "LOTE_LECTURAS_MS",       ruta_cfg, 50, &lote_lecturas_ms)) {
         log_error(g_logger, "Config incompleta/incorrecta. Revisá %s", ruta_cfg);
         config_destroy(cfg);
         log_destroy(g_logger);
@@ -188,7 +262,12 @@ int main(int argc, char** argv) {
     log_info(g_logger, "Storage OK. block_size=%u", block_size);
 
     // 4) Inicializar memoria interna
-    if (!memoria_init((uint32_t)tam_memoria, block_size, algoritmo_rep, g_logger)) {
+    memoria_configurar_asignador(asignador_mem, nodo_numa);
+    memoria_configurar_traza((uint32_t)(traza_eventos > 0 ? traza_eventos : 0), traza_paginas);
+    memoria_configurar_dedup(dedup_bloques);
+    memoria_configurar_compartida(mem_compartida,
+                                  (uint32_t)(compartida_bloques > 0 ? compartida_bloques : 0));
+    if (!memoria_init(tam_memoria, block_size, algoritmo_rep, g_logger)) {
         log_error(g_logger, "memoria_init falló");
         close(g_fd_storage);
         config_destroy(cfg);
@@ -196,31 +275,85 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    // 5) Conectar a Master y enviar HELLO_WORKER
+    memoria_configurar_readahead((uint32_t)(ra_max > 0 ? ra_max : 0),
+                                 (uint32_t)(ra_precision > 0 ? ra_precision : 0));
+    memoria_configurar_escritura_parcial(escritura_parcial);
+    memoria_configurar_compartir_tag(compartir_tag);
+    memoria_retardo_configurar(retardo_modo, g_logger);
+
+    t_writeback_cfg wb_cfg = {
+        .intervalo_ms = (uint32_t)(wb_intervalo > 0 ? wb_intervalo : 0),
+        .ratio_dirty  = (uint32_t)(wb_ratio     > 0 ? wb_ratio     : 0),
+        .edad_ms      = (uint32_t)(wb_edad      > 0 ? wb_edad      : 0),
+        .lote         = (uint32_t)(wb_lote      > 0 ? wb_lote      : 0)
+    };
+    if (!memoria_writeback_iniciar(ip_storage, puerto_storage_s, &wb_cfg, g_logger)) {
+        log_warning(g_logger, "Writeback en segundo plano no disponible. Sigo sin flusher.");
+    }
+
+    memoria_metricas_servir(stats_socket, worker_id, g_logger);
+
+    // 5) Validar el puerto del Master
     char* endpm = NULL;
     long pm = strtol(puerto_master_s, &endpm, 10);
     if (endpm == puerto_master_s || *endpm != '\0' || pm <= 0 || pm > 65535) {
         log_error(g_logger, "PUERTO_MASTER inválido: '%s'", puerto_master_s);
         close(g_fd_storage);
+        memoria_metricas_detener();
+        memoria_writeback_detener();
+        memoria_destroy();
+        config_destroy(cfg);
+        log_destroy(g_logger);
+        return 1;
+    }
+
+    // 6) Lecturas en lote hacia el Master (LOTE_LECTURAS_BYTES = 0: un
+    //    READ_RESULT por READ, como siempre)
+    master_configurar_lote_lecturas((uint32_t)(lote_lecturas_bytes > 0 ? lote_lecturas_bytes : 0),
+                                    (uint32_t)(lote_lecturas_ms    > 0 ? lote_lecturas_ms    : 0));
+
+    // 7) Slots de ejecución (cada uno con su conexión a Storage, salvo el
+    //    primero que usa g_fd_storage) y HELLO_WORKER con cuántos quedaron
+    uint32_t slots = slots_iniciar(
+        (uint32_t)(slots_ejecucion > 0 ? slots_ejecucion : 1),
+        (uint32_t)(corrutinas_por_slot > 0 ? corrutinas_por_slot : 1),
+        g_fd_storage,
+        ip_storage,
+        puerto_storage_s,
+        path_scripts,
+        (uint32_t)retardo_mem_ms,
+        g_logger
+    );
+    if (slots == 0) {
+        log_error(g_logger, "No pude iniciar los slots de ejecución");
+        close(g_fd_storage);
+        memoria_metricas_detener();
+        memoria_writeback_detener();
         memoria_destroy();
         config_destroy(cfg);
         log_destroy(g_logger);
         return 1;
     }
 
-    g_fd_master = enviar_hello_worker(ip_master, (int)pm, g_logger, worker_id);
+    g_fd_master = enviar_hello_worker(ip_master, (int)pm, g_logger, worker_id, slots);
     if (g_fd_master < 0) {
         log_error(g_logger, "No pude conectar/enviar HELLO a Master %s:%s", ip_master, puerto_master_s);
+        slots_detener();
         close(g_fd_storage);
+        memoria_metricas_detener();
+        memoria_writeback_detener();
         memoria_destroy();
         config_destroy(cfg);
         log_destroy(g_logger);
         return 1;
     }
 
+    slots_set_fd_master(g_fd_master);
+
     log_info(g_logger, "Worker %u listo. Esperando asignaciones…", worker_id);
 
-    // 6) Loop principal de mensajes desde Master
+    // 8) Loop principal de mensajes desde Master: solo despacha, la Query
+    //    corre en un slot
     while (1) {
         uint16_t op = 0;
         t_paquete p_rx;
@@ -235,14 +368,29 @@ int main(int argc, char** argv) {
 
         if (op == OP_ASIGNACION_QUERY) {
             // payload: [u32 query_id][cstring filename][u32 pc_inicial]
-            size_t   off = 0;
-            uint32_t query_id = 0, pc_ini = 0;
-            char*    filename = NULL;
+            //          [u32 offset][u32 version] (opcional: Query desalojada)
+            //          [u32 puerto][u32 token][cstring ip] (opcional: canal
+            //          directo de resultados al QC)
+            size_t     off = 0;
+            uint32_t   query_id = 0, pc_ini = 0, offset_ini = 0, version = 0;
+            char*      filename = NULL;
+            t_canal_qc canal_qc = { 0 };
 
             int ok = (leer_u32(&p_rx, &off, &query_id) == 0) &&
                      (leer_cstring_nt(&p_rx, &off, &filename) == 0) &&
                      (leer_u32(&p_rx, &off, &pc_ini) == 0);
 
+            if (ok && off + 2 * sizeof(uint32_t) <= p_rx.buffer.size) {
+                ok = (leer_u32(&p_rx, &off, &offset_ini) == 0) &&
+                     (leer_u32(&p_rx, &off, &version) == 0);
+            }
+
+            if (ok && off + 2 * sizeof(uint32_t) < p_rx.buffer.size) {
+                ok = (leer_u32(&p_rx, &off, &canal_qc.puerto) == 0) &&
+                     (leer_u32(&p_rx, &off, &canal_qc.token) == 0) &&
+                     (leer_cstring_nt(&p_rx, &off, &canal_qc.ip) == 0);
+            }
+
             if (!ok) {
                 log_error(
                     g_logger,
@@ -251,6 +399,7 @@ int main(int argc, char** argv) {
                 );
                 paquete_destruir(&p_rx);
                 if (filename) free(filename);
+                free(canal_qc.ip);
                 continue;
             }
 
@@ -262,26 +411,23 @@ int main(int argc, char** argv) {
                 pc_ini
             );
 
-            int exec_ok = ejecutar_query(
-                query_id,
-                path_scripts,
-                filename,
-                pc_ini,
-                g_logger,
-                g_fd_storage,
-                g_fd_master,
-                (uint32_t)retardo_mem_ms
-            );
+            slots_asignar(query_id, filename, pc_ini, offset_ini, version, canal_qc);   // el slot libera filename y canal_qc.ip
+        }
 
-            if (!exec_ok) {
-                log_error(
+        else if (op == OP_DESALOJO_QUERY || op == OP_DESALOJO_POR_CANCELACION) {
+            // payload: [u32 query_id]. El slot flushea y responde el ACK
+            size_t   off = 0;
+            uint32_t query_id = 0;
+
+            if (leer_u32(&p_rx, &off, &query_id) != 0) {
+                log_error(g_logger, "DESALOJO: payload inválido (len=%u).", p_rx.buffer.size);
+            } else if (!slots_desalojar(query_id, op)) {
+                log_warning(
                     g_logger,
-                    "Fallo ejecutando Query %u.",
+                    "Recibí DESALOJO para Query %u pero no la estoy ejecutando. Ignoro.",
                     query_id
                 );
             }
-
-            free(filename);
         }
 
         else {
@@ -296,10 +442,15 @@ int main(int argc, char** argv) {
         paquete_destruir(&p_rx);
     }
 
-    // 7) Salida ordenada
+    // 9) Salida ordenada (las Queries en curso terminan antes de liberar memoria)
+    slots_detener();
+    programa_cache_destruir();
+
     if (g_fd_master  >= 0) close(g_fd_master);
     if (g_fd_storage >= 0) close(g_fd_storage);
 
+    memoria_metricas_detener();
+    memoria_writeback_detener();
     memoria_destroy();
     config_destroy(cfg);
 
@@ -0,0 +1,269 @@
+// ============================================================================
+// WORKER - memoria_arc.c
+// PASO A PASO GENERAL
+// 1) Mantiene 4 listas LRU: T1/T2 (residentes) y B1/B2 (fantasmas)
+//    - T1: páginas vistas una sola vez desde que entraron
+//    - T2: páginas con más de un acceso (las "calientes")
+//    - B1/B2: páginas recién desalojadas de T1/T2 (sin marco, solo historia)
+// 2) Ajusta el objetivo 'p' (tamaño deseado de T1) según en qué lista
+//    fantasma aparece un miss: B1 agranda T1, B2 lo achica
+// 3) Elige víctima del LRU de T1 o T2 según 'p'
+// 4) Una página traída por adelantado (read-ahead / lote) entra a T1 marcada:
+//    su primer acceso de demanda cuenta como el insert, no como un hit, así
+//    un scan con read-ahead no llena T2
+// 5) Las ETP fantasma (B1/B2) no se recolectan al terminar su Query: la
+//    historia sobrevive hasta que _acotar_historia la descarta (ver retiene)
+// Todas las operaciones son O(1): los nodos cuelgan de cada ETP.
+// ============================================================================
+
+#include "memoria_arc.h"
+#include <stdlib.h>
+
+typedef enum {
+    ARC_NINGUNA = 0,
+    ARC_T1,
+    ARC_T2,
+    ARC_B1,
+    ARC_B2,
+    ARC_CANT_LISTAS
+} t_arc_lista_id;
+
+typedef struct t_arc_nodo {
+    t_etp*             etp;
+    struct t_arc_nodo* prev;   // hacia el LRU
+    struct t_arc_nodo* next;   // hacia el MRU
+    t_arc_lista_id     lista;
+    uint8_t            anticipada;   // entró por prefetch y nadie la pidió todavía
+    t_arc_lista_id     origen;       // dónde estaba antes del prefetch (B1/B2/ninguna)
+} t_arc_nodo;
+
+typedef struct {
+    t_arc_nodo* lru;
+    t_arc_nodo* mru;
+    uint32_t    tam;
+} t_arc_lista;
+
+static t_arc_lista g_listas[ARC_CANT_LISTAS];   // indexadas por t_arc_lista_id
+static uint32_t    g_c = 0;         // cantidad de marcos
+static uint32_t    g_p = 0;         // tamaño objetivo de T1
+
+// ---------------------------------------------------------------------------
+// Helpers de listas
+// ---------------------------------------------------------------------------
+static t_arc_nodo* _nodo(t_etp* etp) {
+    if (!etp->pol_nodo) {
+        t_arc_nodo* n = calloc(1, sizeof(t_arc_nodo));
+        n->etp        = etp;
+        n->lista      = ARC_NINGUNA;
+        etp->pol_nodo = n;
+    }
+    return (t_arc_nodo*)etp->pol_nodo;
+}
+
+static void _desenlazar(t_arc_nodo* n) {
+    if (n->lista == ARC_NINGUNA || n->lista >= ARC_CANT_LISTAS) return;
+
+    t_arc_lista* l = &g_listas[n->lista];
+    if (n->prev) n->prev->next = n->next; else l->lru = n->next;
+    if (n->next) n->next->prev = n->prev; else l->mru = n->prev;
+    l->tam--;
+
+    n->prev  = NULL;
+    n->next  = NULL;
+    n->lista = ARC_NINGUNA;
+}
+
+static void _enlazar_mru(t_arc_nodo* n, t_arc_lista_id id) {
+    _desenlazar(n);
+
+    t_arc_lista* l = &g_listas[id];
+    n->prev = l->mru;
+    n->next = NULL;
+    if (l->mru) l->mru->next = n; else l->lru = n;
+    l->mru = n;
+    l->tam++;
+    n->lista = id;
+}
+
+static void _descartar_lru(t_arc_lista_id id) {
+    t_arc_nodo* n = g_listas[id].lru;
+    if (n) _desenlazar(n);
+}
+
+// ---------------------------------------------------------------------------
+// Init
+// ---------------------------------------------------------------------------
+static void _arc_init(uint32_t cant_marcos) {
+    // Los nodos viven en las ETP: acá solo se reinician las cabeceras
+    for (int i = 0; i < ARC_CANT_LISTAS; i++) {
+        g_listas[i].lru = NULL;
+        g_listas[i].mru = NULL;
+        g_listas[i].tam = 0;
+    }
+    g_c = cant_marcos;
+    g_p = 0;
+}
+
+static void _arc_destroy(void) {
+    _arc_init(0);
+}
+
+// ---------------------------------------------------------------------------
+// Alta en T1/T2 según de qué lista viene (la parte "miss" de ARC)
+// ---------------------------------------------------------------------------
+static void _acotar_historia(void) {
+    // |T1|+|B1| <= c y total <= 2c
+    if (g_listas[ARC_T1].tam + g_listas[ARC_B1].tam > g_c) {
+        _descartar_lru(ARC_B1);
+    }
+    uint32_t total = g_listas[ARC_T1].tam + g_listas[ARC_T2].tam +
+                     g_listas[ARC_B1].tam + g_listas[ARC_B2].tam;
+    if (total > 2 * g_c) {
+        _descartar_lru(g_listas[ARC_B2].tam > 0 ? ARC_B2 : ARC_B1);
+    }
+}
+
+static void _insertar(t_arc_nodo* n, t_arc_lista_id origen) {
+    // 1) Miss en B1: T1 se quedó corto -> agrandar p
+    if (origen == ARC_B1) {
+        uint32_t b1 = g_listas[ARC_B1].tam;
+        uint32_t b2 = g_listas[ARC_B2].tam;
+        uint32_t delta = (b1 == 0 || b1 >= b2) ? 1 : b2 / b1;
+        g_p = (g_p + delta > g_c) ? g_c : g_p + delta;
+        _enlazar_mru(n, ARC_T2);
+        return;
+    }
+
+    // 2) Miss en B2: las frecuentes necesitan lugar -> achicar p
+    if (origen == ARC_B2) {
+        uint32_t b1 = g_listas[ARC_B1].tam;
+        uint32_t b2 = g_listas[ARC_B2].tam;
+        uint32_t delta = (b2 == 0 || b2 >= b1) ? 1 : b1 / b2;
+        g_p = (g_p > delta) ? g_p - delta : 0;
+        _enlazar_mru(n, ARC_T2);
+        return;
+    }
+
+    // 3) Página nueva: entra a T1
+    _enlazar_mru(n, ARC_T1);
+    _acotar_historia();
+}
+
+// ---------------------------------------------------------------------------
+// Hit: T1 o T2 -> MRU de T2
+// ---------------------------------------------------------------------------
+static void _arc_on_access(t_etp* etp) {
+    if (!etp) return;
+
+    t_arc_nodo* n = _nodo(etp);
+
+    // Primer acceso de una prefetcheada: recién ahora "entra" de verdad
+    if (n->anticipada) {
+        n->anticipada = 0;
+        _insertar(n, n->origen);
+        return;
+    }
+
+    if (n->lista == ARC_T1 || n->lista == ARC_T2) {
+        _enlazar_mru(n, ARC_T2);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Page-in
+// ---------------------------------------------------------------------------
+static void _arc_on_insert(t_etp* etp, int es_prefetch) {
+    if (!etp) return;
+
+    t_arc_nodo* n = _nodo(etp);
+
+    // Ya residente por algún camino raro: nada que hacer
+    if (n->lista == ARC_T1 || n->lista == ARC_T2) return;
+
+    // Prefetch: espera en T1 sin adaptar 'p'; la decisión queda para el
+    // primer acceso de demanda (se recuerda si era fantasma)
+    if (es_prefetch) {
+        n->anticipada = 1;
+        n->origen     = n->lista;
+        _enlazar_mru(n, ARC_T1);
+        _acotar_historia();
+        return;
+    }
+
+    _insertar(n, n->lista);
+}
+
+// ---------------------------------------------------------------------------
+// Baja de una página residente
+// ---------------------------------------------------------------------------
+static void _arc_on_remove(t_etp* etp, int por_reemplazo) {
+    if (!etp || !etp->pol_nodo) return;
+
+    t_arc_nodo* n = (t_arc_nodo*)etp->pol_nodo;
+
+    // Una prefetcheada que nadie pidió no deja historia: no es evidencia de
+    // que T1 necesite más lugar
+    int sin_uso   = n->anticipada;
+    n->anticipada = 0;
+
+    if (!por_reemplazo || sin_uso) {
+        _desenlazar(n);
+        return;
+    }
+
+    if (n->lista == ARC_T1) {
+        _enlazar_mru(n, ARC_B1);
+    } else if (n->lista == ARC_T2) {
+        _enlazar_mru(n, ARC_B2);
+    }
+}
+
+static void _arc_on_forget(t_etp* etp) {
+    if (!etp || !etp->pol_nodo) return;
+
+    t_arc_nodo* n = (t_arc_nodo*)etp->pol_nodo;
+    _desenlazar(n);
+    free(n);
+    etp->pol_nodo = NULL;
+}
+
+// Un fantasma es historia que todavía cuenta para adaptar 'p'; la cantidad
+// está acotada por _acotar_historia (T1+T2+B1+B2 <= 2c)
+static int _arc_retiene(const t_etp* etp) {
+    const t_arc_nodo* n = etp ? (const t_arc_nodo*)etp->pol_nodo : NULL;
+    return n && (n->lista == ARC_B1 || n->lista == ARC_B2);
+}
+
+// ---------------------------------------------------------------------------
+// Selección de víctima (REPLACE de ARC)
+// ---------------------------------------------------------------------------
+static int _arc_pick_victim(t_etp* entrante) {
+    t_arc_lista* t1 = &g_listas[ARC_T1];
+    t_arc_lista* t2 = &g_listas[ARC_T2];
+
+    if (t1->tam == 0 && t2->tam == 0) return -1;
+
+    int en_b2 = entrante && entrante->pol_nodo &&
+                ((t_arc_nodo*)entrante->pol_nodo)->lista == ARC_B2;
+
+    t_arc_nodo* vict;
+    if (t1->tam > 0 && (t1->tam > g_p || (en_b2 && t1->tam == g_p) || t2->tam == 0)) {
+        vict = t1->lru;
+    } else {
+        vict = t2->lru;
+    }
+
+    return (int)vict->etp->nro_marco;
+}
+
+const t_politica_reemplazo g_politica_arc = {
+    .nombre      = "ARC",
+    .init        = _arc_init,
+    .destroy     = _arc_destroy,
+    .on_access   = _arc_on_access,
+    .on_insert   = _arc_on_insert,
+    .on_remove   = _arc_on_remove,
+    .on_forget   = _arc_on_forget,
+    .retiene     = _arc_retiene,
+    .pick_victim = _arc_pick_victim
+};
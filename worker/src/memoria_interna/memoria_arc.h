@@ -0,0 +1,18 @@
+// ============================================================================
+// WORKER - memoria_arc.h
+// PASO A PASO GENERAL
+// 1) Expone la política ARC (Adaptive Replacement Cache, ver memoria_politica.h)
+// 2) Elige marcos víctima resistiendo recorridos secuenciales de una pasada
+// ============================================================================
+
+#ifndef MEMORIA_ARC_H
+#define MEMORIA_ARC_H
+
+#include "memoria_politica.h"
+
+// ---------------------------------------------------------------------------
+// Política ARC
+// ---------------------------------------------------------------------------
+extern const t_politica_reemplazo g_politica_arc;
+
+#endif // MEMORIA_ARC_H
@@ -0,0 +1,179 @@
+// ============================================================================
+// WORKER - memoria_arena.c
+// PASO A PASO GENERAL
+// 1) Resolver el asignador pedido (MALLOC / MMAP / HUGETLB)
+// 2) MALLOC: malloc + memset, igual que antes
+// 3) MMAP: mmap anónimo; el kernel entrega páginas en cero bajo demanda, así
+//    que no se hace memset. Se pide THP con madvise(MADV_HUGEPAGE)
+// 4) HUGETLB: mmap con MAP_HUGETLB redondeando al tamaño de huge page; si el
+//    sistema no tiene huge pages reservadas se cae a MMAP
+// 5) NUMA: mbind(MPOL_BIND) del rango mapeado al nodo pedido (sin libnuma)
+// ============================================================================
+
+#include "memoria_arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+
+#define ARENA_HUGEPAGE_DEFAULT (2u * 1024u * 1024u)
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static const char* _nombre(t_arena_asignador a) {
+    switch (a) {
+        case ARENA_MMAP:    return "MMAP";
+        case ARENA_HUGETLB: return "HUGETLB";
+        default:            return "MALLOC";
+    }
+}
+
+static size_t _tam_hugepage(void) {
+    FILE* f = fopen("/proc/meminfo", "r");
+    if (!f) return ARENA_HUGEPAGE_DEFAULT;
+
+    char linea[128];
+    size_t kb = 0;
+    while (fgets(linea, sizeof(linea), f)) {
+        if (sscanf(linea, "Hugepagesize: %zu kB", &kb) == 1) break;
+    }
+    fclose(f);
+
+    return kb > 0 ? kb * 1024 : ARENA_HUGEPAGE_DEFAULT;
+}
+
+static size_t _redondear(size_t tam, size_t multiplo) {
+    return (tam + multiplo - 1) / multiplo * multiplo;
+}
+
+static void _bind_numa(t_arena* arena, int nodo_numa, t_log* logger) {
+#ifdef SYS_mbind
+    size_t bits_por_long = sizeof(unsigned long) * 8;
+    size_t nlongs = (size_t)nodo_numa / bits_por_long + 1;
+    unsigned long* mascara = calloc(nlongs, sizeof(unsigned long));
+    mascara[nodo_numa / bits_por_long] = 1ul << (nodo_numa % bits_por_long);
+
+    // El kernel usa maxnode-1 bits de la máscara
+    long rc = syscall(SYS_mbind, arena->base, arena->tam_mapeo, MPOL_BIND,
+                      mascara, nlongs * bits_por_long + 1, 0);
+    free(mascara);
+
+    if (rc != 0) {
+        if (logger) log_warning(logger, "[MEM] mbind al nodo NUMA %d falló (%s). Sigo sin ligar.",
+                                nodo_numa, strerror(errno));
+    } else if (logger) {
+        log_info(logger, "[MEM] Memoria principal ligada al nodo NUMA %d", nodo_numa);
+    }
+#else
+    if (logger) log_warning(logger, "[MEM] mbind no disponible en esta plataforma; se ignora MEMORIA_NODO_NUMA.");
+#endif
+}
+
+static int _mapear(t_arena* arena, size_t tam, int huge) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    size_t tam_mapeo = _redondear(tam, (size_t)sysconf(_SC_PAGESIZE));
+
+#ifdef MAP_HUGETLB
+    if (huge) {
+        // Sin MAP_NORESERVE: si el pool de huge pages no alcanza, mmap falla
+        // ahora en lugar de dar SIGBUS en el primer acceso
+        flags |= MAP_HUGETLB;
+        tam_mapeo = _redondear(tam, _tam_hugepage());
+    }
+#else
+    if (huge) return 0;
+#endif
+
+    void* p = mmap(NULL, tam_mapeo, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (p == MAP_FAILED) return 0;
+
+    arena->base      = p;
+    arena->tam_mapeo = tam_mapeo;
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+int memoria_arena_reservar(t_arena* arena, size_t tam, const char* asignador,
+                           int nodo_numa, t_log* logger) {
+    memset(arena, 0, sizeof(*arena));
+    arena->tam = tam;
+
+    // 1) Resolver asignador
+    t_arena_asignador pedido = ARENA_MALLOC;
+    if (asignador && strcmp(asignador, "MMAP") == 0) {
+        pedido = ARENA_MMAP;
+    } else if (asignador && strcmp(asignador, "HUGETLB") == 0) {
+        pedido = ARENA_HUGETLB;
+    } else if (asignador && strcmp(asignador, "MALLOC") != 0) {
+        if (logger) log_warning(logger, "[MEM] Asignador '%s' desconocido, usando MALLOC.", asignador);
+    }
+
+    // 2) MALLOC histórico
+    if (pedido == ARENA_MALLOC) {
+        arena->base = malloc(tam);
+        if (!arena->base) return 0;
+        memset(arena->base, 0, tam);
+        arena->tam_mapeo = tam;
+        arena->asignador = ARENA_MALLOC;
+
+        if (nodo_numa >= 0 && logger) {
+            log_warning(logger, "[MEM] MEMORIA_NODO_NUMA requiere MEMORIA_ASIGNADOR=MMAP o HUGETLB; se ignora.");
+        }
+        return 1;
+    }
+
+    // 3) HUGETLB explícito, con caída a MMAP
+    if (pedido == ARENA_HUGETLB) {
+        if (_mapear(arena, tam, 1)) {
+            arena->asignador = ARENA_HUGETLB;
+        } else {
+            if (logger) log_warning(logger, "[MEM] MAP_HUGETLB falló (%s). Uso MMAP con THP.", strerror(errno));
+            pedido = ARENA_MMAP;
+        }
+    }
+
+    // 4) MMAP anónimo + THP
+    if (pedido == ARENA_MMAP) {
+        if (!_mapear(arena, tam, 0)) {
+            if (logger) log_error(logger, "[MEM] mmap de %zu bytes falló (%s).", tam, strerror(errno));
+            return 0;
+        }
+        arena->asignador = ARENA_MMAP;
+#ifdef MADV_HUGEPAGE
+        madvise(arena->base, arena->tam_mapeo, MADV_HUGEPAGE);
+#endif
+    }
+
+    // 5) NUMA antes del primer acceso, así las páginas nacen en el nodo
+    if (nodo_numa >= 0) _bind_numa(arena, nodo_numa, logger);
+
+    if (logger) {
+        log_info(logger, "[MEM] Arena %s: %zu bytes (mapeados %zu)",
+                 _nombre(arena->asignador), arena->tam, arena->tam_mapeo);
+    }
+    return 1;
+}
+
+void memoria_arena_liberar(t_arena* arena) {
+    if (!arena || !arena->base) return;
+
+    if (arena->asignador == ARENA_MALLOC) {
+        free(arena->base);
+    } else {
+        munmap(arena->base, arena->tam_mapeo);
+    }
+
+    arena->base      = NULL;
+    arena->tam_mapeo = 0;
+}
@@ -0,0 +1,41 @@
+// ============================================================================
+// WORKER - memoria_arena.h
+// PASO A PASO GENERAL
+// 1) Reserva el arena de marcos (memoria principal) según el asignador
+//    configurado: malloc, mmap anónimo (THP) o huge pages explícitas
+// 2) Opcionalmente la liga a un nodo NUMA
+// 3) Libera el arena con el mismo mecanismo con que se reservó
+// ============================================================================
+
+#ifndef MEMORIA_ARENA_H
+#define MEMORIA_ARENA_H
+
+#include <stddef.h>
+#include <commons/log.h>
+
+// ---------------------------------------------------------------------------
+// Asignadores (clave MEMORIA_ASIGNADOR del worker.cfg)
+// ---------------------------------------------------------------------------
+typedef enum {
+    ARENA_MALLOC,    // malloc + memset (comportamiento histórico)
+    ARENA_MMAP,      // mmap anónimo, cero bajo demanda, sugerencia de THP
+    ARENA_HUGETLB    // mmap con MAP_HUGETLB (cae a ARENA_MMAP si no hay huge pages)
+} t_arena_asignador;
+
+typedef struct {
+    void*             base;
+    size_t            tam;         // tamaño pedido
+    size_t            tam_mapeo;   // tamaño realmente mapeado (redondeado)
+    t_arena_asignador asignador;   // el que finalmente se usó
+} t_arena;
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+// Devuelve 1 y completa 'arena' si pudo reservar; 0 si no.
+// nodo_numa < 0 deja la política de memoria del proceso.
+int  memoria_arena_reservar(t_arena* arena, size_t tam, const char* asignador,
+                            int nodo_numa, t_log* logger);
+void memoria_arena_liberar(t_arena* arena);
+
+#endif // MEMORIA_ARENA_H
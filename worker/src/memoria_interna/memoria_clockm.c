@@ -10,25 +10,35 @@
 #include <stdlib.h>
 
 static uint8_t* g_clock_ref   = NULL;
+static t_etp**  g_clock_etp   = NULL;   // página residente en cada marco
 static int      g_clock_hand  = 0;
 static uint32_t g_cant_marcos = 0;
 
+// ---------------------------------------------------------------------------
+// Destroy de estructura CLOCK-M
+// ---------------------------------------------------------------------------
+static void _clockm_destroy(void) {
+    free(g_clock_ref);
+    free(g_clock_etp);
+    g_clock_ref   = NULL;
+    g_clock_etp   = NULL;
+    g_cant_marcos = 0;
+}
+
 // ---------------------------------------------------------------------------
 // Init de estructura CLOCK-M
 // ---------------------------------------------------------------------------
-void memoria_clockm_init(uint32_t cant_marcos) {
-    // 1) Liberar vector previo de bits de referencia si existía
-    if (g_clock_ref) {
-        free(g_clock_ref);
-        g_clock_ref = NULL;
-    }
+static void _clockm_init(uint32_t cant_marcos) {
+    // 1) Liberar vectores previos si existían
+    _clockm_destroy();
 
     // 2) Guardar cantidad de marcos
     g_cant_marcos = cant_marcos;
 
-    // 3) Reservar vector de bits y posicionar el hand en 0
+    // 3) Reservar vectores y posicionar el hand en 0
     if (cant_marcos > 0) {
         g_clock_ref  = calloc(cant_marcos, sizeof(uint8_t));
+        g_clock_etp  = calloc(cant_marcos, sizeof(t_etp*));
         g_clock_hand = 0;
     }
 }
@@ -36,7 +46,7 @@ void memoria_clockm_init(uint32_t cant_marcos) {
 // ---------------------------------------------------------------------------
 // Marcar referencia de marco
 // ---------------------------------------------------------------------------
-void memoria_clockm_marcar_referencia(int marco) {
+static void _clockm_marcar_referencia(int marco) {
     // 1) Validar que exista el vector
     if (!g_clock_ref) return;
 
@@ -50,7 +60,7 @@ void memoria_clockm_marcar_referencia(int marco) {
 // ---------------------------------------------------------------------------
 // Limpiar referencia de marco
 // ---------------------------------------------------------------------------
-void memoria_clockm_limpiar_referencia(int marco) {
+static void _clockm_limpiar_referencia(int marco) {
     // 1) Validar que exista el vector
     if (!g_clock_ref) return;
 
@@ -61,10 +71,42 @@ void memoria_clockm_limpiar_referencia(int marco) {
     g_clock_ref[marco] = 0;
 }
 
+// ---------------------------------------------------------------------------
+// Eventos de la política
+// ---------------------------------------------------------------------------
+static void _clockm_on_access(t_etp* etp) {
+    _clockm_marcar_referencia((int)etp->nro_marco);
+}
+
+static void _clockm_on_insert(t_etp* etp, int es_prefetch) {
+    if (!g_clock_etp || etp->nro_marco >= g_cant_marcos) return;
+    g_clock_etp[etp->nro_marco] = etp;
+
+    // Las prefetcheadas entran sin bit de uso: si nadie las toca, salen primero
+    if (es_prefetch) _clockm_limpiar_referencia((int)etp->nro_marco);
+    else             _clockm_marcar_referencia((int)etp->nro_marco);
+}
+
+static void _clockm_on_remove(t_etp* etp, int por_reemplazo) {
+    if (!g_clock_etp || etp->nro_marco >= g_cant_marcos) return;
+    if (g_clock_etp[etp->nro_marco] != etp) return;
+    g_clock_etp[etp->nro_marco] = NULL;
+    _clockm_limpiar_referencia((int)etp->nro_marco);
+}
+
+static void _clockm_on_forget(t_etp* etp) {
+    // Sin estado por ETP
+}
+
+static int _clockm_retiene(const t_etp* etp) {
+    return 0;
+}
+
 // ---------------------------------------------------------------------------
 // Seleccionar marco víctima (CLOCK-M mejorado)
 // ---------------------------------------------------------------------------
-int memoria_clockm_seleccionar_marco(t_list* marcos_fisicos, uint32_t cant_marcos) {
+static int _clockm_pick_victim(t_etp* entrante) {
+    uint32_t cant_marcos = g_cant_marcos;
     if (!g_clock_ref || cant_marcos == 0) return -1;
 
     int candidato_01 = -1;
@@ -76,10 +118,9 @@ int memoria_clockm_seleccionar_marco(t_list* marcos_fisicos, uint32_t cant_marco
     for (uint32_t i = 0; i < cant_marcos; i++) {
         int idx = g_clock_hand;
 
-        t_marco* m = list_get(marcos_fisicos, idx);
-        t_etp*  e  = (m && m->ocupado) ? m->etp_asociada : NULL;
+        t_etp* e = g_clock_etp[idx];
 
-        if (m && m->ocupado && e) {
+        if (e) {
             uint8_t r = g_clock_ref[idx];
             uint8_t mod = e->dirty ? 1 : 0;
 
@@ -114,10 +155,9 @@ int memoria_clockm_seleccionar_marco(t_list* marcos_fisicos, uint32_t cant_marco
     for (uint32_t i = 0; i < cant_marcos; i++) {
         int idx = g_clock_hand;
 
-        t_marco* m = list_get(marcos_fisicos, idx);
-        t_etp*  e  = (m && m->ocupado) ? m->etp_asociada : NULL;
+        t_etp* e = g_clock_etp[idx];
 
-        if (m && m->ocupado && e) {
+        if (e) {
             uint8_t r = g_clock_ref[idx];
             uint8_t mod = e->dirty ? 1 : 0;
 
@@ -133,3 +173,15 @@ int memoria_clockm_seleccionar_marco(t_list* marcos_fisicos, uint32_t cant_marco
     // Fallback (muy raro): si no encontró nada, devolver el hand actual.
     return start_hand;
 }
+
+const t_politica_reemplazo g_politica_clockm = {
+    .nombre      = "CLOCK-M",
+    .init        = _clockm_init,
+    .destroy     = _clockm_destroy,
+    .on_access   = _clockm_on_access,
+    .on_insert   = _clockm_on_insert,
+    .on_remove   = _clockm_on_remove,
+    .on_forget   = _clockm_on_forget,
+    .retiene     = _clockm_retiene,
+    .pick_victim = _clockm_pick_victim
+};
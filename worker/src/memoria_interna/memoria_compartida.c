@@ -0,0 +1,391 @@
+// ============================================================================
+// WORKER - memoria_compartida.c
+// PASO A PASO GENERAL
+// 1) Segmento: [cabecera][época por conjunto][slots][bloques]. El primer
+//    Worker lo crea (O_EXCL) y lo inicializa; los demás esperan 'listo' y
+//    validan block_size y cantidad de slots
+// 2) Tabla asociativa por conjuntos (SHM_VIAS slots cada uno), indexada por
+//    hash de (File:Tag, bloque). Cada slot es un seqlock: par = estable,
+//    impar = alguien lo está escribiendo. Leer es copiar y verificar que la
+//    secuencia no cambió; escribir es tomar el slot con CAS (si está tomado,
+//    no se publica: nadie espera a nadie)
+// 3) Época por conjunto: persistir o invalidar un bloque la incrementa; un
+//    Worker que leyó de Storage antes de ese cambio no puede publicar su copia
+//    (quedaría vieja)
+// 4) Reemplazo dentro del conjunto: la misma clave, un slot vacío o el de
+//    uso más viejo
+// ============================================================================
+
+#include "memoria_compartida.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SHM_MAGIC       0x4d4f4631u   // "MOF1"
+#define SHM_VIAS        4              // slots por conjunto
+#define SHM_CLAVE_MAX   120            // "file:tag" más largo no se comparte
+#define SHM_ALINEACION  64
+#define SHM_ESPERA_MAX  100000         // vueltas esperando un slot a medio escribir
+#define SHM_INIT_MS     2000           // espera máxima a que el creador inicialice
+
+typedef struct {
+    uint32_t             magic;
+    uint32_t             block_size;
+    uint32_t             cant_slots;
+    uint32_t             cant_conjuntos;
+    atomic_uint          listo;        // 1 cuando el creador terminó de inicializar
+    atomic_uint          conectados;   // Workers usando el segmento
+    atomic_uint_fast64_t reloj;        // marca de uso para el reemplazo
+} t_shm_cabecera;
+
+typedef struct {
+    atomic_uint_fast64_t seq;          // par: estable, impar: escribiéndose
+    atomic_uint_fast64_t uso;
+    uint64_t             hash;
+    uint32_t             bloque;
+    uint32_t             largo_clave;  // 0 = vacío
+    char                 clave[SHM_CLAVE_MAX];
+} t_shm_slot;
+
+static t_shm_cabecera*       g_cab        = NULL;
+static atomic_uint_fast64_t* g_epocas     = NULL;
+static t_shm_slot*           g_slots      = NULL;
+static char*                 g_datos      = NULL;
+static size_t                g_tam        = 0;
+static uint32_t              g_block_size = 0;
+static char                  g_nombre[256];
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static size_t _alinear(size_t n) {
+    return (n + SHM_ALINEACION - 1) / SHM_ALINEACION * SHM_ALINEACION;
+}
+
+static size_t _off_epocas(void) {
+    return _alinear(sizeof(t_shm_cabecera));
+}
+
+static size_t _off_slots(uint32_t cant_conjuntos) {
+    return _off_epocas() + _alinear(sizeof(atomic_uint_fast64_t) * cant_conjuntos);
+}
+
+static size_t _off_datos(uint32_t cant_slots, uint32_t cant_conjuntos) {
+    return _off_slots(cant_conjuntos) + _alinear(sizeof(t_shm_slot) * cant_slots);
+}
+
+static void _dormir_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+// Clave "file:tag"; 0 si no entra
+static uint32_t _clave(file_tag_t ft, char* out) {
+    int n = snprintf(out, SHM_CLAVE_MAX, "%s:%s", ft.file ? ft.file : "", ft.tag ? ft.tag : "");
+    return (n > 0 && n < SHM_CLAVE_MAX) ? (uint32_t)n : 0;
+}
+
+static uint64_t _hash(const char* clave, uint32_t largo, uint32_t bloque) {
+    uint64_t h = 1469598103934665603ull;   // FNV-1a
+    for (uint32_t i = 0; i < largo; i++) {
+        h ^= (uint8_t)clave[i];
+        h *= 1099511628211ull;
+    }
+    h ^= bloque;
+    h *= 1099511628211ull;
+    return h ^ (h >> 29);
+}
+
+static int _coincide(const t_shm_slot* s, const char* clave, uint32_t largo, uint64_t h, uint32_t bloque) {
+    return s->largo_clave == largo && s->hash == h && s->bloque == bloque &&
+           memcmp(s->clave, clave, largo) == 0;
+}
+
+static char* _datos(uint32_t slot) {
+    return g_datos + (size_t)slot * g_block_size;
+}
+
+// Vacía el slot si tiene ese bloque (todo_el_ft: cualquier bloque del File:Tag)
+static void _vaciar_si(t_shm_slot* s, const char* clave, uint32_t largo, uint64_t h,
+                       uint32_t bloque, int todo_el_ft) {
+    for (int vueltas = 0; ; vueltas++) {
+        uint_fast64_t sq = atomic_load(&s->seq);
+        if (sq & 1) {
+            // Un publicador a mitad de camino: ya ve la época nueva y no va a
+            // dejar su copia. Si nunca termina, murió con el slot tomado.
+            if (vueltas > SHM_ESPERA_MAX) return;
+            sched_yield();
+            continue;
+        }
+
+        int es = todo_el_ft
+            ? (s->largo_clave == largo && memcmp(s->clave, clave, largo) == 0)
+            : _coincide(s, clave, largo, h, bloque);
+        if (!es) return;
+
+        if (!atomic_compare_exchange_strong(&s->seq, &sq, sq + 1)) continue;
+        s->largo_clave = 0;
+        atomic_store_explicit(&s->seq, sq + 2, memory_order_release);
+        return;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Ciclo de vida
+// ---------------------------------------------------------------------------
+int memoria_compartida_conectar(const char* nombre, uint32_t cant_bloques,
+                                uint32_t block_size, t_log* logger) {
+    if (!nombre || nombre[0] == '\0' || cant_bloques == 0 || block_size == 0) return 0;
+
+    // 1) Geometría (múltiplo de SHM_VIAS)
+    uint32_t cant_conjuntos = (cant_bloques + SHM_VIAS - 1) / SHM_VIAS;
+    uint32_t cant_slots     = cant_conjuntos * SHM_VIAS;
+    size_t   tam = _off_datos(cant_slots, cant_conjuntos) + (size_t)cant_slots * block_size;
+
+    // shm_open exige un nombre que empiece con '/'
+    snprintf(g_nombre, sizeof(g_nombre), "%s%s", nombre[0] == '/' ? "" : "/", nombre);
+
+    // 2) Crear o abrir el segmento
+    int creado = 1;
+    int fd = shm_open(g_nombre, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        creado = 0;
+        fd = shm_open(g_nombre, O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        if (logger) log_warning(logger, "[MEM] shm_open('%s') falló (%s). Sin memoria compartida.",
+                                g_nombre, strerror(errno));
+        return 0;
+    }
+
+    if (creado) {
+        if (ftruncate(fd, (off_t)tam) != 0) {
+            if (logger) log_warning(logger, "[MEM] ftruncate de la memoria compartida falló (%s).",
+                                    strerror(errno));
+            close(fd);
+            shm_unlink(g_nombre);
+            return 0;
+        }
+    } else {
+        // El creador puede no haber hecho ftruncate todavía
+        struct stat st;
+        int ms = 0;
+        while (fstat(fd, &st) == 0 && st.st_size == 0 && ms < SHM_INIT_MS) {
+            _dormir_ms(10);
+            ms += 10;
+        }
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size != tam) {
+            if (logger) log_warning(logger, "[MEM] La memoria compartida '%s' tiene otra geometría "
+                                    "(MEMORIA_COMPARTIDA_BLOQUES o block_size distintos). Sin compartir.",
+                                    g_nombre);
+            close(fd);
+            return 0;
+        }
+    }
+
+    void* base = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        if (logger) log_warning(logger, "[MEM] mmap de la memoria compartida falló (%s).", strerror(errno));
+        if (creado) shm_unlink(g_nombre);
+        return 0;
+    }
+
+    t_shm_cabecera* cab = base;
+
+    // 3) Inicializar (el segmento nuevo ya viene en cero) o esperar al creador
+    if (creado) {
+        cab->magic          = SHM_MAGIC;
+        cab->block_size     = block_size;
+        cab->cant_slots     = cant_slots;
+        cab->cant_conjuntos = cant_conjuntos;
+        atomic_store_explicit(&cab->listo, 1, memory_order_release);
+    } else {
+        int ms = 0;
+        while (!atomic_load_explicit(&cab->listo, memory_order_acquire) && ms < SHM_INIT_MS) {
+            _dormir_ms(10);
+            ms += 10;
+        }
+        if (!atomic_load_explicit(&cab->listo, memory_order_acquire) ||
+            cab->magic != SHM_MAGIC || cab->block_size != block_size || cab->cant_slots != cant_slots) {
+            if (logger) log_warning(logger, "[MEM] Memoria compartida '%s' inválida o incompatible. Sin compartir.",
+                                    g_nombre);
+            munmap(base, tam);
+            return 0;
+        }
+    }
+
+    atomic_fetch_add(&cab->conectados, 1);
+
+    g_cab        = cab;
+    g_epocas     = (atomic_uint_fast64_t*)((char*)base + _off_epocas());
+    g_slots      = (t_shm_slot*)((char*)base + _off_slots(cant_conjuntos));
+    g_datos      = (char*)base + _off_datos(cant_slots, cant_conjuntos);
+    g_tam        = tam;
+    g_block_size = block_size;
+
+    if (logger) {
+        log_info(logger, "[MEM] Memoria compartida %s: %u bloques (%s, %u Workers conectados)",
+                 g_nombre, cant_slots, creado ? "creada" : "existente",
+                 atomic_load(&cab->conectados));
+    }
+    return 1;
+}
+
+void memoria_compartida_desconectar(void) {
+    if (!g_cab) return;
+
+    t_shm_cabecera* cab = g_cab;
+    g_cab = NULL;
+
+    if (atomic_fetch_sub(&cab->conectados, 1) == 1) {
+        shm_unlink(g_nombre);
+    }
+    munmap(cab, g_tam);
+}
+
+int memoria_compartida_activa(void) {
+    return g_cab != NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Bloques
+// ---------------------------------------------------------------------------
+int memoria_compartida_leer(file_tag_t ft, uint32_t bloque, char* destino) {
+    if (!g_cab) return 0;
+
+    char clave[SHM_CLAVE_MAX];
+    uint32_t largo = _clave(ft, clave);
+    if (largo == 0) return 0;
+
+    uint64_t h    = _hash(clave, largo, bloque);
+    uint32_t conj = (uint32_t)(h % g_cab->cant_conjuntos);
+
+    for (uint32_t v = 0; v < SHM_VIAS; v++) {
+        uint32_t    i = conj * SHM_VIAS + v;
+        t_shm_slot* s = &g_slots[i];
+
+        uint_fast64_t s1 = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (s1 & 1) continue;
+        if (!_coincide(s, clave, largo, h, bloque)) continue;
+
+        memcpy(destino, _datos(i), g_block_size);
+
+        // Si la secuencia cambió, la copia puede estar mezclada
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&s->seq, memory_order_relaxed) != s1) continue;
+
+        atomic_store_explicit(&s->uso,
+                              atomic_fetch_add_explicit(&g_cab->reloj, 1, memory_order_relaxed),
+                              memory_order_relaxed);
+        return 1;
+    }
+    return 0;
+}
+
+uint64_t memoria_compartida_epoca(file_tag_t ft, uint32_t bloque) {
+    if (!g_cab) return 0;
+
+    char clave[SHM_CLAVE_MAX];
+    uint32_t largo = _clave(ft, clave);
+    if (largo == 0) return 0;
+
+    uint32_t conj = (uint32_t)(_hash(clave, largo, bloque) % g_cab->cant_conjuntos);
+    return atomic_load(&g_epocas[conj]);
+}
+
+void memoria_compartida_publicar(file_tag_t ft, uint32_t bloque, const char* datos, uint64_t epoca) {
+    if (!g_cab) return;
+
+    char clave[SHM_CLAVE_MAX];
+    uint32_t largo = _clave(ft, clave);
+    if (largo == 0) return;
+
+    uint64_t h    = _hash(clave, largo, bloque);
+    uint32_t conj = (uint32_t)(h % g_cab->cant_conjuntos);
+    if (atomic_load(&g_epocas[conj]) != epoca) return;
+
+    // 1) Elegir slot: la misma clave, uno vacío o el de uso más viejo
+    int      elegido = -1;
+    uint64_t menor   = UINT64_MAX;
+    for (uint32_t v = 0; v < SHM_VIAS; v++) {
+        uint32_t    i = conj * SHM_VIAS + v;
+        t_shm_slot* s = &g_slots[i];
+        if (atomic_load_explicit(&s->seq, memory_order_acquire) & 1) continue;
+
+        if (_coincide(s, clave, largo, h, bloque)) {
+            elegido = (int)i;
+            break;
+        }
+        uint64_t uso = s->largo_clave == 0 ? 0 : atomic_load_explicit(&s->uso, memory_order_relaxed);
+        if (elegido < 0 || uso < menor) {
+            elegido = (int)i;
+            menor   = uso;
+        }
+    }
+    if (elegido < 0) return;
+
+    // 2) Tomar el slot; si otro Worker lo tiene, no insistir
+    t_shm_slot*   s  = &g_slots[elegido];
+    uint_fast64_t sq = atomic_load(&s->seq);
+    if ((sq & 1) || !atomic_compare_exchange_strong(&s->seq, &sq, sq + 1)) return;
+
+    // 3) Con el slot tomado, volver a mirar la época: un invalidador que
+    //    llegó antes ya la incrementó, uno que llega después nos espera
+    if (atomic_load(&g_epocas[conj]) != epoca) {
+        atomic_store_explicit(&s->seq, sq + 2, memory_order_release);
+        return;
+    }
+
+    s->hash        = h;
+    s->bloque      = bloque;
+    s->largo_clave = largo;
+    memcpy(s->clave, clave, largo);
+    memcpy(_datos((uint32_t)elegido), datos, g_block_size);
+    atomic_store_explicit(&s->uso,
+                          atomic_fetch_add_explicit(&g_cab->reloj, 1, memory_order_relaxed),
+                          memory_order_relaxed);
+
+    atomic_store_explicit(&s->seq, sq + 2, memory_order_release);
+}
+
+void memoria_compartida_invalidar(file_tag_t ft, uint32_t bloque) {
+    if (!g_cab) return;
+
+    char clave[SHM_CLAVE_MAX];
+    uint32_t largo = _clave(ft, clave);
+    if (largo == 0) return;
+
+    uint64_t h    = _hash(clave, largo, bloque);
+    uint32_t conj = (uint32_t)(h % g_cab->cant_conjuntos);
+
+    atomic_fetch_add(&g_epocas[conj], 1);
+    for (uint32_t v = 0; v < SHM_VIAS; v++) {
+        _vaciar_si(&g_slots[conj * SHM_VIAS + v], clave, largo, h, bloque, 0);
+    }
+}
+
+void memoria_compartida_invalidar_ft(file_tag_t ft) {
+    if (!g_cab) return;
+
+    char clave[SHM_CLAVE_MAX];
+    uint32_t largo = _clave(ft, clave);
+    if (largo == 0) return;
+
+    // Los bloques del File:Tag están repartidos en todos los conjuntos
+    for (uint32_t c = 0; c < g_cab->cant_conjuntos; c++) {
+        atomic_fetch_add(&g_epocas[c], 1);
+        for (uint32_t v = 0; v < SHM_VIAS; v++) {
+            _vaciar_si(&g_slots[c * SHM_VIAS + v], clave, largo, 0, 0, 1);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+// ============================================================================
+// WORKER - memoria_compartida.h
+// PASO A PASO GENERAL
+// 1) Pool de bloques limpios compartido por todos los Workers del host, en un
+//    segmento POSIX (shm_open, clave MEMORIA_COMPARTIDA del worker.cfg)
+// 2) Un miss busca primero en el pool; si no está, lo lee de Storage y lo
+//    publica para los demás Workers
+// 3) Solo se publican bloques tal cual están en Storage: las páginas dirty
+//    siguen siendo privadas de cada Worker (y de su Query) hasta persistirse,
+//    y al persistirlas se invalida la copia del pool
+// 4) La tabla del pool es lock-free entre procesos (seqlock por slot)
+// Con el pool, TAM_MEMORIA de cada Worker puede achicarse al working set
+// propio (páginas dirty + calientes) y el bloque compartido vive una sola vez.
+// ============================================================================
+
+#ifndef MEMORIA_COMPARTIDA_H
+#define MEMORIA_COMPARTIDA_H
+
+#include <stdint.h>
+#include <commons/log.h>
+#include "../query_interpreter/instrucciones_parser.h"
+
+// ---------------------------------------------------------------------------
+// Ciclo de vida
+// ---------------------------------------------------------------------------
+// nombre vacío o NULL: pool deshabilitado. Todos los Workers que usen el
+// mismo nombre deben tener el mismo block_size y cant_bloques.
+// Devuelve 1 si quedó conectado.
+int  memoria_compartida_conectar(const char* nombre, uint32_t cant_bloques,
+                                 uint32_t block_size, t_log* logger);
+
+// El último Worker en desconectarse borra el segmento (así un Storage nuevo
+// no ve bloques de una corrida anterior)
+void memoria_compartida_desconectar(void);
+
+int  memoria_compartida_activa(void);
+
+// ---------------------------------------------------------------------------
+// Bloques
+// ---------------------------------------------------------------------------
+// Copia el bloque a 'destino' si está en el pool. Devuelve 1 si lo encontró.
+int      memoria_compartida_leer(file_tag_t ft, uint32_t bloque, char* destino);
+
+// Llamar ANTES de pedir el bloque a Storage y pasar el valor a publicar: si
+// mientras tanto alguien persistió o invalidó ese bloque, no se publica.
+uint64_t memoria_compartida_epoca(file_tag_t ft, uint32_t bloque);
+void     memoria_compartida_publicar(file_tag_t ft, uint32_t bloque, const char* datos, uint64_t epoca);
+
+// Después de persistir el bloque en Storage (WRITE_BLOCK / WRITE_PARTIAL)
+void     memoria_compartida_invalidar(file_tag_t ft, uint32_t bloque);
+
+// DELETE / TRUNCATE: todos los bloques del File:Tag
+void     memoria_compartida_invalidar_ft(file_tag_t ft);
+
+#endif // MEMORIA_COMPARTIDA_H
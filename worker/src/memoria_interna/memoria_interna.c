@@ -1,7 +1,14 @@
 #include "memoria_interna.h"
 #include "../conexiones/storage.h"
+#include "memoria_politica.h"
 #include "memoria_lru.h"
-#include "memoria_clockm.h"
+#include "memoria_arena.h"
+#include "memoria_slab.h"
+#include "memoria_retardo.h"
+#include "memoria_traza.h"
+#include "memoria_metricas.h"
+#include "memoria_compartida.h"
+#include "../query_interpreter/corrutinas.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -13,12 +20,31 @@
 // ============================================================================
 // WORKER - memoria_interna.c
 // PASO A PASO GENERAL
-// 1) Mantener memoria principal como array de marcos
-// 2) Gestionar tablas de páginas por File:Tag
-// 3) Resolver page-in / reemplazo (LRU o CLOCK-M)
-// 4) Leer y escribir en memoria, logueando accesos y direcciones físicas
-// 5) Flushear páginas dirty a Storage y liberar marcos
-// 6) Registrar y consultar PC por Query para desalojos
+// 1) Mantener memoria principal como array de marcos (arena, ver memoria_arena.c)
+// 2) Gestionar tablas de páginas por File:Tag (ETPs y tablas salen de slabs;
+//    las que ya no usa ninguna Query viva se recolectan al terminar una Query)
+// 3) Resolver page-in / reemplazo (política elegida, ver memoria_politica.h) y read-ahead secuencial;
+//    después de un TAG el File:Tag nuevo comparte los marcos limpios del
+//    origen y se copia recién en el primer WRITE (copy-on-write). Con
+//    DEDUP_BLOQUES, un miss cuyo bloque ya está en otro marco (mismo
+//    contenido) comparte ese marco de la misma forma. Con MEMORIA_COMPARTIDA,
+//    los bloques limpios se buscan/publican en el pool del host antes de ir
+//    a Storage (ver memoria_compartida.c)
+// 4) Leer y escribir en memoria, logueando accesos y direcciones físicas;
+//    el retardo por acceso se paga fuera del mutex (ver memoria_retardo.c) y
+//    las líneas de log las escribe el hilo de traza (ver memoria_traza.c)
+// 5) Flushear páginas dirty a Storage (bloque entero o solo el rango sucio) y liberar marcos
+// 6) Registrar PC por Query y llevar el índice de páginas residentes de cada
+//    Query (END y desalojo recorren solo esas páginas)
+// 7) Writeback en segundo plano de páginas dirty (ver memoria_writeback.c)
+// 8) Métricas: contadores globales en memoria_metricas.c; hits, misses,
+//    reemplazos y flushes por Query y por File:Tag se llevan acá
+// 9) Los page-in (demanda, lote y flush de la víctima) viajan a Storage sin
+//    el mutex: el marco queda reservado y la ETP en_pagein; quien quiera esa
+//    página espera su aviso (ver _pagein_etp). Con corrutinas
+//    (CORRUTINAS_POR_SLOT) una Query todavía puede suspenderse con el mutex
+//    tomado en un flush: las demás lo piden cediendo el hilo en lugar de
+//    bloquearlo (ver _tomar_mutex_memoria)
 // ============================================================================
 
 extern int g_fd_storage;
@@ -27,28 +53,62 @@ extern int g_fd_storage;
 // Estado interno
 // ---------------------------------------------------------------------------
 static void*    memoria_principal = NULL;
+static t_arena  g_arena;
+static char     g_asignador[16]   = "MALLOC";
+static int      g_nodo_numa       = -1;
+static int      g_escritura_parcial = 0;   // OP_WRITE_PARTIAL para rangos sucios
+static uint32_t g_traza_eventos   = 1024;  // capacidad del ring de traza (0 = log en línea)
+static char     g_traza_paginas[256] = "";  // archivo de grabación de accesos ("" = no)
+static int      g_compartir_tag   = 1;     // TAG comparte marcos con copy-on-write
+static int      g_dedup           = 0;     // bloques iguales comparten marco
+static char     g_compartida[128] = "";    // nombre del pool del host ("" = sin pool)
+static uint32_t g_compartida_bloques = 1024;
+static int32_t* g_dedup_buckets   = NULL;  // hash de contenido -> marco (con pisado)
+static uint32_t g_dedup_mascara   = 0;
 static uint32_t BLOCK_SIZE        = 0;
 static uint32_t CANT_MARCOS       = 0;
 
 static t_list* tablas_de_paginas  = NULL;
 static t_list* marcos_fisicos     = NULL;
+static t_slab* g_slab_etps        = NULL;
+static t_slab* g_slab_tablas      = NULL;
 static pthread_mutex_t mutex_memoria;
+static pthread_cond_t  cond_writeback;   // avisa fin de un lote del flusher
+static pthread_cond_t  cond_pagein;      // avisa fin de un page-in hecho fuera del mutex
+static uint32_t g_marcos_en_vuelo = 0;   // reservados por page-ins todavía sin instalar
 static t_log* g_logger            = NULL;
 
-typedef enum {
-    ALGO_LRU,
-    ALGO_CLOCKM
-} t_algoritmo_reemplazo;
+static const t_politica_reemplazo* g_politica = &g_politica_lru;
 
-static t_algoritmo_reemplazo g_algoritmo = ALGO_LRU;
-
-// Trackeo de PC por Query
+// Estado por Query: PC para desalojos + lista intrusiva de sus páginas residentes
 typedef struct {
     uint32_t query_id;
     uint32_t pc;
-} t_query_pc;
+    t_etp*   residentes_primera;   // enlazadas por etp->q_ant / etp->q_sig
+    t_etp*   residentes_ultima;
+    uint32_t cant_residentes;
+    t_list*  tablas;               // tablas donde tiene ETPs (el GC barre solo estas)
+    t_query_end_metricas met;      // resumen que viaja en QUERY_END (incluye el retardo cobrado)
+} t_query_mem;
+
+static t_list* g_queries = NULL;
+
+// Tablas con ETPs huérfanas que el GC no pudo liberar porque la política
+// todavía guarda su historia (fantasmas de ARC) o estaban en vuelo (flusher,
+// víctima de un page-in): se vuelven a barrer en cada GC y al terminar cada
+// lote del flusher, hasta que no les quede ninguna
+static t_list* g_tablas_diferidas = NULL;
+
+// File:Tag con un DELETE/TRUNCATE en curso: el flusher no les toca páginas
+// (ver memoria_retener_writeback)
+static t_list* g_ft_retenidos = NULL;
+
+// Read-ahead secuencial (ver memoria_configurar_readahead)
+#define RA_MUESTRA_MIN      8   // páginas emitidas antes de evaluar precisión
+#define RA_RACHA_REACTIVAR  8   // misses secuenciales para reintentar tras suspender
 
-static t_list* g_queries_pc = NULL;
+static uint32_t g_ra_max           = 0;
+static uint32_t g_ra_precision_min = 50;
 
 // ---------------------------------------------------------------------------
 // Helpers generales
@@ -82,15 +142,129 @@ static t_tabla_paginas* _get_or_create_tabla(file_tag_t ft, int create) {
 
     if (!create) return NULL;
 
-    t_tabla_paginas* tp = malloc(sizeof(*tp));
+    t_tabla_paginas* tp = slab_alloc(g_slab_tablas);
     tp->ft.file = strdup(ft.file ? ft.file : "");
     tp->ft.tag  = strdup(ft.tag  ? ft.tag  : "");
     tp->entradas = list_create();
+    tp->ra_siguiente  = 0;
+    tp->ra_racha      = 0;
+    tp->ra_ventana    = 0;
+    tp->ra_emitidas   = 0;
+    tp->ra_usadas     = 0;
+    tp->ra_limite     = UINT32_MAX;
+    tp->ra_suspendido = 0;
+    tp->met_hits      = 0;
+    tp->met_misses    = 0;
+    tp->met_desalojos = 0;
+    tp->met_flushes   = 0;
     list_add(tablas_de_paginas, tp);
 
     return tp;
 }
 
+// Dentro de una corrutina el mutex puede estar tomado por otra Query del
+// mismo hilo, suspendida esperando a Storage: bloquear el hilo sería un
+// deadlock, así que se cede y se reintenta
+static void _tomar_mutex_memoria(void) {
+    if (!corrutina_activa()) {
+        pthread_mutex_lock(&mutex_memoria);
+        return;
+    }
+    while (pthread_mutex_trylock(&mutex_memoria) != 0) {
+        corrutina_ceder();
+    }
+}
+
+// Espera un aviso de 'cond' con mutex_memoria tomado. Dentro de una
+// corrutina quien avisa puede ser otra Query del mismo hilo, suspendida en
+// Storage: se suelta el mutex y se cede en lugar de bloquear el hilo
+static void _esperar_aviso(pthread_cond_t* cond) {
+    if (!corrutina_activa()) {
+        pthread_cond_wait(cond, &mutex_memoria);
+        return;
+    }
+    pthread_mutex_unlock(&mutex_memoria);
+    corrutina_ceder();
+    _tomar_mutex_memoria();
+}
+
+// Si la página tiene una copia en vuelo hacia Storage (flusher o víctima de
+// un page-in), esperar a que termine antes de volver a escribirla, traerla o
+// liberar su marco (así Storage nunca recibe una versión vieja después de
+// una nueva). Requiere mutex_memoria tomado.
+// Espera una sola vez: mientras el mutex está suelto otro slot pudo liberar
+// la ETP o su tabla (GC, DELETE), así que el llamador vuelve a buscarla.
+static void _esperar_writeback(t_etp* e) {
+    if (e && e->en_writeback) _esperar_aviso(&cond_writeback);
+}
+
+// Lo mismo para una página que otro acceso está trayendo de Storage
+static void _esperar_pagein(t_etp* e) {
+    if (e && e->en_pagein) _esperar_aviso(&cond_pagein);
+}
+
+static void _marcar_limpia(t_etp* e) {
+    e->dirty       = 0;
+    e->dirty_desde = 0;
+    e->dirty_ini   = 0;
+    e->dirty_fin   = 0;
+}
+
+// Agranda el rango sucio de la página para cubrir [off, off+len)
+static void _marcar_sucia(t_etp* e, uint32_t off, uint32_t len) {
+    if (!e->dirty) {
+        e->dirty_desde = _now_ticks();
+        e->dirty_ini   = off;
+        e->dirty_fin   = off + len;
+    } else {
+        if (off < e->dirty_ini)       e->dirty_ini = off;
+        if (off + len > e->dirty_fin) e->dirty_fin = off + len;
+    }
+    e->dirty = 1;
+    e->version++;
+}
+
+// Con escritura parcial activa y un rango sucio menor al bloque, se manda
+// solo ese rango; si no, el bloque completo como siempre.
+static int _rango_parcial(const t_etp* e) {
+    return g_escritura_parcial &&
+           e->dirty_fin > e->dirty_ini &&
+           (e->dirty_ini > 0 || e->dirty_fin < BLOCK_SIZE);
+}
+
+static void _contar_flush(const t_etp* e);
+
+// Solo el envío: no toca estado compartido, se puede llamar sin el mutex si
+// nadie más puede escribir el marco (víctima de un page-in)
+static int _escribir_pagina(const t_etp* e, int fd_storage, t_log* logger) {
+    char* src = (char*)memoria_principal + ((size_t)e->nro_marco * BLOCK_SIZE);
+    int ok;
+
+    if (_rango_parcial(e)) {
+        ok = storage_io_write_partial(
+            e->ft,
+            e->id_bloque_storage,
+            e->dirty_ini,
+            src + e->dirty_ini,
+            e->dirty_fin - e->dirty_ini,
+            fd_storage,
+            logger
+        );
+    } else {
+        ok = storage_io_write_block(e->ft, e->id_bloque_storage, src, BLOCK_SIZE, fd_storage, logger);
+    }
+    return ok;
+}
+
+static int _persistir_pagina(t_etp* e, int fd_storage, t_log* logger) {
+    int ok = _escribir_pagina(e, fd_storage, logger);
+    if (ok == 1) {
+        _contar_flush(e);
+        memoria_compartida_invalidar(e->ft, e->id_bloque_storage);
+    }
+    return ok;
+}
+
 static t_etp* _buscar_etp_por_pagina(t_tabla_paginas* tp, uint32_t nro_pagina) {
     for (int i = 0; i < list_size(tp->entradas); i++) {
         t_etp* e = list_get(tp->entradas, i);
@@ -99,6 +273,293 @@ static t_etp* _buscar_etp_por_pagina(t_tabla_paginas* tp, uint32_t nro_pagina) {
     return NULL;
 }
 
+static void _anotar_tabla(uint32_t query_id, t_tabla_paginas* tp);
+
+static t_etp* _crear_etp(t_tabla_paginas* tp, uint32_t nro_pagina, int query_id) {
+    // Los strings de File:Tag son los de la tabla (uno solo por tabla)
+    t_etp* etp = slab_alloc(g_slab_etps);
+    etp->ft      = tp->ft;
+    etp->nro_pagina        = nro_pagina;
+    etp->nro_marco         = 0;
+    etp->id_bloque_storage = nro_pagina;
+    etp->presencia         = 0;
+    etp->dirty             = 0;
+    etp->query_id          = (uint32_t)query_id;
+    etp->ultimo_uso        = 0;
+    etp->dirty_desde       = 0;
+    etp->version           = 0;
+    etp->en_writeback      = 0;
+    etp->en_pagein         = 0;
+    etp->prefetch          = 0;
+    etp->pol_nodo          = NULL;
+    etp->q_ant             = NULL;
+    etp->q_sig             = NULL;
+    etp->alias_de          = NULL;
+    etp->alias_sig         = NULL;
+    etp->alias_primero     = NULL;
+    list_add(tp->entradas, etp);
+    _anotar_tabla(etp->query_id, tp);
+    return etp;
+}
+
+// ---------------------------------------------------------------------------
+// Estado por Query (PC + páginas residentes)
+// ---------------------------------------------------------------------------
+static t_query_mem* _buscar_query(uint32_t query_id, int crear) {
+    if (!g_queries) return NULL;
+    for (int i = 0; i < list_size(g_queries); i++) {
+        t_query_mem* q = list_get(g_queries, i);
+        if (q->query_id == query_id) return q;
+    }
+    if (!crear) return NULL;
+
+    t_query_mem* q = malloc(sizeof(*q));
+    q->query_id           = query_id;
+    q->pc                 = 0;
+    q->residentes_primera = NULL;
+    q->residentes_ultima  = NULL;
+    q->cant_residentes    = 0;
+    q->tablas             = list_create();
+    memset(&q->met, 0, sizeof(q->met));
+    list_add(g_queries, q);
+    return q;
+}
+
+static void _query_free(void* p) {
+    t_query_mem* q = (t_query_mem*)p;
+    list_destroy(q->tablas);
+    free(q);
+}
+
+// La Query pasa a tener ETPs en 'tp': anotarla para el GC de su END.
+// Se llama solo al crear una ETP o al cambiarle el dueño, no en cada acceso.
+static void _anotar_tabla(uint32_t query_id, t_tabla_paginas* tp) {
+    t_query_mem* q = _buscar_query(query_id, 1);
+    if (!q) return;
+    for (int i = 0; i < list_size(q->tablas); i++) {
+        if (list_get(q->tablas, i) == tp) return;
+    }
+    list_add(q->tablas, tp);
+}
+
+// La tabla se libera: que ninguna Query ni el GC diferido queden apuntándola
+static void _olvidar_tabla(t_tabla_paginas* tp) {
+    for (int i = 0; g_queries && i < list_size(g_queries); i++) {
+        t_query_mem* q = list_get(g_queries, i);
+        list_remove_element(q->tablas, tp);
+    }
+    if (g_tablas_diferidas) list_remove_element(g_tablas_diferidas, tp);
+}
+
+static void _quitar_query(uint32_t query_id) {
+    if (!g_queries) return;
+    for (int i = 0; i < list_size(g_queries); i++) {
+        t_query_mem* q = list_get(g_queries, i);
+        if (q->query_id == query_id) {
+            if (q->met.retardo_us > 0 && g_logger) {
+                log_debug(g_logger, "[MEM] Q=%u: retardo de memoria cobrado %llu ms",
+                          query_id, (unsigned long long)(q->met.retardo_us / 1000));
+            }
+            list_remove_and_destroy_element(g_queries, i, _query_free);
+            return;
+        }
+    }
+}
+
+// La página pasó a ocupar un marco: agregarla a los residentes de su Query
+static void _vincular_residente(t_etp* etp) {
+    t_query_mem* q = _buscar_query(etp->query_id, 1);
+    if (!q) return;
+
+    etp->q_ant = q->residentes_ultima;
+    etp->q_sig = NULL;
+    if (q->residentes_ultima) q->residentes_ultima->q_sig = etp;
+    else                      q->residentes_primera       = etp;
+    q->residentes_ultima = etp;
+    q->cant_residentes++;
+}
+
+// La página dejó su marco: sacarla de los residentes de su Query
+static void _desvincular_residente(t_etp* etp) {
+    t_query_mem* q = _buscar_query(etp->query_id, 0);
+    if (!q) return;
+
+    if (etp->q_ant) etp->q_ant->q_sig = etp->q_sig;
+    else if (q->residentes_primera == etp) q->residentes_primera = etp->q_sig;
+    else return;   // no estaba enlazada
+    if (etp->q_sig) etp->q_sig->q_ant = etp->q_ant;
+    else            q->residentes_ultima = etp->q_ant;
+
+    etp->q_ant = NULL;
+    etp->q_sig = NULL;
+    q->cant_residentes--;
+}
+
+// ---------------------------------------------------------------------------
+// Métricas por Query y por File:Tag (requieren mutex_memoria tomado)
+// ---------------------------------------------------------------------------
+static void _contar_acceso(t_tabla_paginas* tp, uint32_t query_id, int es_miss, uint64_t pagein_us) {
+    t_query_mem* q = _buscar_query(query_id, 0);
+
+    if (!es_miss) {
+        memoria_metricas_sumar(MET_HITS, 1);
+        tp->met_hits++;
+        if (q) q->met.hits++;
+        return;
+    }
+
+    memoria_metricas_sumar(MET_MISSES, 1);
+    memoria_metricas_latencia(LAT_PAGEIN, pagein_us);
+    tp->met_misses++;
+    if (q) {
+        q->met.misses++;
+        q->met.pagein_us += pagein_us;
+        if (pagein_us > q->met.pagein_max_us) q->met.pagein_max_us = pagein_us;
+    }
+}
+
+// El miss de 'query_id' desalojó a 'vict'
+static void _contar_reemplazo(uint32_t query_id, t_etp* vict, int sucia) {
+    memoria_metricas_sumar(MET_REEMPLAZOS, 1);
+    if (sucia) memoria_metricas_sumar(MET_REEMPLAZOS_SUCIOS, 1);
+
+    t_query_mem* q = _buscar_query(query_id, 0);
+    if (q) {
+        q->met.reemplazos++;
+        if (sucia) q->met.reemplazos_sucios++;
+    }
+
+    t_tabla_paginas* tp = _get_or_create_tabla(vict->ft, 0);
+    if (tp) tp->met_desalojos++;
+}
+
+static void _contar_flush(const t_etp* e) {
+    memoria_metricas_sumar(MET_FLUSHES, 1);
+
+    t_query_mem* q = _buscar_query(e->query_id, 0);
+    if (q) q->met.flushes++;
+
+    t_tabla_paginas* tp = _get_or_create_tabla(e->ft, 0);
+    if (tp) tp->met_flushes++;
+}
+
+// ---------------------------------------------------------------------------
+// Marcos compartidos (TAG)
+// - Una ETP alias apunta al marco de su dueña sin ocuparlo: la política no la
+//   ve y no cuenta como marco usado. Sí figura entre los residentes de su Query.
+// - Un alias nunca está dirty: el primer WRITE lo copia a un marco propio.
+// - Si la dueña se escribe o deja su marco, los alias se desmapean y el
+//   próximo acceso los trae de Storage como cualquier miss.
+// ---------------------------------------------------------------------------
+static void _desmapear_alias(t_etp* alias) {
+    t_etp* duena = alias->alias_de;
+
+    t_etp** pp = &duena->alias_primero;
+    while (*pp && *pp != alias) pp = &(*pp)->alias_sig;
+    if (*pp) *pp = alias->alias_sig;
+
+    alias->alias_de  = NULL;
+    alias->alias_sig = NULL;
+    _desvincular_residente(alias);
+
+    alias->presencia  = 0;
+    alias->nro_marco  = 0;
+    alias->ultimo_uso = 0;
+}
+
+static void _desmapear_aliases_de(t_etp* duena) {
+    while (duena->alias_primero) _desmapear_alias(duena->alias_primero);
+}
+
+static void _mapear_alias(t_etp* alias, t_etp* duena) {
+    alias->alias_de      = duena;
+    alias->alias_sig     = duena->alias_primero;
+    duena->alias_primero = alias;
+
+    alias->presencia  = 1;
+    alias->nro_marco  = duena->nro_marco;
+    alias->ultimo_uso = _now_ticks();
+    _vincular_residente(alias);
+}
+
+// ---------------------------------------------------------------------------
+// Dedupe por contenido
+// - Cada marco guarda el hash del bloque con que se cargó y un mapa
+//   hash -> marco (un marco por bucket, el último pisa) permite encontrar
+//   otro marco con el mismo contenido.
+// - El mapa es solo una pista: antes de compartir se verifica que el marco
+//   siga ocupado, limpio y con el mismo contenido byte a byte.
+// ---------------------------------------------------------------------------
+static uint64_t _hash_bloque(const char* datos) {
+    uint64_t h = 1469598103934665603ull;
+    for (uint32_t i = 0; i < BLOCK_SIZE; i++) {
+        h ^= (uint8_t)datos[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static void _dedup_registrar(int marco, const char* datos) {
+    if (!g_dedup_buckets) return;
+
+    t_marco* m = list_get(marcos_fisicos, marco);
+    m->hash = _hash_bloque(datos);
+    g_dedup_buckets[m->hash & g_dedup_mascara] = marco;
+}
+
+// Devuelve la ETP dueña de un marco limpio con exactamente 'datos', o NULL
+static t_etp* _dedup_buscar(const char* datos) {
+    uint64_t h     = _hash_bloque(datos);
+    int32_t  marco = g_dedup_buckets[h & g_dedup_mascara];
+    if (marco < 0) return NULL;
+
+    t_marco* m     = list_get(marcos_fisicos, marco);
+    t_etp*   duena = m->etp_asociada;
+    if (!m->ocupado || !duena || m->hash != h) return NULL;   // sin ETP: page-in en curso
+    if (duena->dirty || duena->en_writeback) return NULL;
+
+    const char* contenido = (char*)memoria_principal + ((size_t)marco * BLOCK_SIZE);
+    return memcmp(contenido, datos, BLOCK_SIZE) == 0 ? duena : NULL;
+}
+
+// Devuelve el marco de una página residente (sin persistir: el caller decide)
+static void _liberar_marco_de(t_etp* etp) {
+    // Un alias no tiene marco propio
+    if (etp->alias_de) {
+        _desmapear_alias(etp);
+        return;
+    }
+    _desmapear_aliases_de(etp);
+
+    t_marco* m = list_get(marcos_fisicos, (int)etp->nro_marco);
+
+    memoria_traza_libera_marco(etp->query_id, (int)m->nro_marco, etp->ft.file, etp->ft.tag);
+
+    m->ocupado      = 0;
+    m->etp_asociada = NULL;
+
+    g_politica->on_remove(etp, 0);
+    _desvincular_residente(etp);
+
+    etp->presencia  = 0;
+    etp->nro_marco  = 0;
+    etp->ultimo_uso = 0;
+}
+
+// Otra Query accede a la página: si es residente, cambia de lista
+static void _asignar_query(t_tabla_paginas* tp, t_etp* etp, uint32_t query_id) {
+    if (etp->query_id == query_id) return;
+    _anotar_tabla(query_id, tp);
+
+    if (etp->presencia) {
+        _desvincular_residente(etp);
+        etp->query_id = query_id;
+        _vincular_residente(etp);
+    } else {
+        etp->query_id = query_id;
+    }
+}
+
 // ---------------------------------------------------------------------------
 // Selección de marcos
 // ---------------------------------------------------------------------------
@@ -110,219 +571,590 @@ static int _marco_libre(void) {
     return -1;
 }
 
-static int _elegir_marco_victima(void) {
-    if (g_algoritmo == ALGO_LRU) {
-        return memoria_lru_seleccionar_marco(marcos_fisicos, CANT_MARCOS);
-    } else {
-        return memoria_clockm_seleccionar_marco(marcos_fisicos, CANT_MARCOS);
+static uint32_t _contar_marcos_libres(void) {
+    uint32_t libres = 0;
+    for (int i = 0; i < (int)CANT_MARCOS; i++) {
+        t_marco* m = list_get(marcos_fisicos, i);
+        if (m->ocupado == 0) libres++;
+    }
+    return libres;
+}
+
+static int _elegir_marco_victima(t_etp* entrante) {
+    return g_politica->pick_victim(entrante);
+}
+
+// ---------------------------------------------------------------------------
+// Lectura de bloques: primero el pool compartido del host, después Storage
+// (lo leído de Storage se publica para los demás Workers)
+// ---------------------------------------------------------------------------
+static int _leer_bloque(t_etp* etp, char* destino, int fd_storage) {
+    if (memoria_compartida_leer(etp->ft, etp->id_bloque_storage, destino)) {
+        memoria_metricas_sumar(MET_COMPARTIDA, 1);
+        return 1;
+    }
+
+    uint64_t epoca = memoria_compartida_epoca(etp->ft, etp->id_bloque_storage);
+    if (storage_io_read_block(
+            etp->ft,
+            etp->id_bloque_storage,
+            fd_storage,
+            g_logger,
+            destino,
+            BLOCK_SIZE) != 1) {
+        return 0;
+    }
+
+    memoria_compartida_publicar(etp->ft, etp->id_bloque_storage, destino, epoca);
+    return 1;
+}
+
+static void _leer_bloques(t_bloque_lectura* bloques, uint32_t n, int fd_storage) {
+    if (!memoria_compartida_activa()) {
+        storage_io_read_blocks(bloques, (int)n, fd_storage, g_logger);
+        return;
     }
+
+    // 1) Los que están en el pool no viajan
+    t_bloque_lectura* faltan = malloc(sizeof(t_bloque_lectura) * n);
+    uint32_t*         indice = malloc(sizeof(uint32_t) * n);
+    uint64_t*         epocas = malloc(sizeof(uint64_t) * n);
+    uint32_t          m      = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        bloques[i].ok = memoria_compartida_leer(bloques[i].ft, bloques[i].block_id, bloques[i].destino);
+        if (bloques[i].ok) {
+            memoria_metricas_sumar(MET_COMPARTIDA, 1);
+            continue;
+        }
+        epocas[m] = memoria_compartida_epoca(bloques[i].ft, bloques[i].block_id);
+        indice[m] = i;
+        faltan[m] = bloques[i];
+        m++;
+    }
+
+    // 2) El resto en un solo lote a Storage, y publicarlo
+    if (m > 0) storage_io_read_blocks(faltan, (int)m, fd_storage, g_logger);
+
+    for (uint32_t j = 0; j < m; j++) {
+        t_bloque_lectura* b = &bloques[indice[j]];
+        b->ok = faltan[j].ok;
+        if (b->ok) memoria_compartida_publicar(b->ft, b->block_id, b->destino, epocas[j]);
+    }
+
+    free(epocas);
+    free(indice);
+    free(faltan);
 }
 
 // ---------------------------------------------------------------------------
 // Page-in y manejo de reemplazos
 // ---------------------------------------------------------------------------
-static int _pagein_etp(t_etp* etp, int fd_storage) {
-    int marco = _marco_libre();
+// contenido != NULL: el bloque ya está en memoria (copy-on-write de un alias
+// o leído antes para dedupe) y no se lee de Storage. origen: etiqueta del log
+// de PageIn (NULL = la de siempre).
+// Como el flusher con el writeback, el viaje a Storage se hace sin el mutex:
+// 1) Con el mutex: elegir marco (libre o víctima), sacar a la víctima y
+//    dejar el marco reservado (ocupado, sin ETP); la ETP queda en_pagein y
+//    la víctima sucia en_writeback (nadie la trae hasta que llegue a Storage)
+// 2) Sin el mutex: persistir la víctima y leer el bloque nuevo en el marco
+// 3) Con el mutex: instalar la página y avisar a los que esperaban
+// Vuelve con el mutex tomado; como se soltó, el llamador no puede confiar en
+// punteros a tablas u otras ETPs que tenía de antes.
+static int _pagein_etp(t_etp* etp, int fd_storage, const char* contenido, const char* origen) {
+    int marco = -1;
     int hubo_reemplazo = 0;
-
-    if (marco < 0) {
-        marco = _elegir_marco_victima();
+    t_etp* vict   = NULL;
+    t_etp* vict_sucia = NULL;
+
+    // Desde ya: si hay que esperar un marco, otro acceso no la trae de nuevo
+    etp->en_pagein = 1;
+
+    // Si la víctima está siendo persistida por el flusher, o todos los marcos
+    // están reservados por page-ins en curso, esperar y volver a elegir (el
+    // estado de los marcos pudo cambiar mientras tanto)
+    while (1) {
+        vict  = NULL;
+        marco = _marco_libre();
+        if (marco >= 0) break;
+
+        marco = _elegir_marco_victima(etp);
+        if (marco < 0 && g_marcos_en_vuelo > 0) {
+            _esperar_aviso(&cond_pagein);
+            continue;
+        }
         if (marco < 0) {
+            etp->en_pagein = 0;
+            pthread_cond_broadcast(&cond_pagein);
+            memoria_traza_sincronizar();
             if (g_logger) log_error(g_logger, "[MEM] Sin marcos y no se pudo elegir víctima.");
             return 0;
         }
-        hubo_reemplazo = 1;
-
-        t_marco* m_vict = list_get(marcos_fisicos, marco);
-        t_etp*  vict   = m_vict->etp_asociada;
+        vict = ((t_marco*)list_get(marcos_fisicos, marco))->etp_asociada;
+        if (!vict || !vict->en_writeback) {
+            hubo_reemplazo = 1;
+            break;
+        }
+        _esperar_writeback(vict);
+    }
 
+    if (hubo_reemplazo) {
         if (vict) {
-            // Flush si está dirty
+            _contar_reemplazo(etp->query_id, vict, vict->presencia && vict->dirty);
+
+            // Si está dirty se persiste en el paso 2 (conserva su nro_marco)
             if (vict->presencia && vict->dirty) {
-                char* src = (char*)memoria_principal + ((size_t)vict->nro_marco * BLOCK_SIZE);
-                log_warning(g_logger,
-                "[DBG] victim_flush(q=%u) %s:%s pag=%u blk=%u dirty=%u",
-                etp->query_id,
-                vict->ft.file ? vict->ft.file : "",
-                vict->ft.tag  ? vict->ft.tag  : "",
-                vict->nro_pagina,
-                vict->id_bloque_storage,
-                vict->dirty);////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-                if (storage_io_write_block(
-                        vict->ft,
-                        vict->id_bloque_storage,
-                        src,
-                        BLOCK_SIZE,
-                        fd_storage,
-                        g_logger) != 1) {
-                    if (g_logger) {
-                        log_error(
-                            g_logger,
-                            "[MEM] Error flusheando página víctima."
-                        );
-                    }
-                    return 0;
-                }
-                vict->dirty = 0;
+                memoria_traza_victim_flush(etp->query_id, vict->ft.file, vict->ft.tag,
+                                           vict->nro_pagina, vict->id_bloque_storage);
+                vict_sucia = vict;
             }
 
             // Log de liberación de marco de la víctima
-            if (g_logger && vict->presencia) {
-                log_info(
-                    g_logger,
-                    "Query %u: Se libera el Marco: %d perteneciente al - File: %s - Tag: %s",
-                    (unsigned)vict->query_id,
-                    marco,
-                    vict->ft.file ? vict->ft.file : "",
-                    vict->ft.tag  ? vict->ft.tag  : ""
-                );
+            if (vict->presencia) {
+                memoria_traza_libera_marco(vict->query_id, marco, vict->ft.file, vict->ft.tag);
             }
 
             // Log de reemplazo de página
-            if (g_logger) {
-                log_info(
-                    g_logger,
-                    "## Query %u: Se reemplaza la página %s:%s/%u por la %s:%s/%u",
-                    (unsigned)etp->query_id,
-                    vict->ft.file ? vict->ft.file : "",
-                    vict->ft.tag  ? vict->ft.tag  : "",
-                    vict->nro_pagina,
-                    etp->ft.file  ? etp->ft.file  : "",
-                    etp->ft.tag   ? etp->ft.tag   : "",
-                    etp->nro_pagina
-                );
-            }
+            memoria_traza_reemplazo(etp->query_id,
+                                    vict->ft.file, vict->ft.tag, vict->nro_pagina,
+                                    etp->ft.file, etp->ft.tag, etp->nro_pagina);
+
+            _desmapear_aliases_de(vict);
+            g_politica->on_remove(vict, 1);
+            _desvincular_residente(vict);
 
             vict->presencia  = 0;
-            vict->nro_marco  = 0;
             vict->ultimo_uso = 0;
+            if (vict_sucia) vict->en_writeback = 1;
+            else            vict->nro_marco    = 0;
         }
+    }
 
-        m_vict->ocupado      = 0;
-        m_vict->etp_asociada = NULL;
+    // 1) Marco reservado: ni _marco_libre, ni la política, ni el flusher lo ven
+    t_marco* m = list_get(marcos_fisicos, marco);
+    m->ocupado      = 1;
+    m->etp_asociada = NULL;
+    g_marcos_en_vuelo++;
+
+    // 2) Storage fuera del mutex
+    pthread_mutex_unlock(&mutex_memoria);
 
-        if (g_algoritmo == ALGO_CLOCKM) {
-            memoria_clockm_limpiar_referencia(marco);
+    char* dst = (char*)memoria_principal + ((size_t)marco * BLOCK_SIZE);
+    int ok_vict = vict_sucia ? (_escribir_pagina(vict_sucia, fd_storage, g_logger) == 1) : 1;
+    int ok      = 0;
+    if (ok_vict) {
+        if (contenido) {
+            memcpy(dst, contenido, BLOCK_SIZE);
+            ok = 1;
+        } else {
+            ok = _leer_bloque(etp, dst, fd_storage);
         }
     }
 
-    // Leer bloque desde Storage
-    char* dst = (char*)memoria_principal + ((size_t)marco * BLOCK_SIZE);
-    if (storage_io_read_block(
-            etp->ft,
-            etp->id_bloque_storage,
-            fd_storage,
-            g_logger,
-            dst,
-            BLOCK_SIZE) != 1) {
+    _tomar_mutex_memoria();
+
+    // 3) Instalar
+    etp->en_pagein = 0;
+    g_marcos_en_vuelo--;
+    pthread_cond_broadcast(&cond_pagein);
+
+    if (vict_sucia) {
+        vict_sucia->en_writeback = 0;
+        pthread_cond_broadcast(&cond_writeback);
+
+        if (ok_vict) {
+            _contar_flush(vict_sucia);
+            memoria_compartida_invalidar(vict_sucia->ft, vict_sucia->id_bloque_storage);
+            _marcar_limpia(vict_sucia);
+            vict_sucia->nro_marco = 0;
+        } else if (_buscar_query(vict_sucia->query_id, 0)) {
+            // Su contenido sigue en el marco: vuelve a ocuparlo, como si no
+            // se hubiera elegido
+            m->etp_asociada       = vict_sucia;
+            vict_sucia->presencia = 1;
+            g_politica->on_insert(vict_sucia, 0);
+            _vincular_residente(vict_sucia);
+        } else {
+            // Su Query ya terminó mientras tanto: no queda quién la reclame
+            _marcar_limpia(vict_sucia);
+            vict_sucia->nro_marco = 0;
+        }
+
+        if (!ok_vict) {
+            memoria_traza_sincronizar();
+            if (g_logger) {
+                log_error(
+                    g_logger,
+                    "[MEM] Error flusheando página víctima."
+                );
+            }
+            if (m->etp_asociada == NULL) m->ocupado = 0;
+            return 0;
+        }
+    }
+
+    if (!ok) {
+        m->ocupado = 0;
+        memoria_traza_sincronizar();
         if (g_logger) {
             log_error(g_logger, "[MEM] Error leyendo bloque desde Storage.");
         }
         return 0;
     }
 
-    t_marco* m = list_get(marcos_fisicos, marco);
-    m->ocupado      = 1;
     m->etp_asociada = etp;
+    _dedup_registrar(marco, dst);
 
     etp->nro_marco   = (uint32_t)marco;
     etp->presencia   = 1;
-    etp->dirty       = 0;
+    _marcar_limpia(etp);
+    etp->prefetch    = 0;
     etp->ultimo_uso  = _now_ticks();
 
-    if (g_algoritmo == ALGO_CLOCKM) {
-        memoria_clockm_marcar_referencia(marco);
-    }
+    g_politica->on_insert(etp, 0);
+    _vincular_residente(etp);
 
     // Agregar el log de asignación de marco aquí
-    if (g_logger) {
-        log_info(
-            g_logger,
-            "Query %u: Se asigna el Marco: %d a la Página: %u perteneciente al - File: %s - Tag: %s",
-            (unsigned)etp->query_id,
-            marco,
-            etp->nro_pagina,
-            etp->ft.file ? etp->ft.file : "",
-            etp->ft.tag  ? etp->ft.tag  : ""
-        );
-    }
+    memoria_traza_asigna_marco(etp->query_id, marco, etp->nro_pagina, etp->ft.file, etp->ft.tag);
 
     // Log genérico del PageIn (solo informativo)
-    if (g_logger) {
-        const char* algo = (g_algoritmo == ALGO_LRU) ? "LRU" : "CLOCK-M";
-        if (hubo_reemplazo) {
-            log_info(
-                g_logger,
-                "[MEM] PageIn(%s) REEMPLAZO -> pag=%u -> marco=%d",
-                algo,
-                etp->nro_pagina,
-                marco
-            );
-        } else {
-            log_info(
-                g_logger,
-                "[MEM] PageIn(%s) -> pag=%u -> marco=%d",
-                algo,
-                etp->nro_pagina,
-                marco
-            );
+    memoria_traza_pagein(g_politica->nombre,
+                         origen ? origen : (hubo_reemplazo ? "REEMPLAZO" : ""),
+                         etp->nro_pagina, marco);
+
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Page-in en lote (read-ahead y rangos multi-página)
+// - Solo usa marcos libres: nunca desaloja páginas para traer otras.
+// - Los bloques se piden a Storage en un único lote (pedidos encadenados),
+//   sin el mutex, igual que en _pagein_etp.
+// - Devuelve cuántas páginas quedaron presentes.
+// ---------------------------------------------------------------------------
+static uint32_t _pagein_lote(t_etp** etps, uint32_t n, int es_prefetch, int fd_storage) {
+    if (n == 0) return 0;
+
+    t_bloque_lectura* bloques = calloc(n, sizeof(t_bloque_lectura));
+    int*              marcos  = malloc(sizeof(int) * n);
+    uint32_t          k       = 0;
+
+    // 1) Reservar marcos libres (quedan ocupados sin ETP hasta instalar)
+    for (uint32_t i = 0; i < n; i++) {
+        int marco = _marco_libre();
+        if (marco < 0) break;
+
+        t_marco* m = list_get(marcos_fisicos, marco);
+        m->ocupado = 1;
+        marcos[k]  = marco;
+        etps[i]->en_pagein = 1;
+        g_marcos_en_vuelo++;
+
+        bloques[k].ft        = etps[i]->ft;
+        bloques[k].block_id  = etps[i]->id_bloque_storage;
+        bloques[k].query_id  = etps[i]->query_id;
+        bloques[k].destino   = (char*)memoria_principal + ((size_t)marco * BLOCK_SIZE);
+        bloques[k].max_bytes = BLOCK_SIZE;
+        k++;
+    }
+
+    // 2) Pedir todos los bloques juntos
+    if (k > 0) {
+        pthread_mutex_unlock(&mutex_memoria);
+        _leer_bloques(bloques, k, fd_storage);
+        _tomar_mutex_memoria();
+    }
+
+    // 3) Instalar los que llegaron y devolver los marcos del resto
+    uint32_t instaladas = 0;
+    const char* algo = g_politica->nombre;
+
+    for (uint32_t i = 0; i < k; i++) {
+        t_marco* m   = list_get(marcos_fisicos, marcos[i]);
+        t_etp*   etp = etps[i];
+        etp->en_pagein = 0;
+
+        if (!bloques[i].ok) {
+            m->ocupado = 0;
+            continue;
         }
+
+        m->etp_asociada = etp;
+        _dedup_registrar(marcos[i], bloques[i].destino);
+        etp->nro_marco  = (uint32_t)marcos[i];
+        etp->presencia  = 1;
+        _marcar_limpia(etp);
+        etp->prefetch   = es_prefetch ? 1 : 0;
+        etp->ultimo_uso = _now_ticks();
+
+        // Para la política todo el lote llega antes de su acceso de demanda
+        // (también el de _prefetch_rango, que se toca recién en el loop del
+        // READ/WRITE): ese primer acceso no debe contar como reuso
+        g_politica->on_insert(etp, 1);
+        _vincular_residente(etp);
+
+        if (!es_prefetch) {
+            memoria_traza_miss(etp->query_id, etp->ft.file, etp->ft.tag, etp->nro_pagina);
+        }
+        memoria_traza_asigna_marco(etp->query_id, marcos[i], etp->nro_pagina, etp->ft.file, etp->ft.tag);
+        memoria_traza_pagein(algo, es_prefetch ? "READ-AHEAD" : "LOTE", etp->nro_pagina, marcos[i]);
+        memoria_traza_pagina(etp->ft.file, etp->ft.tag, etp->nro_pagina, 'P');
+        instaladas++;
+    }
+
+    g_marcos_en_vuelo -= k;
+    if (k > 0) pthread_cond_broadcast(&cond_pagein);
+    memoria_metricas_sumar(MET_READAHEAD, instaladas);
+
+    free(marcos);
+    free(bloques);
+    return instaladas;
+}
+
+// Se llama después de un miss de demanda sobre 'pagina'
+static void _readahead(t_tabla_paginas* tp, uint32_t pagina, int query_id, int fd_storage) {
+    if (g_ra_max == 0) return;
+
+    // 1) Detección de acceso secuencial
+    if (tp->ra_racha > 0 && pagina == tp->ra_siguiente) {
+        tp->ra_racha++;
+    } else {
+        tp->ra_racha   = 1;
+        tp->ra_ventana = 0;
+    }
+    tp->ra_siguiente = pagina + 1;
+    if (tp->ra_racha < 2) return;
+
+    // 2) Si la precisión cae bajo el mínimo, suspender; reintentar tras una racha larga
+    if (tp->ra_emitidas >= RA_MUESTRA_MIN) {
+        uint32_t precision = tp->ra_usadas * 100 / tp->ra_emitidas;
+        if (precision < g_ra_precision_min) {
+            tp->ra_suspendido = 1;
+            tp->ra_ventana    = 0;
+            if (g_logger) {
+                log_debug(g_logger, "[MEM] Read-ahead suspendido en %s:%s (precisión=%u%%)",
+                          tp->ft.file, tp->ft.tag, precision);
+            }
+        }
+        tp->ra_emitidas = 0;
+        tp->ra_usadas   = 0;
+    }
+    if (tp->ra_suspendido) {
+        if (tp->ra_racha < RA_RACHA_REACTIVAR) return;
+        tp->ra_suspendido = 0;
+    }
+
+    // 3) Ventana adaptativa: arranca en 2 y se duplica hasta el máximo
+    tp->ra_ventana = tp->ra_ventana ? tp->ra_ventana * 2 : 2;
+    if (tp->ra_ventana > g_ra_max) tp->ra_ventana = g_ra_max;
+
+    // 4) Acotar por marcos libres y por el fin de archivo conocido
+    uint32_t n = tp->ra_ventana;
+    uint32_t libres = _contar_marcos_libres();
+    if (n > libres) n = libres;
+    if (n == 0) return;
+
+    t_etp** etps = malloc(sizeof(t_etp*) * n);
+    uint32_t k = 0;
+    uint32_t p = pagina + 1;
+
+    for (; p <= pagina + n && p < tp->ra_limite; p++) {
+        t_etp* e = _buscar_etp_por_pagina(tp, p);
+        if (!e) e = _crear_etp(tp, p, query_id);
+        if (e->presencia || e->en_pagein || e->en_writeback) continue;   // presente o en vuelo
+        _asignar_query(tp, e, (uint32_t)query_id);
+        etps[k++] = e;
     }
+    tp->ra_siguiente = p;
+
+    uint32_t traidas = _pagein_lote(etps, k, 1, fd_storage);
+    tp->ra_emitidas += traidas;
+
+    // La primera que Storage rechazó marca el fin de archivo conocido
+    for (uint32_t i = 0; i < k; i++) {
+        if (!etps[i]->presencia) {
+            if (etps[i]->nro_pagina < tp->ra_limite) tp->ra_limite = etps[i]->nro_pagina;
+            break;
+        }
+    }
+
+    free(etps);
+}
+
+// Antes de un READ/WRITE que cruza varias páginas: traer juntas las faltantes
+static void _prefetch_rango(file_tag_t ft, uint32_t dir_base, uint32_t size, int query_id, int fd_storage) {
+    if (g_ra_max == 0 || size == 0) return;
+
+    uint32_t pag_ini = dir_base / BLOCK_SIZE;
+    uint32_t pag_fin = (dir_base + size - 1) / BLOCK_SIZE;
+    if (pag_fin == pag_ini) return;
+
+    t_tabla_paginas* tp = _get_or_create_tabla(ft, 1);
+
+    // El rango cuenta como avance secuencial para el detector
+    int secuencial   = (tp->ra_racha > 0 && pag_ini == tp->ra_siguiente);
+    tp->ra_racha     = secuencial ? tp->ra_racha + 1 : 1;
+    tp->ra_siguiente = pag_fin + 1;
+
+    uint32_t libres = _contar_marcos_libres();
+    if (libres == 0) return;
+
+    uint32_t total = pag_fin - pag_ini + 1;
+    t_etp**  etps  = malloc(sizeof(t_etp*) * total);
+    uint32_t k     = 0;
+
+    for (uint32_t p = pag_ini; p <= pag_fin && k < libres; p++) {
+        t_etp* e = _buscar_etp_por_pagina(tp, p);
+        if (!e) e = _crear_etp(tp, p, query_id);
+        if (e->presencia || e->en_pagein || e->en_writeback) continue;   // presente o en vuelo
+        _asignar_query(tp, e, (uint32_t)query_id);
+        etps[k++] = e;
+    }
+
+    _pagein_lote(etps, k, 0, fd_storage);
+    free(etps);
+}
 
+// Primer WRITE sobre un alias: copiar el bloque compartido a un marco propio
+static int _copiar_al_escribir(t_etp* etp, int fd_storage) {
+    t_etp* duena = etp->alias_de;
+
+    // La copia sale antes del page-in: el reemplazo podría elegir justo el
+    // marco de la dueña
+    char* copia = malloc(BLOCK_SIZE);
+    memcpy(copia, (char*)memoria_principal + ((size_t)duena->nro_marco * BLOCK_SIZE), BLOCK_SIZE);
+    _desmapear_alias(etp);
+    memoria_metricas_sumar(MET_COW, 1);
+
+    int ok = _pagein_etp(etp, fd_storage, copia, "COW");
+    free(copia);
+    return ok;
+}
+
+// Miss con dedupe: el bloque se lee antes de ocupar un marco; si otro marco
+// ya tiene el mismo contenido se comparte (sin desalojar a nadie). La lectura
+// también va sin el mutex, con la ETP en_pagein.
+static int _pagein_dedup(t_etp* etp, int fd_storage) {
+    if (!g_dedup_buckets) return _pagein_etp(etp, fd_storage, NULL, NULL);
+
+    char* bloque = malloc(BLOCK_SIZE);
+    etp->en_pagein = 1;
+    pthread_mutex_unlock(&mutex_memoria);
+    int ok = _leer_bloque(etp, bloque, fd_storage);
+    _tomar_mutex_memoria();
+    etp->en_pagein = 0;
+    pthread_cond_broadcast(&cond_pagein);
+
+    if (!ok) {
+        free(bloque);
+        memoria_traza_sincronizar();
+        if (g_logger) {
+            log_error(g_logger, "[MEM] Error leyendo bloque desde Storage.");
+        }
+        return 0;
+    }
+
+    t_etp* duena = _dedup_buscar(bloque);
+    if (!duena) {
+        ok = _pagein_etp(etp, fd_storage, bloque, NULL);
+        free(bloque);
+        return ok;
+    }
+    free(bloque);
+
+    _mapear_alias(etp, duena);
+    g_politica->on_access(duena);
+    memoria_metricas_sumar(MET_DEDUP, 1);
+    memoria_traza_pagein(g_politica->nombre, "DEDUP", etp->nro_pagina, (int)duena->nro_marco);
     return 1;
 }
 
+// Cada page-in suelta el mutex: después de uno se vuelve a buscar la tabla y
+// la ETP desde el principio (otro slot pudo desalojarla, o borrarla con un
+// DELETE) hasta encontrarla presente. Si otro acceso ya la está trayendo, o
+// su versión anterior todavía viaja a Storage como víctima, se espera.
 static t_etp* _get_etp_y_asegurar_presencia(
     file_tag_t ft,
     uint32_t   dir_base,
     int        query_id,
-    int        fd_storage
+    int        fd_storage,
+    int        para_escritura
 ) {
     uint32_t nro_pagina = dir_base / BLOCK_SIZE;
 
-    t_tabla_paginas* tp = _get_or_create_tabla(ft, 1);
-    t_etp* etp = _buscar_etp_por_pagina(tp, nro_pagina);
-    int es_nueva = 0;
-
-    if (!etp) {
-        etp = malloc(sizeof(*etp));
-        etp->ft.file = strdup(ft.file ? ft.file : "");
-        etp->ft.tag  = strdup(ft.tag ? ft.tag : "");
-        etp->nro_pagina        = nro_pagina;
-        etp->nro_marco         = 0;
-        etp->id_bloque_storage = nro_pagina;
-        etp->presencia         = 0;
-        etp->dirty             = 0;
-        etp->query_id          = (uint32_t)query_id;
-        etp->ultimo_uso        = 0;
-        list_add(tp->entradas, etp);
-        es_nueva = 1;
-    }
-
-    etp->query_id = (uint32_t)query_id;///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-    if (es_nueva || !etp->presencia) {
-        if (g_logger) {
-            log_info(
-                g_logger,
-                "Query %u: - Memoria Miss - File: %s - Tag: %s - Pagina: %u",
-                (unsigned)query_id,
-                ft.file ? ft.file : "",
-                ft.tag  ? ft.tag  : "",
-                nro_pagina
-            );
+    t_tabla_paginas* tp;
+    t_etp* etp;
+    int es_miss = 0;      // hubo page-in de demanda
+    int copiada = 0;      // hubo copy-on-write
+    uint64_t pagein_us = 0;
+
+    memoria_traza_pagina(ft.file, ft.tag, nro_pagina, para_escritura ? 'W' : 'R');
+
+    while (1) {
+        tp  = _get_or_create_tabla(ft, 1);
+        etp = _buscar_etp_por_pagina(tp, nro_pagina);
+        if (!etp) etp = _crear_etp(tp, nro_pagina, query_id);
+
+        if (etp->en_pagein) {
+            _esperar_pagein(etp);
+            continue;
         }
+        if (!etp->presencia && etp->en_writeback) {
+            _esperar_writeback(etp);
+            continue;
+        }
+
+        _asignar_query(tp, etp, (uint32_t)query_id);
 
-        if (!_pagein_etp(etp, fd_storage)) {
-            return NULL;
+        if (!etp->presencia) {
+            if (!es_miss) memoria_traza_miss((uint32_t)query_id, ft.file, ft.tag, nro_pagina);
+            es_miss = 1;
+
+            uint64_t t0 = memoria_metricas_ahora_us();
+            if (!_pagein_dedup(etp, fd_storage)) {
+                return NULL;
+            }
+            pagein_us += memoria_metricas_ahora_us() - t0;
+
+            // Storage aceptó la página: el archivo creció más allá del límite conocido
+            tp = _get_or_create_tabla(ft, 1);
+            if (nro_pagina >= tp->ra_limite) tp->ra_limite = UINT32_MAX;
+            _readahead(tp, nro_pagina, query_id, fd_storage);
+            continue;
         }
+
+        // WRITE sobre un marco compartido: el alias pasa a tener marco propio
+        if (para_escritura && etp->alias_de) {
+            if (!_copiar_al_escribir(etp, fd_storage)) return NULL;
+            copiada = 1;
+            continue;
+        }
+        break;
+    }
+
+    if (es_miss) {
+        _contar_acceso(tp, (uint32_t)query_id, 1, pagein_us);
+    } else {
+        _contar_acceso(tp, (uint32_t)query_id, 0, 0);
+
+        if (etp->prefetch) {
+            // Acierto del read-ahead
+            etp->prefetch = 0;
+            tp->ra_usadas++;
+        }
+    }
+
+    // La dueña suelta a sus alias: el bloque que ellos ven en Storage ya no
+    // va a coincidir con el marco
+    if (para_escritura) {
+        _desmapear_aliases_de(etp);
     }
 
     etp->ultimo_uso = _now_ticks();
 
-    if (g_algoritmo == ALGO_CLOCKM && etp->presencia) {
-        memoria_clockm_marcar_referencia((int)etp->nro_marco);
+    // En un miss el page-in ya avisó a la política (on_insert)
+    if (etp->presencia && !es_miss && !copiada) {
+        g_politica->on_access(etp->alias_de ? etp->alias_de : etp);
     }
 
     return etp;
@@ -331,11 +1163,17 @@ static t_etp* _get_etp_y_asegurar_presencia(
 // ---------------------------------------------------------------------------
 // Init / Destroy
 // ---------------------------------------------------------------------------
+static void _ft_retenido_free(void* p) {
+    file_tag_t* ft = (file_tag_t*)p;
+    free(ft->file);
+    free(ft->tag);
+    free(ft);
+}
+
 static void _etp_free(void* p) {
     t_etp* e = (t_etp*)p;
-    free(e->ft.file);
-    free(e->ft.tag);
-    free(e);
+    g_politica->on_forget(e);
+    slab_free(g_slab_etps, e);
 }
 
 static void _tabla_free(void* p) {
@@ -343,15 +1181,112 @@ static void _tabla_free(void* p) {
     if (tp->entradas) list_destroy_and_destroy_elements(tp->entradas, _etp_free);
     free(tp->ft.file);
     free(tp->ft.tag);
-    free(tp);
+    slab_free(g_slab_tablas, tp);
+}
+
+static void _quitar_tabla(t_tabla_paginas* tp) {
+    for (int i = 0; i < list_size(tablas_de_paginas); i++) {
+        if (list_get(tablas_de_paginas, i) == tp) {
+            list_remove(tablas_de_paginas, i);
+            break;
+        }
+    }
+    _olvidar_tabla(tp);
+    _tabla_free(tp);
+}
+
+// ---------------------------------------------------------------------------
+// GC de metadatos (se llama al terminar una Query, con mutex tomado y antes
+// de _quitar_query)
+// - Solo se barren las tablas donde la Query tuvo ETPs, no todas, más las
+//   diferidas de GCs anteriores.
+// - Una ETP se recolecta si no está en memoria, no está en vuelo, la política
+//   no guarda historia de ella y su dueña es la Query que termina o ya no
+//   está viva.
+// - Una tabla se recolecta cuando se queda sin ETPs. Si le quedan huérfanas
+//   en vuelo o retenidas, pasa a las diferidas (ver g_tablas_diferidas).
+// ---------------------------------------------------------------------------
+
+// Libera las ETPs recolectables de 'tp' ('q': la Query que termina, o NULL
+// si solo se buscan las de Queries que ya no están). Devuelve 1 si quedó
+// alguna huérfana en vuelo o retenida por la política (la tabla hay que
+// volver a barrerla más adelante).
+static int _barrer_tabla(t_tabla_paginas* tp, const t_query_mem* q, uint32_t* etps_liberadas) {
+    int retenidas = 0;
+
+    for (int j = 0; j < list_size(tp->entradas); ) {
+        t_etp* e = list_get(tp->entradas, j);
+        if (e->presencia ||
+            ((!q || e->query_id != q->query_id) && _buscar_query(e->query_id, 0))) {
+            j++;
+            continue;
+        }
+        if (e->en_writeback || e->en_pagein || g_politica->retiene(e)) {
+            retenidas = 1;
+            j++;
+            continue;
+        }
+        list_remove(tp->entradas, j);
+        _etp_free(e);
+        (*etps_liberadas)++;
+    }
+    return retenidas;
+}
+
+static void _diferir_tabla(t_tabla_paginas* tp) {
+    for (int i = 0; i < list_size(g_tablas_diferidas); i++) {
+        if (list_get(g_tablas_diferidas, i) == tp) return;
+    }
+    list_add(g_tablas_diferidas, tp);
+}
+
+// Las diferidas: lo que ya aterrizó o la política descartó se libera ahora
+static void _barrer_diferidas(const t_query_mem* q, uint32_t* etps_liberadas, uint32_t* tablas_liberadas) {
+    for (int i = 0; i < list_size(g_tablas_diferidas); ) {
+        t_tabla_paginas* tp = list_get(g_tablas_diferidas, i);
+        int retenidas = _barrer_tabla(tp, q, etps_liberadas);
+
+        if (list_is_empty(tp->entradas)) {
+            _quitar_tabla(tp);   // también la saca de las diferidas
+            (*tablas_liberadas)++;
+        } else if (!retenidas) {
+            list_remove(g_tablas_diferidas, i);
+        } else {
+            i++;
+        }
+    }
 }
 
-static void _qpc_free(void* p) {
-    free((t_query_pc*)p);
+static void _gc_metadatos(t_query_mem* q) {
+    if (!q) return;
+
+    uint32_t etps_liberadas   = 0;
+    uint32_t tablas_liberadas = 0;
+
+    // 1) Diferidas de GCs anteriores
+    _barrer_diferidas(q, &etps_liberadas, &tablas_liberadas);
+
+    // 2) Las tablas de la Query que termina
+    while (!list_is_empty(q->tablas)) {
+        t_tabla_paginas* tp = list_remove(q->tablas, 0);
+        int retenidas = _barrer_tabla(tp, q, &etps_liberadas);
+
+        if (list_is_empty(tp->entradas)) {
+            _quitar_tabla(tp);
+            tablas_liberadas++;
+        } else if (retenidas) {
+            _diferir_tabla(tp);
+        }
+    }
+
+    if (g_logger && (etps_liberadas > 0 || tablas_liberadas > 0)) {
+        log_debug(g_logger, "[MEM] GC Q=%u: %u ETPs y %u tablas liberadas (ETPs vivas=%u)",
+                  q->query_id, etps_liberadas, tablas_liberadas, slab_en_uso(g_slab_etps));
+    }
 }
 
 int memoria_init(
-    uint32_t    tam_memoria,
+    size_t      tam_memoria,
     uint32_t    block_size,
     const char* algoritmo,
     t_log*      logger
@@ -359,53 +1294,69 @@ int memoria_init(
     g_logger   = logger;
     BLOCK_SIZE = block_size;
 
-    if (!algoritmo) {
-        g_algoritmo = ALGO_LRU;
-    } else if (strcmp(algoritmo, "LRU") == 0) {
-        g_algoritmo = ALGO_LRU;
-    } else if (strcmp(algoritmo, "CLOCK-M") == 0 ||
-               strcmp(algoritmo, "CLOCKM")  == 0 ||
-               strcmp(algoritmo, "CLOCK")   == 0) {
-        g_algoritmo = ALGO_CLOCKM;
-    } else {
-        g_algoritmo = ALGO_LRU;
-        if (logger) log_warning(logger, "[MEM] Algoritmo '%s' desconocido, usando LRU.", algoritmo);
+    g_politica = memoria_politica_buscar(algoritmo);
+    if (!g_politica) {
+        g_politica = &g_politica_lru;
+        if (algoritmo && logger) log_warning(logger, "[MEM] Algoritmo '%s' desconocido, usando LRU.", algoritmo);
     }
 
-    if (pthread_mutex_init(&mutex_memoria, NULL) != 0) {
+    // Los marcos se indexan con int (listas de commons, víctimas, -1 = ninguno)
+    if (tam_memoria / block_size > INT32_MAX) {
+        if (logger) log_error(logger, "[MEM] TAM_MEMORIA=%zu da más de %d marcos de %u bytes.",
+                              tam_memoria, INT32_MAX, block_size);
+        return 0;
+    }
+
+    if (pthread_mutex_init(&mutex_memoria, NULL) != 0 ||
+        pthread_cond_init(&cond_writeback, NULL) != 0 ||
+        pthread_cond_init(&cond_pagein, NULL) != 0) {
         if (logger) log_error(logger, "[MEM] No se pudo inicializar mutex.");
         return 0;
     }
 
-    memoria_principal = malloc(tam_memoria);
-    if (!memoria_principal) {
+    // MALLOC la deja en cero con memset; MMAP/HUGETLB ya vienen en cero bajo demanda
+    if (!memoria_arena_reservar(&g_arena, tam_memoria, g_asignador, g_nodo_numa, logger)) {
         if (logger) log_error(logger, "[MEM] No se pudo reservar memoria principal.");
         return 0;
     }
-    memset(memoria_principal, 0, tam_memoria);
+    memoria_principal = g_arena.base;
 
-    CANT_MARCOS       = tam_memoria / block_size;
+    CANT_MARCOS       = (uint32_t)(tam_memoria / block_size);
+    g_slab_etps       = slab_crear(sizeof(t_etp), 256);
+    g_slab_tablas     = slab_crear(sizeof(t_tabla_paginas), 32);
     tablas_de_paginas = list_create();
     marcos_fisicos    = list_create();
-    g_queries_pc      = list_create();
+    g_queries         = list_create();
+    g_ft_retenidos    = list_create();
+    g_tablas_diferidas = list_create();
 
     for (uint32_t i = 0; i < CANT_MARCOS; i++) {
         t_marco* m   = malloc(sizeof(*m));
         m->nro_marco = i;
         m->ocupado   = 0;
         m->etp_asociada = NULL;
+        m->hash      = 0;
         list_add(marcos_fisicos, m);
     }
 
-    if (g_algoritmo == ALGO_CLOCKM) {
-        memoria_clockm_init(CANT_MARCOS);
+    g_politica->init(CANT_MARCOS);
+    memoria_traza_iniciar(logger, g_traza_eventos, g_traza_paginas);
+
+    if (g_dedup) {
+        uint32_t buckets = 1;
+        while (buckets < CANT_MARCOS * 2) buckets <<= 1;
+        g_dedup_buckets = malloc(sizeof(int32_t) * buckets);
+        g_dedup_mascara = buckets - 1;
+        for (uint32_t i = 0; i < buckets; i++) g_dedup_buckets[i] = -1;
     }
 
+    memoria_compartida_conectar(g_compartida, g_compartida_bloques, BLOCK_SIZE, logger);
+
     if (logger) {
-        const char* nombre_algo = (g_algoritmo == ALGO_LRU) ? "LRU" : "CLOCK-M";
+        const char* nombre_algo = g_politica->nombre;
         log_info(
             logger,
-            "[MEM] Init OK: %u bytes, %u marcos x %u bytes. Algoritmo=%s",
+            "[MEM] Init OK: %zu bytes, %u marcos x %u bytes. Algoritmo=%s",
             tam_memoria,
             CANT_MARCOS,
             BLOCK_SIZE,
@@ -420,7 +1371,47 @@ uint32_t memoria_get_block_size(void) {
     return BLOCK_SIZE;
 }
 
+void memoria_configurar_asignador(const char* asignador, int nodo_numa) {
+    snprintf(g_asignador, sizeof(g_asignador), "%s", asignador ? asignador : "MALLOC");
+    g_nodo_numa = nodo_numa;
+}
+
+void memoria_configurar_traza(uint32_t capacidad, const char* path_paginas) {
+    g_traza_eventos = capacidad;
+    snprintf(g_traza_paginas, sizeof(g_traza_paginas), "%s", path_paginas ? path_paginas : "");
+}
+
+void memoria_configurar_dedup(int habilitado) {
+    g_dedup = habilitado ? 1 : 0;
+}
+
+void memoria_configurar_compartida(const char* nombre, uint32_t cant_bloques) {
+    snprintf(g_compartida, sizeof(g_compartida), "%s", nombre ? nombre : "");
+    g_compartida_bloques = cant_bloques;
+}
+
+void memoria_configurar_compartir_tag(int habilitado) {
+    g_compartir_tag = habilitado ? 1 : 0;
+}
+
+void memoria_configurar_escritura_parcial(int habilitada) {
+    g_escritura_parcial = habilitada ? 1 : 0;
+}
+
+void memoria_configurar_readahead(uint32_t max_paginas, uint32_t precision_min) {
+    g_ra_max           = max_paginas;
+    g_ra_precision_min = precision_min;
+
+    if (g_logger && max_paginas > 0) {
+        log_info(g_logger, "[MEM] Read-ahead activo: ventana máx=%u páginas, precisión mín=%u%%",
+                 max_paginas, precision_min);
+    }
+}
+
 void memoria_destroy(void) {
+    memoria_traza_detener();
+    memoria_compartida_desconectar();
+
     if (marcos_fisicos) {
         list_destroy_and_destroy_elements(marcos_fisicos, free);
         marcos_fisicos = NULL;
@@ -429,14 +1420,31 @@ void memoria_destroy(void) {
         list_destroy_and_destroy_elements(tablas_de_paginas, _tabla_free);
         tablas_de_paginas = NULL;
     }
-    if (g_queries_pc) {
-        list_destroy_and_destroy_elements(g_queries_pc, _qpc_free);
-        g_queries_pc = NULL;
+    g_politica->destroy();
+    slab_destruir(g_slab_etps);
+    slab_destruir(g_slab_tablas);
+    g_slab_etps   = NULL;
+    g_slab_tablas = NULL;
+    if (g_queries) {
+        list_destroy_and_destroy_elements(g_queries, _query_free);
+        g_queries = NULL;
+    }
+    if (g_ft_retenidos) {
+        list_destroy_and_destroy_elements(g_ft_retenidos, _ft_retenido_free);
+        g_ft_retenidos = NULL;
+    }
+    if (g_tablas_diferidas) {
+        list_destroy(g_tablas_diferidas);
+        g_tablas_diferidas = NULL;
     }
+    free(g_dedup_buckets);
+    g_dedup_buckets = NULL;
     if (memoria_principal) {
-        free(memoria_principal);
+        memoria_arena_liberar(&g_arena);
         memoria_principal = NULL;
     }
+    pthread_cond_destroy(&cond_writeback);
+    pthread_cond_destroy(&cond_pagein);
     pthread_mutex_destroy(&mutex_memoria);
 
     if (g_logger) log_info(g_logger, "[MEM] Destroy OK.");
@@ -445,6 +1453,17 @@ void memoria_destroy(void) {
 // ---------------------------------------------------------------------------
 // READ / WRITE / FLUSH
 // ---------------------------------------------------------------------------
+// Anota en la Query el costo de sus accesos (con el mutex tomado) y lo
+// devuelve para pagarlo después de soltarlo
+static uint64_t _cobrar_retardo(int query_id, uint32_t accesos, uint32_t retardo_ms) {
+    uint64_t costo = memoria_retardo_costo_us(accesos, retardo_ms);
+    if (costo == 0) return 0;
+
+    t_query_mem* q = _buscar_query((uint32_t)query_id, 0);
+    if (q) q->met.retardo_us += costo;
+    return costo;
+}
+
 int memoria_escribir(
     file_tag_t  ft,
     uint32_t    dir_base,
@@ -455,18 +1474,24 @@ int memoria_escribir(
     t_log*      logger,
     uint32_t    retardo_ms
 ) {
-    pthread_mutex_lock(&mutex_memoria);
+    _tomar_mutex_memoria();
 
     uint32_t remaining = size;
     uint32_t cur_dir   = dir_base;
     const char* src_ptr = content;
+    uint32_t accesos   = 0;
+
+    _prefetch_rango(ft, dir_base, size, query_id, fd_storage);
 
     while (remaining > 0) {
 
         // Traer/asegurar la página correspondiente a cur_dir
-        t_etp* etp = _get_etp_y_asegurar_presencia(ft, cur_dir, query_id, fd_storage);
+        t_etp* etp = _get_etp_y_asegurar_presencia(ft, cur_dir, query_id, fd_storage, 1);
         if (!etp) {
+            uint64_t costo = _cobrar_retardo(query_id, accesos, retardo_ms);
             pthread_mutex_unlock(&mutex_memoria);
+            memoria_traza_sincronizar();
+            memoria_retardo_pagar(costo);
             return -1;
         }
 
@@ -477,30 +1502,18 @@ int memoria_escribir(
         char* dst = (char*)memoria_principal + ((size_t)etp->nro_marco * BLOCK_SIZE) + off;
         memcpy(dst, src_ptr, chunk);
 
-        // Marcar dirty por página
-        etp->dirty      = 1;
+        // Marcar dirty por página (solo el rango tocado)
+        _marcar_sucia(etp, off, chunk);
         etp->ultimo_uso = _now_ticks();
 
-        uint32_t dir_fisica = etp->nro_marco * BLOCK_SIZE + off;
+        uint64_t dir_fisica = (uint64_t)etp->nro_marco * BLOCK_SIZE + off;
 
-        // Retardo por acceso (si cruzás páginas, hay múltiples accesos reales)
-        usleep(retardo_ms * 1000);
+        // Retardo por acceso (si cruzás páginas, hay múltiples accesos reales);
+        // se cobra al final, sin el mutex
+        accesos++;
 
         // Log (por chunk, con dirección física real)
-        if (logger) {
-            char valor_str[64];
-            uint32_t log_len = chunk < (sizeof(valor_str) - 1) ? chunk : (uint32_t)(sizeof(valor_str) - 1);
-            memcpy(valor_str, src_ptr, log_len);
-            valor_str[log_len] = '\0';
-
-            log_info(
-                logger,
-                "Query %u: Acción: ESCRIBIR - Dirección Física: %u - Valor: %s",
-                (unsigned)query_id,
-                dir_fisica,
-                valor_str
-            );
-        }
+        memoria_traza_acceso(1, (uint32_t)query_id, dir_fisica, src_ptr, chunk);
 
         // Avanzar
         cur_dir   += chunk;
@@ -508,7 +1521,11 @@ int memoria_escribir(
         remaining -= chunk;
     }
 
+    uint64_t costo = _cobrar_retardo(query_id, accesos, retardo_ms);
     pthread_mutex_unlock(&mutex_memoria);
+    memoria_traza_sincronizar();
+
+    memoria_retardo_pagar(costo);
     return 1;
 }
 
@@ -522,17 +1539,23 @@ int memoria_leer(
     t_log*     logger,
     uint32_t   retardo_ms
 ) {
-    pthread_mutex_lock(&mutex_memoria);
+    _tomar_mutex_memoria();
 
     uint32_t remaining = size;
     uint32_t cur_dir   = dir_base;
     char* dst_ptr      = destino;
+    uint32_t accesos   = 0;
+
+    _prefetch_rango(ft, dir_base, size, query_id, fd_storage);
 
     while (remaining > 0) {
 
-        t_etp* etp = _get_etp_y_asegurar_presencia(ft, cur_dir, query_id, fd_storage);
+        t_etp* etp = _get_etp_y_asegurar_presencia(ft, cur_dir, query_id, fd_storage, 0);
         if (!etp) {
+            uint64_t costo = _cobrar_retardo(query_id, accesos, retardo_ms);
             pthread_mutex_unlock(&mutex_memoria);
+            memoria_traza_sincronizar();
+            memoria_retardo_pagar(costo);
             return -1;
         }
 
@@ -545,31 +1568,22 @@ int memoria_leer(
 
         etp->ultimo_uso = _now_ticks();
 
-        uint32_t dir_fisica = etp->nro_marco * BLOCK_SIZE + off;
-
-        usleep(retardo_ms * 1000);
+        uint64_t dir_fisica = (uint64_t)etp->nro_marco * BLOCK_SIZE + off;
 
-        if (logger) {
-            char valor_str[64];
-            uint32_t log_len = chunk < (sizeof(valor_str) - 1) ? chunk : (uint32_t)(sizeof(valor_str) - 1);
-            memcpy(valor_str, dst_ptr, log_len);
-            valor_str[log_len] = '\0';
+        accesos++;
 
-            log_info(
-                logger,
-                "Query %u: Acción: LEER - Dirección Física: %u - Valor: %s",
-                (unsigned)query_id,
-                dir_fisica,
-                valor_str
-            );
-        }
+        memoria_traza_acceso(0, (uint32_t)query_id, dir_fisica, dst_ptr, chunk);
 
         cur_dir   += chunk;
         dst_ptr   += chunk;
         remaining -= chunk;
     }
 
+    uint64_t costo = _cobrar_retardo(query_id, accesos, retardo_ms);
     pthread_mutex_unlock(&mutex_memoria);
+    memoria_traza_sincronizar();
+
+    memoria_retardo_pagar(costo);
     return 1;
 }
 
@@ -578,52 +1592,52 @@ int memoria_flush(
     int        fd_storage,
     t_log*     logger
 ) {
-    pthread_mutex_lock(&mutex_memoria);
+    _tomar_mutex_memoria();
 
     t_tabla_paginas* tp = _get_or_create_tabla(ft, 0);
     int flushed = 0;
     int hubo_error = 0;
 
-    if (tp) {
-        for (int i = 0; i < list_size(tp->entradas); i++) {
-            t_etp* etp = list_get(tp->entradas, i);
-
-            if (etp->presencia && etp->dirty) {
-
-                char* src = (char*)memoria_principal + ((size_t)etp->nro_marco * BLOCK_SIZE);
-                log_warning(logger,
-                "[DBG] flush_explicit %s:%s pag=%u blk=%u dirty=%u",
-                etp->ft.file ? etp->ft.file : "",
-                etp->ft.tag  ? etp->ft.tag  : "",////////////////////////////////////////////////////////////////////////////////////////////////////////
-                etp->nro_pagina,
-                etp->id_bloque_storage,
-                etp->dirty);
-
-
-                int ok = storage_io_write_block(
-                    etp->ft,
-                    etp->id_bloque_storage,
-                    src,
-                    BLOCK_SIZE,
-                    fd_storage,
-                    logger
-                );
+    int i = 0;
+    while (tp && i < list_size(tp->entradas)) {
+        t_etp* etp = list_get(tp->entradas, i);
+
+        // Esperar al flusher suelta el mutex: la tabla pudo cambiar, volver a
+        // buscarla y recorrer desde el principio (lo ya bajado quedó limpio)
+        if (etp->en_writeback) {
+            _esperar_writeback(etp);
+            tp = _get_or_create_tabla(ft, 0);
+            i  = 0;
+            continue;
+        }
+        i++;
+
+        if (etp->presencia && etp->dirty) {
+
+            if (logger) {
+                log_debug(logger, "[MEM] flush_explicit %s:%s pag=%u blk=%u",
+                          etp->ft.file ? etp->ft.file : "",
+                          etp->ft.tag  ? etp->ft.tag  : "",
+                          etp->nro_pagina,
+                          etp->id_bloque_storage);
+            }
 
-                if (ok == 1) {
-                    etp->dirty = 0;
-                    flushed++;
-                } else {
-                    hubo_error = 1;
-
-                    if (logger) {
-                        log_error(
-                            logger,
-                            "[MEM] Error flusheando página (File=%s Tag=%s Pag=%u).",
-                            etp->ft.file,
-                            etp->ft.tag,
-                            etp->nro_pagina
-                        );
-                    }
+            int ok = _persistir_pagina(etp, fd_storage, logger);
+
+            if (ok == 1) {
+                _marcar_limpia(etp);
+                flushed++;
+            } else {
+                hubo_error = 1;
+
+                if (logger) {
+                    log_error(
+                        logger,
+                        "[MEM] Error flusheando página (File=%s Tag=%s Pag=%u).",
+                        etp->ft.file,
+                        etp->ft.tag,
+                        etp->nro_pagina
+                    );
                 }
             }
         }
@@ -643,7 +1657,7 @@ int memoria_flush(
 // Flushes especiales
 // ---------------------------------------------------------------------------
 void memoria_flush_global(void) {
-    pthread_mutex_lock(&mutex_memoria);
+    _tomar_mutex_memoria();
 
     int fd_storage = g_fd_storage;
 
@@ -653,121 +1667,94 @@ void memoria_flush_global(void) {
             t_etp* etp = list_get(tp->entradas, j);
             if (!etp->presencia) continue;
 
-            if (etp->dirty && fd_storage >= 0) {
-                char* src = (char*)memoria_principal + ((size_t)etp->nro_marco * BLOCK_SIZE);
-                storage_io_write_block(
-                    etp->ft,
-                    etp->id_bloque_storage,
-                    src,
-                    BLOCK_SIZE,
-                    fd_storage,
-                    g_logger
-                );
-                etp->dirty = 0;
-            }
-
-            t_marco* m = list_get(marcos_fisicos, (int)etp->nro_marco);
-
-            if (g_logger) {
-                log_info(
-                    g_logger,
-                    "Query %u: Se libera el Marco: %u perteneciente al - File: %s - Tag: %s",
-                    (unsigned)etp->query_id,
-                    (unsigned)m->nro_marco,
-                    etp->ft.file ? etp->ft.file : "",
-                    etp->ft.tag  ? etp->ft.tag  : ""
-                );
+            // Esperar al flusher suelta el mutex: tablas y ETPs pudieron
+            // liberarse, recorrer de nuevo (lo ya liberado no vuelve a aparecer)
+            if (etp->en_writeback) {
+                _esperar_writeback(etp);
+                i = -1;
+                break;
             }
 
-            m->ocupado      = 0;
-            m->etp_asociada = NULL;
-
-            if (g_algoritmo == ALGO_CLOCKM) {
-                memoria_clockm_limpiar_referencia((int)m->nro_marco);
+            if (etp->dirty && fd_storage >= 0) {
+                _persistir_pagina(etp, fd_storage, g_logger);
+                _marcar_limpia(etp);
             }
 
-            etp->presencia  = 0;
-            etp->nro_marco  = 0;
-            etp->ultimo_uso = 0;
+            _liberar_marco_de(etp);
         }
     }
 
     pthread_mutex_unlock(&mutex_memoria);
+    memoria_traza_sincronizar();
 
     if (g_logger) log_info(g_logger, "[MEM] Flush global completo (todas las páginas liberadas).");
     else fprintf(stderr, "[MEM] Flush global completo.\n");
 }
 
-void memoria_flush_implicito(uint32_t query_id) {
-    pthread_mutex_lock(&mutex_memoria);
-
-    int fd_storage = g_fd_storage;
-
-    for (int i = 0; i < list_size(tablas_de_paginas); i++) {
-        t_tabla_paginas* tp = list_get(tablas_de_paginas, i);
-        for (int j = 0; j < list_size(tp->entradas); j++) {
-            t_etp* etp = list_get(tp->entradas, j);
-            if (etp->query_id != query_id) continue;
-            if (!etp->presencia) continue;
-
-            log_warning(g_logger,
-            "[DBG] flush_implicito(q=%u) -> etp q_owner=%u %s:%s pag=%u blk=%u dirty=%u",
-            query_id, etp->query_id,
-            etp->ft.file, etp->ft.tag,
-            etp->nro_pagina, etp->id_bloque_storage,
-            etp->dirty);////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-
-            if (etp->dirty && fd_storage >= 0) {
-                char* src = (char*)memoria_principal + ((size_t)etp->nro_marco * BLOCK_SIZE);
-                storage_io_write_block(
-                    etp->ft,
-                    etp->id_bloque_storage,
-                    src,
-                    BLOCK_SIZE,
-                    fd_storage,
-                    g_logger
-                );
-                etp->dirty = 0;
-            }
-
-            t_marco* m = list_get(marcos_fisicos, (int)etp->nro_marco);
-
-            if (g_logger) {
-                log_info(
-                    g_logger,
-                    "Query %u: Se libera el Marco: %u perteneciente al - File: %s - Tag: %s",
-                    (unsigned)etp->query_id,
-                    (unsigned)m->nro_marco,
-                    etp->ft.file ? etp->ft.file : "",
-                    etp->ft.tag  ? etp->ft.tag  : ""
-                );
+// Páginas de la Query que un page-in de otro slot eligió como víctimas y
+// todavía viajan a Storage: el desalojo no se confirma antes de que lleguen
+static void _esperar_victimas_query(uint32_t query_id) {
+    while (1) {
+        t_query_mem* q = _buscar_query(query_id, 0);
+        t_etp* en_vuelo = NULL;
+        for (int i = 0; q && i < list_size(q->tablas) && !en_vuelo; i++) {
+            t_tabla_paginas* tp = list_get(q->tablas, i);
+            for (int j = 0; j < list_size(tp->entradas) && !en_vuelo; j++) {
+                t_etp* e = list_get(tp->entradas, j);
+                if (e->en_writeback && !e->presencia && e->query_id == query_id) en_vuelo = e;
             }
+        }
+        if (!en_vuelo) return;
+        _esperar_writeback(en_vuelo);
+    }
+}
 
-            m->ocupado      = 0;
-            m->etp_asociada = NULL;
-
-            if (g_algoritmo == ALGO_CLOCKM) {
-                memoria_clockm_limpiar_referencia((int)m->nro_marco);
-            }
+// fd_storage es la conexión del ejecutor que desaloja: con varios slots la
+// global la usa el slot 0 fuera del mutex y los frames se mezclarían
+void memoria_flush_implicito(uint32_t query_id, int fd_storage, t_query_end_metricas* resumen) {
+    _tomar_mutex_memoria();
+
+    // Solo las páginas residentes de la Query: siempre se toma la primera,
+    // que al liberarse sale de la lista
+    while (1) {
+        t_query_mem* q = _buscar_query(query_id, 0);
+        t_etp* etp = q ? q->residentes_primera : NULL;
+        if (!etp) break;
+
+        // Esperar al flusher suelta el mutex: releer la lista después
+        if (etp->en_writeback) {
+            _esperar_writeback(etp);
+            continue;
+        }
 
-            etp->presencia  = 0;
-            etp->nro_marco  = 0;
-            etp->ultimo_uso = 0;
+        if (g_logger) {
+            log_debug(g_logger, "[MEM] flush_implicito(q=%u) %s:%s pag=%u blk=%u dirty=%u",
+                      query_id, etp->ft.file, etp->ft.tag,
+                      etp->nro_pagina, etp->id_bloque_storage, etp->dirty);
         }
-    }
 
-    if (g_queries_pc) {
-        for (int i = 0; i < list_size(g_queries_pc); i++) {
-            t_query_pc* q = list_get(g_queries_pc, i);
-            if (q->query_id == query_id) {
-                list_remove_and_destroy_element(g_queries_pc, i, _qpc_free);
-                break;
-            }
+        if (etp->dirty && fd_storage >= 0) {
+            _persistir_pagina(etp, fd_storage, g_logger);
+            _marcar_limpia(etp);
         }
+
+        _liberar_marco_de(etp);
     }
+    _esperar_victimas_query(query_id);
+
+    // El resumen se toma recién acá para que cuente los flushes de arriba;
+    // después se destruye junto con la Query
+    if (resumen) {
+        t_query_mem* q = _buscar_query(query_id, 0);
+        if (q) *resumen = q->met;
+        else   memset(resumen, 0, sizeof(*resumen));
+    }
+
+    _gc_metadatos(_buscar_query(query_id, 0));
+    _quitar_query(query_id);
 
     pthread_mutex_unlock(&mutex_memoria);
+    memoria_traza_sincronizar();
 
     if (g_logger) {
         log_info(
@@ -784,105 +1771,392 @@ void memoria_flush_implicito(uint32_t query_id) {
 // - No escribe a Storage, incluso si hay páginas dirty.
 // - Libera marcos y descarta cambios (dirty=0).
 void memoria_liberar_implicito(uint32_t query_id) {
-    pthread_mutex_lock(&mutex_memoria);
+    _tomar_mutex_memoria();
 
-    for (int i = 0; i < list_size(tablas_de_paginas); i++) {
-        t_tabla_paginas* tp = list_get(tablas_de_paginas, i);
-        for (int j = 0; j < list_size(tp->entradas); j++) {
-            t_etp* etp = list_get(tp->entradas, j);
-            if (etp->query_id != query_id) continue;
-            if (!etp->presencia) continue;
+    t_query_mem* q = _buscar_query(query_id, 0);
+    while (q && q->residentes_primera) {
+        t_etp* etp = q->residentes_primera;
 
-            // NO PERSISTE: descartamos dirty si existiera
-            etp->dirty = 0;
+        // NO PERSISTE: descartamos dirty si existiera
+        _marcar_limpia(etp);
+        _liberar_marco_de(etp);
+    }
 
-            t_marco* m = list_get(marcos_fisicos, (int)etp->nro_marco);
+    _gc_metadatos(_buscar_query(query_id, 0));
+    _quitar_query(query_id);
 
-            if (g_logger) {
-                log_info(
-                    g_logger,
-                    "Query %u: Se libera el Marco: %u perteneciente al - File: %s - Tag: %s",
-                    (unsigned)etp->query_id,
-                    (unsigned)m->nro_marco,
-                    etp->ft.file ? etp->ft.file : "",
-                    etp->ft.tag  ? etp->ft.tag  : ""
-                );
-            }
+    pthread_mutex_unlock(&mutex_memoria);
+    memoria_traza_sincronizar();
+
+    if (g_logger) {
+        log_info(
+            g_logger,
+            "[MEM] Liberación implícita de Q=%u completa (sin persistir).",
+            query_id
+        );
+    } else {
+        fprintf(stderr, "[MEM] Liberación implícita de Q=%u completa.\n", query_id);
+    }
+}
 
-            m->ocupado      = 0;
-            m->etp_asociada = NULL;
+// TAG: en Storage el destino queda apuntando a los mismos bloques físicos que
+// el origen. Las páginas limpias del origen que están en memoria tienen
+// exactamente ese contenido, así que el destino las mapea como alias.
+void memoria_tag(file_tag_t origen, file_tag_t destino, int query_id) {
+    if (!g_compartir_tag) return;
 
-            if (g_algoritmo == ALGO_CLOCKM) {
-                memoria_clockm_limpiar_referencia((int)m->nro_marco);
-            }
+    _tomar_mutex_memoria();
+
+    uint32_t compartidas = 0;
+    t_tabla_paginas* tp_origen = _get_or_create_tabla(origen, 0);
 
-            etp->presencia  = 0;
-            etp->nro_marco  = 0;
-            etp->ultimo_uso = 0;
+    if (tp_origen) {
+        t_tabla_paginas* tp_destino = _get_or_create_tabla(destino, 1);
+
+        for (int i = 0; i < list_size(tp_origen->entradas); i++) {
+            t_etp* e = list_get(tp_origen->entradas, i);
+            if (!e->presencia || e->dirty || e->en_writeback) continue;
+
+            t_etp* d = _buscar_etp_por_pagina(tp_destino, e->nro_pagina);
+            if (d && (d->presencia || d->en_pagein)) continue;
+            if (!d) d = _crear_etp(tp_destino, e->nro_pagina, query_id);
+
+            _asignar_query(tp_destino, d, (uint32_t)query_id);
+            _mapear_alias(d, e->alias_de ? e->alias_de : e);
+            compartidas++;
         }
     }
 
-    if (g_queries_pc) {
-        for (int i = 0; i < list_size(g_queries_pc); i++) {
-            t_query_pc* q = list_get(g_queries_pc, i);
-            if (q->query_id == query_id) {
-                list_remove_and_destroy_element(g_queries_pc, i, _qpc_free);
-                break;
-            }
+    pthread_mutex_unlock(&mutex_memoria);
+
+    if (g_logger && compartidas > 0) {
+        log_info(g_logger, "[MEM] TAG %s:%s -> %s:%s: %u páginas compartidas (copy-on-write)",
+                 origen.file, origen.tag, destino.file, destino.tag, compartidas);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Retención del writeback por File:Tag (DELETE / TRUNCATE)
+// ---------------------------------------------------------------------------
+static int _ft_retenido(file_tag_t ft) {
+    for (int i = 0; g_ft_retenidos && i < list_size(g_ft_retenidos); i++) {
+        file_tag_t* r = list_get(g_ft_retenidos, i);
+        if (_strcmp_nullsafe(r->file, ft.file) == 0 &&
+            _strcmp_nullsafe(r->tag,  ft.tag)  == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Hasta que no haya ninguna página del File:Tag en vuelo (hacia Storage por
+// el flusher o como víctima, o desde Storage en un page-in).
+// Esperar suelta el mutex: la tabla se vuelve a buscar cada vez.
+static void _esperar_writeback_ft(file_tag_t ft) {
+    while (1) {
+        t_tabla_paginas* tp = _get_or_create_tabla(ft, 0);
+        t_etp* en_vuelo = NULL;
+        for (int i = 0; tp && i < list_size(tp->entradas) && !en_vuelo; i++) {
+            t_etp* e = list_get(tp->entradas, i);
+            if (e->en_writeback || e->en_pagein) en_vuelo = e;
+        }
+        if (!en_vuelo) return;
+        if (en_vuelo->en_writeback) _esperar_writeback(en_vuelo);
+        else                        _esperar_pagein(en_vuelo);
+    }
+}
+
+void memoria_retener_writeback(file_tag_t ft) {
+    _tomar_mutex_memoria();
+
+    file_tag_t* r = malloc(sizeof(*r));
+    r->file = strdup(ft.file ? ft.file : "");
+    r->tag  = strdup(ft.tag  ? ft.tag  : "");
+    list_add(g_ft_retenidos, r);
+
+    _esperar_writeback_ft(ft);
+
+    pthread_mutex_unlock(&mutex_memoria);
+}
+
+void memoria_soltar_writeback(file_tag_t ft) {
+    _tomar_mutex_memoria();
+
+    for (int i = 0; i < list_size(g_ft_retenidos); i++) {
+        file_tag_t* r = list_get(g_ft_retenidos, i);
+        if (_strcmp_nullsafe(r->file, ft.file) == 0 &&
+            _strcmp_nullsafe(r->tag,  ft.tag)  == 0) {
+            list_remove_and_destroy_element(g_ft_retenidos, i, _ft_retenido_free);
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&mutex_memoria);
+}
+
+// DELETE: el File:Tag ya no existe en Storage. Se liberan sus marcos sin
+// persistir y se borra su tabla de páginas.
+void memoria_descartar(file_tag_t ft) {
+    memoria_compartida_invalidar_ft(ft);
+
+    _tomar_mutex_memoria();
+
+    _esperar_writeback_ft(ft);
+
+    t_tabla_paginas* tp = _get_or_create_tabla(ft, 0);
+    if (tp) {
+        for (int i = 0; i < list_size(tp->entradas); i++) {
+            t_etp* e = list_get(tp->entradas, i);
+            if (!e->presencia) continue;
+            _marcar_limpia(e);
+            _liberar_marco_de(e);
+        }
+
+        _quitar_tabla(tp);
+    }
+
+    pthread_mutex_unlock(&mutex_memoria);
+}
+
+// TRUNCATE: Storage cambió los bloques del File:Tag; las copias del pool
+// compartido dejan de valer (las páginas locales se manejan como siempre)
+void memoria_truncado(file_tag_t ft) {
+    memoria_compartida_invalidar_ft(ft);
+}
+
+// ---------------------------------------------------------------------------
+// Writeback en segundo plano
+// ---------------------------------------------------------------------------
+static int _cmp_dirty_desde(const void* a, const void* b) {
+    const t_etp* ea = *(t_etp* const*)a;
+    const t_etp* eb = *(t_etp* const*)b;
+    if (ea->dirty_desde < eb->dirty_desde) return -1;
+    if (ea->dirty_desde > eb->dirty_desde) return 1;
+    return 0;
+}
+
+int memoria_writeback_pasada(
+    int      fd_storage,
+    uint32_t ratio_dirty,
+    uint32_t edad_ms,
+    uint32_t lote
+) {
+    if (fd_storage < 0 || lote == 0) return 0;
+
+    _tomar_mutex_memoria();
+
+    if (!marcos_fisicos || CANT_MARCOS == 0) {
+        pthread_mutex_unlock(&mutex_memoria);
+        return 0;
+    }
+
+    // 1) Relevar páginas dirty residentes que no estén ya en vuelo
+    t_etp** dirty = malloc(sizeof(t_etp*) * CANT_MARCOS);
+    uint32_t cant_dirty = 0;
+
+    for (int i = 0; i < (int)CANT_MARCOS; i++) {
+        t_marco* m = list_get(marcos_fisicos, i);
+        t_etp*   e = m->ocupado ? m->etp_asociada : NULL;
+        if (e && e->presencia && e->dirty && !e->en_writeback &&
+            (list_is_empty(g_ft_retenidos) || !_ft_retenido(e->ft))) {
+            dirty[cant_dirty++] = e;
+        }
+    }
+
+    // 2) Decidir si hay que persistir: por ratio de marcos dirty o por antigüedad
+    unsigned long ahora   = _now_ticks();
+    unsigned long edad_ns = (unsigned long)edad_ms * 1000000ul;
+    int por_ratio = (ratio_dirty > 0) && (cant_dirty * 100 >= ratio_dirty * CANT_MARCOS);
+
+    qsort(dirty, cant_dirty, sizeof(t_etp*), _cmp_dirty_desde);
+
+    uint32_t n = 0;
+    while (n < cant_dirty && n < lote) {
+        int vieja = (edad_ms > 0) && (ahora - dirty[n]->dirty_desde >= edad_ns);
+        if (!por_ratio && !vieja) break; // ordenadas: las siguientes son más nuevas
+        n++;
+    }
+
+    if (n == 0) {
+        pthread_mutex_unlock(&mutex_memoria);
+        free(dirty);
+        return 0;
+    }
+
+    // 3) Copiar el contenido de las elegidas y marcarlas en vuelo
+    char*               copia     = malloc((size_t)n * BLOCK_SIZE);
+    uint32_t*           versiones = malloc(sizeof(uint32_t) * n);
+    t_bloque_escritura* bloques   = calloc(n, sizeof(t_bloque_escritura));
+
+    for (uint32_t i = 0; i < n; i++) {
+        t_etp* e   = dirty[i];
+        char*  dst = copia + (size_t)i * BLOCK_SIZE;
+        memcpy(dst, (char*)memoria_principal + ((size_t)e->nro_marco * BLOCK_SIZE), BLOCK_SIZE);
+
+        bloques[i].ft       = e->ft;
+        bloques[i].block_id = e->id_bloque_storage;
+        bloques[i].query_id = e->query_id;
+        bloques[i].origen   = dst;
+        bloques[i].size     = BLOCK_SIZE;
+        if (_rango_parcial(e)) {
+            bloques[i].parcial = 1;
+            bloques[i].offset  = e->dirty_ini;
+            bloques[i].origen  = dst + e->dirty_ini;
+            bloques[i].size    = e->dirty_fin - e->dirty_ini;
+        }
+
+        versiones[i]    = e->version;
+        e->en_writeback = 1;
+    }
+
+    pthread_mutex_unlock(&mutex_memoria);
+
+    // 4) Enviar el lote a Storage fuera del lock
+    int rc = storage_io_write_blocks(bloques, (int)n, fd_storage, g_logger);
+
+    // 5) Limpiar solo las páginas que no se volvieron a escribir mientras tanto
+    int limpiadas = 0;
+    _tomar_mutex_memoria();
+    for (uint32_t i = 0; i < n; i++) {
+        t_etp* e = dirty[i];
+        e->en_writeback = 0;
+        if (bloques[i].ok) {
+            _contar_flush(e);
+            memoria_compartida_invalidar(e->ft, e->id_bloque_storage);
+        }
+        if (bloques[i].ok && e->presencia && e->dirty && e->version == versiones[i]) {
+            _marcar_limpia(e);
+            limpiadas++;
         }
     }
 
+    // 6) Las páginas de una Query que terminó mientras estaban en vuelo
+    //    esperaban a este lote para recolectarse
+    uint32_t etps_liberadas   = 0;
+    uint32_t tablas_liberadas = 0;
+    _barrer_diferidas(NULL, &etps_liberadas, &tablas_liberadas);
+
+    pthread_cond_broadcast(&cond_writeback);
     pthread_mutex_unlock(&mutex_memoria);
 
+    if (g_logger && (etps_liberadas > 0 || tablas_liberadas > 0)) {
+        log_debug(g_logger, "[MEM] GC diferido: %u ETPs y %u tablas liberadas tras el writeback",
+                  etps_liberadas, tablas_liberadas);
+    }
+
     if (g_logger) {
-        log_info(
+        log_debug(
             g_logger,
-            "[MEM] Liberación implícita de Q=%u completa (sin persistir).",
-            query_id
+            "[MEM] Writeback: %d/%u páginas persistidas (dirty=%u/%u marcos)",
+            limpiadas,
+            n,
+            cant_dirty,
+            CANT_MARCOS
         );
-    } else {
-        fprintf(stderr, "[MEM] Liberación implícita de Q=%u completa.\n", query_id);
     }
+
+    free(bloques);
+    free(versiones);
+    free(copia);
+    free(dirty);
+
+    return (rc < 0) ? -1 : limpiadas;
 }
 
 // ---------------------------------------------------------------------------
 // PC por Query
 // ---------------------------------------------------------------------------
-static t_query_pc* _buscar_qpc(uint32_t query_id) {
-    if (!g_queries_pc) return NULL;
-    for (int i = 0; i < list_size(g_queries_pc); i++) {
-        t_query_pc* q = list_get(g_queries_pc, i);
-        if (q->query_id == query_id) return q;
-    }
-    return NULL;
-}
-
 void memoria_registrar_pc(uint32_t query_id, uint32_t pc) {
-    pthread_mutex_lock(&mutex_memoria);
+    _tomar_mutex_memoria();
 
-    if (!g_queries_pc)
-        g_queries_pc = list_create();
+    if (!g_queries)
+        g_queries = list_create();
 
-    t_query_pc* q = _buscar_qpc(query_id);
-    if (!q) {
-        q = malloc(sizeof(*q));
-        q->query_id = query_id;
-        q->pc       = pc;
-        list_add(g_queries_pc, q);
-    } else {
-        q->pc = pc;
-    }
+    t_query_mem* q = _buscar_query(query_id, 1);
+    q->pc = pc;
 
     pthread_mutex_unlock(&mutex_memoria);
 }
 
 uint32_t query_pc_actual(uint32_t query_id) {
-    pthread_mutex_lock(&mutex_memoria);
+    _tomar_mutex_memoria();
 
     uint32_t pc = 0;
-    t_query_pc* q = _buscar_qpc(query_id);
+    t_query_mem* q = _buscar_query(query_id, 0);
     if (q) pc = q->pc;
 
     pthread_mutex_unlock(&mutex_memoria);
     return pc;
 }
+
+// ---------------------------------------------------------------------------
+// Métricas
+// ---------------------------------------------------------------------------
+int memoria_resumen_query(uint32_t query_id, t_query_end_metricas* out) {
+    _tomar_mutex_memoria();
+
+    t_query_mem* q = _buscar_query(query_id, 0);
+    if (q) *out = q->met;
+
+    pthread_mutex_unlock(&mutex_memoria);
+    return q != NULL;
+}
+
+void memoria_reporte(FILE* f) {
+    // El texto se arma en memoria con el mutex tomado y se escribe recién
+    // después de soltarlo: un cliente lento del socket de métricas no puede
+    // frenar a las Queries
+    char*  texto = NULL;
+    size_t largo = 0;
+    FILE*  out   = open_memstream(&texto, &largo);
+    if (!out) return;
+
+    _tomar_mutex_memoria();
+
+    // 1) Ocupación de la memoria principal
+    uint32_t ocupados = 0, sucios = 0, aliases = 0;
+    for (int i = 0; marcos_fisicos && i < (int)CANT_MARCOS; i++) {
+        t_marco* m = list_get(marcos_fisicos, i);
+        if (!m->ocupado) continue;
+        ocupados++;
+        if (m->etp_asociada && m->etp_asociada->dirty) sucios++;
+        for (t_etp* a = m->etp_asociada ? m->etp_asociada->alias_primero : NULL; a; a = a->alias_sig) {
+            aliases++;
+        }
+    }
+    fprintf(out, "algoritmo %s\nmarcos %u\nmarcos_ocupados %u\nmarcos_dirty %u\nalias %u\n",
+            g_politica->nombre, CANT_MARCOS, ocupados, sucios, aliases);
+
+    // 2) Queries con estado en este Worker
+    for (int i = 0; g_queries && i < list_size(g_queries); i++) {
+        t_query_mem* q = list_get(g_queries, i);
+        fprintf(out, "query %u residentes=%u hits=%llu misses=%llu reemplazos=%llu "
+                     "reemplazos_sucios=%llu flushes=%llu pagein_us=%llu pagein_max_us=%llu retardo_us=%llu\n",
+                q->query_id, q->cant_residentes,
+                (unsigned long long)q->met.hits,
+                (unsigned long long)q->met.misses,
+                (unsigned long long)q->met.reemplazos,
+                (unsigned long long)q->met.reemplazos_sucios,
+                (unsigned long long)q->met.flushes,
+                (unsigned long long)q->met.pagein_us,
+                (unsigned long long)q->met.pagein_max_us,
+                (unsigned long long)q->met.retardo_us);
+    }
+
+    // 3) File:Tag con tabla de páginas viva
+    for (int i = 0; tablas_de_paginas && i < list_size(tablas_de_paginas); i++) {
+        t_tabla_paginas* tp = list_get(tablas_de_paginas, i);
+        fprintf(out, "filetag %s:%s paginas=%d hits=%llu misses=%llu desalojos=%llu flushes=%llu\n",
+                tp->ft.file, tp->ft.tag, list_size(tp->entradas),
+                (unsigned long long)tp->met_hits,
+                (unsigned long long)tp->met_misses,
+                (unsigned long long)tp->met_desalojos,
+                (unsigned long long)tp->met_flushes);
+    }
+
+    pthread_mutex_unlock(&mutex_memoria);
+
+    fclose(out);
+    fwrite(texto, 1, largo, f);
+    free(texto);
+}
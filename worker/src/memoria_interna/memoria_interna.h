@@ -9,14 +9,17 @@
 #define MEMORIA_INTERNA_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <commons/log.h>
 #include <commons/collections/list.h>
 #include "../query_interpreter/instrucciones_parser.h"
+#include "../../../utils/src/proto.h"   // t_query_end_metricas
 
 // ---------------------------------------------------------------------------
 // Estructuras públicas
 // ---------------------------------------------------------------------------
-typedef struct {
+typedef struct t_etp {
     file_tag_t      ft;
     uint32_t        nro_pagina;
     uint32_t        nro_marco;
@@ -25,26 +28,82 @@ typedef struct {
     uint8_t         dirty;
     uint32_t        query_id;
     unsigned long   ultimo_uso;
+    unsigned long   dirty_desde;   // tick en que la página pasó a dirty (0 = limpia)
+    uint32_t        version;       // se incrementa en cada WRITE sobre la página
+    uint32_t        dirty_ini;     // rango sucio [dirty_ini, dirty_fin) dentro de la página
+    uint32_t        dirty_fin;
+    uint8_t         en_writeback;  // 1 mientras el flusher tiene una copia en vuelo
+    uint8_t         en_pagein;     // 1 mientras su bloque viaja desde Storage (sin marco instalado)
+    uint8_t         prefetch;      // traída por read-ahead y todavía no accedida
+    void*           pol_nodo;      // estado de la política de reemplazo (NULL si no usa)
+    struct t_etp*   q_ant;         // residentes de la Query dueña (lista intrusiva)
+    struct t_etp*   q_sig;
+    struct t_etp*   alias_de;      // != NULL: comparte el marco de esta ETP (TAG, copy-on-write)
+    struct t_etp*   alias_sig;     // siguiente alias de la misma dueña
+    struct t_etp*   alias_primero; // en la dueña: primer alias que comparte su marco
 } t_etp;
 
 typedef struct {
     file_tag_t ft;
     t_list*    entradas;
+
+    // Read-ahead: detección de acceso secuencial por File:Tag
+    uint32_t   ra_siguiente;   // página esperada en el próximo miss secuencial
+    uint32_t   ra_racha;       // misses secuenciales consecutivos
+    uint32_t   ra_ventana;     // páginas prefetcheadas en el último miss secuencial
+    uint32_t   ra_emitidas;    // páginas traídas por read-ahead (muestra actual)
+    uint32_t   ra_usadas;      // de esas, cuántas se accedieron después
+    uint32_t   ra_limite;      // primera página que Storage rechazó (fin de archivo)
+    uint8_t    ra_suspendido;  // 1 si la precisión cayó bajo el mínimo
+
+    // Métricas del File:Tag (ver memoria_reporte)
+    uint64_t   met_hits;
+    uint64_t   met_misses;
+    uint64_t   met_desalojos;  // páginas de este File:Tag elegidas como víctima
+    uint64_t   met_flushes;    // páginas persistidas en Storage
 } t_tabla_paginas;
 
 typedef struct {
     uint32_t nro_marco;
     uint8_t  ocupado;
     t_etp*   etp_asociada;
+    uint64_t hash;           // hash del bloque al cargarlo (dedupe)
 } t_marco;
 
 // ---------------------------------------------------------------------------
 // API pública
 // ---------------------------------------------------------------------------
-int      memoria_init(uint32_t tam_memoria,uint32_t block_size,const char* algoritmo,t_log* logger);
+int      memoria_init(size_t tam_memoria,uint32_t block_size,const char* algoritmo,t_log* logger);
 
 uint32_t memoria_get_block_size(void);
 
+// Asignador de la memoria principal (MALLOC, MMAP o HUGETLB) y nodo NUMA
+// (-1 = sin ligar). Debe llamarse antes de memoria_init.
+void     memoria_configurar_asignador(const char* asignador, int nodo_numa);
+
+// Traza de accesos: capacidad del ring de eventos que drena el hilo de
+// traza (0 = loguear en línea, como antes) y archivo donde grabar los
+// accesos a páginas para worker_bench ("" = no). Llamar antes de memoria_init.
+void     memoria_configurar_traza(uint32_t capacidad, const char* path_paginas);
+
+// TAG: el destino comparte los marcos limpios del origen (copy-on-write)
+void     memoria_configurar_compartir_tag(int habilitado);
+
+// Dedupe: un miss cuyo contenido ya está en otro marco limpio lo comparte
+// (copy-on-write). Llamar antes de memoria_init.
+void     memoria_configurar_dedup(int habilitado);
+
+// Pool de bloques limpios compartido entre los Workers del host (shm_open).
+// nombre vacío = deshabilitado. Llamar antes de memoria_init.
+void     memoria_configurar_compartida(const char* nombre, uint32_t cant_bloques);
+
+// Escritura parcial: persistir solo el rango sucio de cada página con
+// OP_WRITE_PARTIAL (requiere un Storage que lo soporte)
+void     memoria_configurar_escritura_parcial(int habilitada);
+
+// Read-ahead secuencial: max_paginas = 0 lo deshabilita
+void     memoria_configurar_readahead(uint32_t max_paginas, uint32_t precision_min);
+
 int      memoria_escribir(file_tag_t ft,uint32_t dir_base,uint32_t size,const char* data,int query_id,int fd_storage,t_log* logger,uint32_t retardo_ms);
 
 int      memoria_leer(file_tag_t ft,uint32_t dir_base,uint32_t size,char* destino,int query_id,int fd_storage,t_log* logger,uint32_t retardo_ms);
@@ -54,12 +113,40 @@ int      memoria_flush(file_tag_t ft,int fd_storage,t_log* logger);
 void     memoria_destroy(void);
 
 void     memoria_flush_global(void);
-void     memoria_flush_implicito(uint32_t query_id);
+// resumen (opcional): métricas de la Query hasta el desalojo, flushes incluidos
+void     memoria_flush_implicito(uint32_t query_id, int fd_storage, t_query_end_metricas* resumen);
 
 // liberar recursos de la Query sin persistir (END normal)
 void     memoria_liberar_implicito(uint32_t query_id);
 
+// DELETE: liberar marcos sin persistir y borrar la tabla del File:Tag
+void     memoria_descartar(file_tag_t ft);
+
+// TRUNCATE: invalidar las copias del File:Tag en el pool compartido
+void     memoria_truncado(file_tag_t ft);
+
+// Antes de un DELETE/TRUNCATE: esperar las páginas del File:Tag que el
+// flusher tiene en vuelo y no dejar salir otras hasta soltarlo (así Storage
+// no recibe un WRITE viejo después del DELETE/TRUNCATE)
+void     memoria_retener_writeback(file_tag_t ft);
+void     memoria_soltar_writeback(file_tag_t ft);
+
+// TAG: mapear en el destino las páginas limpias y residentes del origen
+void     memoria_tag(file_tag_t origen, file_tag_t destino, int query_id);
+
+// Writeback en segundo plano: persiste hasta 'lote' páginas dirty si el % de
+// marcos dirty supera ratio_dirty o si alguna página lleva más de edad_ms sucia.
+// Devuelve páginas limpiadas, o -1 si se perdió la conexión con Storage.
+int      memoria_writeback_pasada(int fd_storage, uint32_t ratio_dirty, uint32_t edad_ms, uint32_t lote);
+
 void     memoria_registrar_pc(uint32_t query_id, uint32_t pc);
 uint32_t query_pc_actual(uint32_t query_id);
 
+// Métricas de la Query (hits, misses, reemplazos, ...) desde que llegó a
+// este Worker. Devuelve 0 si no tiene estado. Llamar antes de liberarla.
+int      memoria_resumen_query(uint32_t query_id, t_query_end_metricas* out);
+
+// Estado de la memoria, por Query y por File:Tag, en texto (endpoint de métricas)
+void     memoria_reporte(FILE* f);
+
 #endif // MEMORIA_INTERNA_H
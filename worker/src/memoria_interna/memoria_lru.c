@@ -1,18 +1,80 @@
 #include "memoria_lru.h"
+#include <stdlib.h>
 
-int memoria_lru_seleccionar_marco(t_list* marcos_fisicos, uint32_t cant_marcos) {
+// Tick de último uso por marco (0 = marco sin página para LRU)
+static t_etp**        g_lru_etp     = NULL;
+static unsigned long* g_lru_tick    = NULL;
+static unsigned long  g_lru_reloj   = 0;
+static uint32_t       g_cant_marcos = 0;
+
+static void _lru_destroy(void) {
+    free(g_lru_etp);
+    free(g_lru_tick);
+    g_lru_etp     = NULL;
+    g_lru_tick    = NULL;
+    g_cant_marcos = 0;
+}
+
+static void _lru_init(uint32_t cant_marcos) {
+    _lru_destroy();
+    g_cant_marcos = cant_marcos;
+    g_lru_reloj   = 0;
+    if (cant_marcos > 0) {
+        g_lru_etp  = calloc(cant_marcos, sizeof(t_etp*));
+        g_lru_tick = calloc(cant_marcos, sizeof(unsigned long));
+    }
+}
+
+static void _lru_tocar(t_etp* etp) {
+    if (!g_lru_etp || etp->nro_marco >= g_cant_marcos) return;
+    g_lru_tick[etp->nro_marco] = ++g_lru_reloj;
+}
+
+static void _lru_on_insert(t_etp* etp, int es_prefetch) {
+    if (!g_lru_etp || etp->nro_marco >= g_cant_marcos) return;
+    g_lru_etp[etp->nro_marco] = etp;
+    _lru_tocar(etp);
+}
+
+static void _lru_on_remove(t_etp* etp, int por_reemplazo) {
+    if (!g_lru_etp || etp->nro_marco >= g_cant_marcos) return;
+    if (g_lru_etp[etp->nro_marco] != etp) return;
+    g_lru_etp[etp->nro_marco]  = NULL;
+    g_lru_tick[etp->nro_marco] = 0;
+}
+
+static void _lru_on_forget(t_etp* etp) {
+    // Sin estado por ETP
+}
+
+static int _lru_retiene(const t_etp* etp) {
+    return 0;
+}
+
+static int _lru_pick_victim(t_etp* entrante) {
     int elegido = -1;
     unsigned long tick_min = 0;
 
-    for (int i = 0; i < (int)cant_marcos; i++) {
-        t_marco* m = list_get(marcos_fisicos, i);
-        if (!m->ocupado || !m->etp_asociada) continue;
+    for (int i = 0; i < (int)g_cant_marcos; i++) {
+        if (!g_lru_etp[i]) continue;
 
-        if (elegido < 0 || m->etp_asociada->ultimo_uso < tick_min) {
+        if (elegido < 0 || g_lru_tick[i] < tick_min) {
             elegido  = i;
-            tick_min = m->etp_asociada->ultimo_uso;
+            tick_min = g_lru_tick[i];
         }
     }
 
     return elegido;
 }
+
+const t_politica_reemplazo g_politica_lru = {
+    .nombre      = "LRU",
+    .init        = _lru_init,
+    .destroy     = _lru_destroy,
+    .on_access   = _lru_tocar,
+    .on_insert   = _lru_on_insert,
+    .on_remove   = _lru_on_remove,
+    .on_forget   = _lru_on_forget,
+    .retiene     = _lru_retiene,
+    .pick_victim = _lru_pick_victim
+};
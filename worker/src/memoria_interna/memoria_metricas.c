@@ -0,0 +1,226 @@
+// ============================================================================
+// WORKER - memoria_metricas.c
+// PASO A PASO GENERAL
+// 1) Contadores y histogramas son atómicos relajados: se suman desde la
+//    Query, el flusher y Storage sin tomar ningún mutex
+// 2) Histograma: el bucket i cuenta latencias en [2^(i-1), 2^i) us; los
+//    percentiles se informan como la cota superior de su bucket
+// 3) Un hilo acepta conexiones en el socket Unix y escribe el reporte
+//    (globales + detalle de memoria_interna) en cada una
+// ============================================================================
+
+#include "memoria_metricas.h"
+#include "memoria_interna.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define LAT_BUCKETS 24   // el último junta todo lo que pasa de ~4 s
+
+typedef struct {
+    atomic_uint_fast64_t buckets[LAT_BUCKETS];
+    atomic_uint_fast64_t cantidad;
+    atomic_uint_fast64_t suma_us;
+    atomic_uint_fast64_t max_us;
+} t_histograma;
+
+static atomic_uint_fast64_t g_contadores[MET_CANT];
+static t_histograma         g_latencias[LAT_CANT];
+
+static const char* g_nombres_met[MET_CANT] = {
+    "hits", "misses", "reemplazos", "reemplazos_sucios", "flushes",
+    "readahead", "cow", "dedup", "compartida", "bloques_leidos", "bloques_escritos",
+    "bytes_leidos", "bytes_escritos"
+};
+
+static const char* g_nombres_lat[LAT_CANT] = {
+    "lat_pagein_us", "lat_storage_lectura_us", "lat_storage_escritura_us"
+};
+
+// Endpoint
+static pthread_t    g_hilo;
+static int          g_fd_escucha = -1;
+static volatile int g_activo     = 0;
+static uint32_t     g_worker_id  = 0;
+static char         g_path[108];   // sizeof(sun_path)
+
+// ---------------------------------------------------------------------------
+// Contadores
+// ---------------------------------------------------------------------------
+void memoria_metricas_sumar(t_metrica m, uint64_t n) {
+    if (m >= MET_CANT) return;
+    atomic_fetch_add_explicit(&g_contadores[m], n, memory_order_relaxed);
+}
+
+uint64_t memoria_metricas_ahora_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static int _bucket(uint64_t us) {
+    int b = 0;
+    while (us > 0 && b < LAT_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void memoria_metricas_latencia(t_latencia l, uint64_t us) {
+    if (l >= LAT_CANT) return;
+    t_histograma* h = &g_latencias[l];
+
+    atomic_fetch_add_explicit(&h->buckets[_bucket(us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->cantidad, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->suma_us, us, memory_order_relaxed);
+
+    uint_fast64_t max = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+    while (us > max &&
+           !atomic_compare_exchange_weak_explicit(&h->max_us, &max, us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Reporte
+// ---------------------------------------------------------------------------
+static uint64_t _percentil(const uint64_t* buckets, uint64_t total, uint32_t pct) {
+    if (total == 0) return 0;
+
+    uint64_t objetivo = (total * pct + 99) / 100;
+    uint64_t acumulado = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+        acumulado += buckets[b];
+        if (acumulado >= objetivo) return b == 0 ? 0 : (1ull << b) - 1;
+    }
+    return (1ull << (LAT_BUCKETS - 1)) - 1;
+}
+
+void memoria_metricas_escribir(FILE* f) {
+    uint64_t v[MET_CANT];
+    for (int i = 0; i < MET_CANT; i++) {
+        v[i] = atomic_load_explicit(&g_contadores[i], memory_order_relaxed);
+        fprintf(f, "%s %llu\n", g_nombres_met[i], (unsigned long long)v[i]);
+    }
+
+    uint64_t accesos = v[MET_HITS] + v[MET_MISSES];
+    fprintf(f, "hit_ratio %.4f\n", accesos ? (double)v[MET_HITS] / (double)accesos : 0.0);
+
+    for (int l = 0; l < LAT_CANT; l++) {
+        t_histograma* h = &g_latencias[l];
+        uint64_t buckets[LAT_BUCKETS];
+        for (int b = 0; b < LAT_BUCKETS; b++) {
+            buckets[b] = atomic_load_explicit(&h->buckets[b], memory_order_relaxed);
+        }
+        uint64_t cant = atomic_load_explicit(&h->cantidad, memory_order_relaxed);
+        uint64_t suma = atomic_load_explicit(&h->suma_us, memory_order_relaxed);
+        uint64_t max  = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+
+        fprintf(f, "%s cant=%llu prom=%llu p50<=%llu p95<=%llu p99<=%llu max=%llu\n",
+                g_nombres_lat[l],
+                (unsigned long long)cant,
+                (unsigned long long)(cant ? suma / cant : 0),
+                (unsigned long long)_percentil(buckets, cant, 50),
+                (unsigned long long)_percentil(buckets, cant, 95),
+                (unsigned long long)_percentil(buckets, cant, 99),
+                (unsigned long long)max);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Endpoint
+// ---------------------------------------------------------------------------
+static void* _servir_loop(void* arg) {
+    (void)arg;
+
+    // Un cliente que corta antes de leer todo no tiene que tirar al Worker:
+    // con SIGPIPE bloqueado en este hilo el write solo devuelve EPIPE
+    sigset_t mascara;
+    sigemptyset(&mascara);
+    sigaddset(&mascara, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mascara, NULL);
+
+    while (g_activo) {
+        int fd = accept(g_fd_escucha, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;   // socket cerrado por memoria_metricas_detener
+        }
+
+        FILE* f = fdopen(fd, "w");
+        if (!f) {
+            close(fd);
+            continue;
+        }
+
+        fprintf(f, "worker %u\n", g_worker_id);
+        memoria_metricas_escribir(f);
+        memoria_reporte(f);
+        fclose(f);
+    }
+    return NULL;
+}
+
+int memoria_metricas_servir(const char* path, uint32_t worker_id, t_log* logger) {
+    if (!path || path[0] == '\0') return 0;
+
+    g_worker_id = worker_id;
+
+    struct sockaddr_un dir;
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(dir.sun_path)) {
+        if (logger) log_warning(logger, "[MEM] STATS_SOCKET demasiado largo: '%s'. Sin métricas.", path);
+        return 0;
+    }
+    strcpy(dir.sun_path, path);
+
+    // 1) Socket de escucha (se pisa un socket viejo de una corrida anterior)
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return 0;
+
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&dir, sizeof(dir)) != 0 || listen(fd, 4) != 0) {
+        if (logger) log_warning(logger, "[MEM] No pude escuchar en STATS_SOCKET '%s' (%s).",
+                                path, strerror(errno));
+        close(fd);
+        return 0;
+    }
+
+    // 2) Hilo que atiende las conexiones
+    g_fd_escucha = fd;
+    g_activo     = 1;
+    strcpy(g_path, path);
+
+    if (pthread_create(&g_hilo, NULL, _servir_loop, NULL) != 0) {
+        g_activo = 0;
+        close(fd);
+        g_fd_escucha = -1;
+        unlink(path);
+        return 0;
+    }
+
+    if (logger) log_info(logger, "[MEM] Métricas disponibles en %s", path);
+    return 1;
+}
+
+void memoria_metricas_detener(void) {
+    if (!g_activo) return;
+
+    g_activo = 0;
+    shutdown(g_fd_escucha, SHUT_RDWR);   // despierta al accept
+    pthread_join(g_hilo, NULL);
+
+    close(g_fd_escucha);
+    g_fd_escucha = -1;
+    unlink(g_path);
+}
@@ -0,0 +1,63 @@
+// ============================================================================
+// WORKER - memoria_metricas.h
+// PASO A PASO GENERAL
+// 1) Contadores globales de memoria y de Storage (hits, misses, reemplazos,
+//    flushes, bloques y bytes transferidos), sin lock
+// 2) Histogramas de latencia (page-in, lectura y escritura a Storage) en
+//    buckets de potencias de 2 en microsegundos
+// 3) Endpoint local por socket Unix (clave STATS_SOCKET): cada conexión
+//    recibe un reporte de texto y se cierra
+//    (ej: socat - UNIX-CONNECT:/tmp/worker1.stats)
+// El detalle por Query y por File:Tag lo lleva memoria_interna.c
+// (ver memoria_reporte y memoria_resumen_query)
+// ============================================================================
+
+#ifndef MEMORIA_METRICAS_H
+#define MEMORIA_METRICAS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <commons/log.h>
+
+// ---------------------------------------------------------------------------
+// Contadores
+// ---------------------------------------------------------------------------
+typedef enum {
+    MET_HITS,                // accesos con la página residente
+    MET_MISSES,              // accesos que necesitaron page-in
+    MET_REEMPLAZOS,          // páginas desalojadas para hacer lugar
+    MET_REEMPLAZOS_SUCIOS,   // de esas, cuántas hubo que persistir antes
+    MET_FLUSHES,             // páginas persistidas (víctimas, COMMIT, END, writeback)
+    MET_READAHEAD,           // páginas traídas en lote (read-ahead y rangos)
+    MET_COW,                 // copias por WRITE sobre un marco compartido
+    MET_DEDUP,               // misses resueltos compartiendo un marco igual
+    MET_COMPARTIDA,          // bloques leídos de la memoria compartida del host
+    MET_BLOQUES_LEIDOS,      // READ_BLOCK exitosos contra Storage
+    MET_BLOQUES_ESCRITOS,    // WRITE_BLOCK / WRITE_PARTIAL exitosos
+    MET_BYTES_LEIDOS,
+    MET_BYTES_ESCRITOS,
+    MET_CANT
+} t_metrica;
+
+typedef enum {
+    LAT_PAGEIN,              // resolver un miss (incluye flush de la víctima)
+    LAT_STORAGE_LECTURA,     // READ_BLOCK (en lote: promedio por bloque)
+    LAT_STORAGE_ESCRITURA,   // WRITE_* hasta el OK (en lote: promedio por bloque)
+    LAT_CANT
+} t_latencia;
+
+void     memoria_metricas_sumar(t_metrica m, uint64_t n);
+void     memoria_metricas_latencia(t_latencia l, uint64_t us);
+uint64_t memoria_metricas_ahora_us(void);
+
+// Escribe los contadores globales y los histogramas
+void     memoria_metricas_escribir(FILE* f);
+
+// ---------------------------------------------------------------------------
+// Endpoint (socket Unix)
+// ---------------------------------------------------------------------------
+// path vacío o NULL: no se levanta. Devuelve 1 si quedó escuchando.
+int  memoria_metricas_servir(const char* path, uint32_t worker_id, t_log* logger);
+void memoria_metricas_detener(void);
+
+#endif // MEMORIA_METRICAS_H
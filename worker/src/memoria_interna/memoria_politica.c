@@ -0,0 +1,52 @@
+// ============================================================================
+// WORKER - memoria_politica.c
+// PASO A PASO GENERAL
+// 1) Registra las políticas de reemplazo disponibles
+// 2) Resuelve el nombre configurado (con sus alias) a una política
+// ============================================================================
+
+#include "memoria_politica.h"
+#include "memoria_lru.h"
+#include "memoria_clockm.h"
+#include "memoria_arc.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static const t_politica_reemplazo* const g_politicas[] = {
+    &g_politica_lru,
+    &g_politica_clockm,
+    &g_politica_arc,
+    NULL
+};
+
+typedef struct {
+    const char*                 alias;
+    const t_politica_reemplazo* politica;
+} t_alias_politica;
+
+static const t_alias_politica g_alias[] = {
+    { "CLOCKM", &g_politica_clockm },
+    { "CLOCK",  &g_politica_clockm },
+    { NULL,     NULL }
+};
+
+const t_politica_reemplazo* memoria_politica_buscar(const char* nombre) {
+    if (!nombre) return NULL;
+
+    // 1) Nombre exacto
+    for (int i = 0; g_politicas[i]; i++) {
+        if (strcmp(g_politicas[i]->nombre, nombre) == 0) return g_politicas[i];
+    }
+
+    // 2) Alias históricos
+    for (int i = 0; g_alias[i].alias; i++) {
+        if (strcmp(g_alias[i].alias, nombre) == 0) return g_alias[i].politica;
+    }
+
+    return NULL;
+}
+
+const t_politica_reemplazo* const* memoria_politica_todas(void) {
+    return g_politicas;
+}
@@ -0,0 +1,43 @@
+// ============================================================================
+// WORKER - memoria_politica.h
+// PASO A PASO GENERAL
+// 1) Define la interfaz común de las políticas de reemplazo
+// 2) Cada política (LRU, CLOCK-M, ARC) guarda su propio estado por marco/ETP
+//    y no conoce las estructuras internas de memoria_interna
+// 3) Expone la búsqueda de una política por nombre (ALGORITMO_REEMPLAZO)
+// ============================================================================
+
+#ifndef MEMORIA_POLITICA_H
+#define MEMORIA_POLITICA_H
+
+#include <stdint.h>
+#include "memoria_interna.h"
+
+// ---------------------------------------------------------------------------
+// Interfaz de política
+// - Todas las llamadas se hacen con mutex_memoria tomado.
+// - on_insert recibe la ETP con nro_marco ya asignado.
+// ---------------------------------------------------------------------------
+typedef struct {
+    const char* nombre;
+
+    void (*init)(uint32_t cant_marcos);
+    void (*destroy)(void);
+
+    void (*on_access)(t_etp* etp);                     // hit sobre página residente
+    void (*on_insert)(t_etp* etp, int es_prefetch);    // la página ocupó un marco
+    void (*on_remove)(t_etp* etp, int por_reemplazo);  // la página dejó su marco
+    void (*on_forget)(t_etp* etp);                     // la ETP se destruye
+    int  (*retiene)(const t_etp* etp);                 // 1 si guarda historia de una ETP sin marco
+                                                       // (el GC de metadatos no la libera)
+
+    int  (*pick_victim)(t_etp* entrante);              // marco víctima o -1
+} t_politica_reemplazo;
+
+// Devuelve NULL si el nombre no corresponde a ninguna política
+const t_politica_reemplazo* memoria_politica_buscar(const char* nombre);
+
+// Lista de políticas disponibles terminada en NULL (para el bench)
+const t_politica_reemplazo* const* memoria_politica_todas(void);
+
+#endif // MEMORIA_POLITICA_H
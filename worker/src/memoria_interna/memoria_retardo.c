@@ -0,0 +1,78 @@
+// ============================================================================
+// WORKER - memoria_retardo.c
+// PASO A PASO GENERAL
+// 1) Resolver el modo pedido (SIMULADO / VIRTUAL / NINGUNO)
+// 2) Calcular el costo de N accesos
+// 3) SIMULADO: correr el deadline del hilo y dormir hasta él con
+//    clock_nanosleep(TIMER_ABSTIME). Si el hilo ya estaba atrasado (por
+//    ejemplo esperando a Storage) el deadline arranca desde "ahora"
+// 4) Dentro de una corrutina el deadline es el de su Query y la espera
+//    suspende la corrutina en lugar de dormir el hilo
+// ============================================================================
+
+#include "memoria_retardo.h"
+#include "../query_interpreter/corrutinas.h"
+
+#include <string.h>
+#include <time.h>
+
+static t_retardo_modo g_modo = RETARDO_SIMULADO;
+
+static _Thread_local struct timespec g_deadline = { 0, 0 };
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static int _antes(const struct timespec* a, const struct timespec* b) {
+    if (a->tv_sec != b->tv_sec) return a->tv_sec < b->tv_sec;
+    return a->tv_nsec < b->tv_nsec;
+}
+
+static void _sumar_us(struct timespec* ts, uint64_t us) {
+    ts->tv_sec  += (time_t)(us / 1000000u);
+    ts->tv_nsec += (long)(us % 1000000u) * 1000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+void memoria_retardo_configurar(const char* modo, t_log* logger) {
+    // 1) Resolver modo
+    g_modo = RETARDO_SIMULADO;
+    if (modo && strcmp(modo, "VIRTUAL") == 0) {
+        g_modo = RETARDO_VIRTUAL;
+    } else if (modo && strcmp(modo, "NINGUNO") == 0) {
+        g_modo = RETARDO_NINGUNO;
+    } else if (modo && strcmp(modo, "SIMULADO") != 0) {
+        if (logger) log_warning(logger, "[MEM] RETARDO_MODO '%s' desconocido, usando SIMULADO.", modo);
+    }
+}
+
+t_retardo_modo memoria_retardo_modo(void) {
+    return g_modo;
+}
+
+uint64_t memoria_retardo_costo_us(uint32_t accesos, uint32_t retardo_ms) {
+    // 2) Costo de la operación
+    if (g_modo == RETARDO_NINGUNO) return 0;
+    return (uint64_t)accesos * retardo_ms * 1000u;
+}
+
+void memoria_retardo_pagar(uint64_t costo_us) {
+    if (g_modo != RETARDO_SIMULADO || costo_us == 0) return;
+
+    // 3) Deadline por hilo (o por corrutina)
+    struct timespec* deadline = corrutina_deadline();
+    if (!deadline) deadline = &g_deadline;
+
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    if (_antes(deadline, &ahora)) *deadline = ahora;
+    _sumar_us(deadline, costo_us);
+
+    corrutina_dormir_hasta(deadline);
+}
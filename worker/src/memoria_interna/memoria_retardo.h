@@ -0,0 +1,38 @@
+// ============================================================================
+// WORKER - memoria_retardo.h
+// PASO A PASO GENERAL
+// 1) Modelo de latencia de la memoria interna (clave RETARDO_MODO)
+// 2) Las operaciones cuentan accesos mientras tienen el mutex de memoria y
+//    recién pagan el retardo después de soltarlo
+// 3) El pago se hace contra un deadline por Query (del hilo, o de la
+//    corrutina que la ejecuta), así varios accesos seguidos no acumulan el
+//    error de cada sleep
+// ============================================================================
+
+#ifndef MEMORIA_RETARDO_H
+#define MEMORIA_RETARDO_H
+
+#include <stdint.h>
+#include <commons/log.h>
+
+typedef enum {
+    RETARDO_SIMULADO,   // duerme RETARDO_MEMORIA por acceso, fuera del mutex
+    RETARDO_VIRTUAL,    // solo contabiliza el tiempo por Query, no duerme
+    RETARDO_NINGUNO     // sin retardo ni contabilidad (perfil producción)
+} t_retardo_modo;
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+// modo: "SIMULADO" (default), "VIRTUAL" o "NINGUNO"
+void           memoria_retardo_configurar(const char* modo, t_log* logger);
+t_retardo_modo memoria_retardo_modo(void);
+
+// Microsegundos que corresponde cobrar por 'accesos' (0 en modo NINGUNO)
+uint64_t       memoria_retardo_costo_us(uint32_t accesos, uint32_t retardo_ms);
+
+// Paga 'costo_us' en el hilo (o corrutina) actual. Llamar SIN el mutex de
+// memoria tomado.
+void           memoria_retardo_pagar(uint64_t costo_us);
+
+#endif // MEMORIA_RETARDO_H
@@ -0,0 +1,100 @@
+// ============================================================================
+// WORKER - memoria_slab.c
+// PASO A PASO GENERAL
+// 1) Cada bloque es un único malloc con espacio para N objetos
+// 2) Los objetos libres se encadenan usando sus propios primeros bytes
+// 3) slab_alloc toma de la free-list; si está vacía, agrega un bloque
+// ============================================================================
+
+#include "memoria_slab.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct t_slab_libre {
+    struct t_slab_libre* sig;
+} t_slab_libre;
+
+typedef struct t_slab_bloque {
+    struct t_slab_bloque* sig;
+} t_slab_bloque;
+
+struct t_slab {
+    size_t         tam_objeto;
+    uint32_t       por_bloque;
+    t_slab_bloque* bloques;
+    t_slab_libre*  libres;
+    uint32_t       en_uso;
+};
+
+// El objeto tiene que poder alojar el puntero de la free-list y respetar
+// la alineación de cualquier tipo
+static size_t _alinear(size_t tam) {
+    size_t a = sizeof(max_align_t);
+    if (tam < sizeof(t_slab_libre)) tam = sizeof(t_slab_libre);
+    return (tam + a - 1) / a * a;
+}
+
+t_slab* slab_crear(size_t tam_objeto, uint32_t objetos_por_bloque) {
+    t_slab* slab = calloc(1, sizeof(t_slab));
+    if (!slab) return NULL;
+
+    slab->tam_objeto = _alinear(tam_objeto);
+    slab->por_bloque = objetos_por_bloque > 0 ? objetos_por_bloque : 64;
+    return slab;
+}
+
+static int _agregar_bloque(t_slab* slab) {
+    size_t cabecera = _alinear(sizeof(t_slab_bloque));
+    t_slab_bloque* b = malloc(cabecera + slab->tam_objeto * slab->por_bloque);
+    if (!b) return 0;
+
+    b->sig        = slab->bloques;
+    slab->bloques = b;
+
+    // Encadenar todos los objetos del bloque nuevo en la free-list
+    char* base = (char*)b + cabecera;
+    for (uint32_t i = slab->por_bloque; i > 0; i--) {
+        t_slab_libre* l = (t_slab_libre*)(base + (size_t)(i - 1) * slab->tam_objeto);
+        l->sig       = slab->libres;
+        slab->libres = l;
+    }
+    return 1;
+}
+
+void* slab_alloc(t_slab* slab) {
+    if (!slab) return NULL;
+    if (!slab->libres && !_agregar_bloque(slab)) return NULL;
+
+    t_slab_libre* l = slab->libres;
+    slab->libres = l->sig;
+    slab->en_uso++;
+
+    memset(l, 0, slab->tam_objeto);
+    return l;
+}
+
+void slab_free(t_slab* slab, void* obj) {
+    if (!slab || !obj) return;
+
+    t_slab_libre* l = (t_slab_libre*)obj;
+    l->sig       = slab->libres;
+    slab->libres = l;
+    slab->en_uso--;
+}
+
+void slab_destruir(t_slab* slab) {
+    if (!slab) return;
+
+    t_slab_bloque* b = slab->bloques;
+    while (b) {
+        t_slab_bloque* sig = b->sig;
+        free(b);
+        b = sig;
+    }
+    free(slab);
+}
+
+uint32_t slab_en_uso(const t_slab* slab) {
+    return slab ? slab->en_uso : 0;
+}
@@ -0,0 +1,27 @@
+// ============================================================================
+// WORKER - memoria_slab.h
+// PASO A PASO GENERAL
+// 1) Pool de objetos de tamaño fijo (ETPs, tablas de páginas)
+// 2) Reserva bloques de N objetos y recicla los liberados en una free-list
+// 3) Los bloques se devuelven todos juntos al destruir el slab
+// ============================================================================
+
+#ifndef MEMORIA_SLAB_H
+#define MEMORIA_SLAB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct t_slab t_slab;
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+t_slab*  slab_crear(size_t tam_objeto, uint32_t objetos_por_bloque);
+void*    slab_alloc(t_slab* slab);     // objeto en cero
+void     slab_free(t_slab* slab, void* obj);
+void     slab_destruir(t_slab* slab);
+
+uint32_t slab_en_uso(const t_slab* slab);
+
+#endif // MEMORIA_SLAB_H
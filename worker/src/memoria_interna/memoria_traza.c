@@ -0,0 +1,455 @@
+// ============================================================================
+// WORKER - memoria_traza.c
+// PASO A PASO GENERAL
+// 1) Ring acotado MPMC (esquema de Vyukov): cada celda tiene un número de
+//    secuencia que indica si está libre para el productor o lista para el
+//    consumidor. Encolar/desencolar es un CAS sobre el índice, sin mutex
+// 2) Los eventos copian todo lo que necesitan (File, Tag, valor), así el
+//    drenador no depende de ETPs o tablas que pueden liberarse después
+// 3) Si el ring está lleno el productor espera a que el drenador libere
+//    lugar (no se pierden ni se reordenan líneas obligatorias)
+// 4) Si File/Tag no entran en el evento, o no hay hilo drenador, se
+//    sincroniza y se loguea en el momento
+// 5) Los eventos de grabación de páginas pasan por el mismo ring, así quedan
+//    en el orden en que la memoria los vio
+// ============================================================================
+
+#include "memoria_traza.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#define TRAZA_FT_MAX      64
+#define TRAZA_VALOR_MAX   64
+#define TRAZA_ESPERA_MS   20    // el drenador revisa el ring al menos cada 20 ms
+
+typedef enum {
+    TRAZA_ACCESO_LEER,
+    TRAZA_ACCESO_ESCRIBIR,
+    TRAZA_MISS,
+    TRAZA_ASIGNA_MARCO,
+    TRAZA_LIBERA_MARCO,
+    TRAZA_REEMPLAZO,
+    TRAZA_PAGEIN,
+    TRAZA_VICTIM_FLUSH,
+    TRAZA_PAGINA          // grabación (va al archivo, no al log)
+} t_traza_tipo;
+
+typedef struct {
+    uint8_t     tipo;
+    uint32_t    query_id;
+    int32_t     marco;
+    uint32_t    pagina;
+    uint32_t    pagina_2;      // reemplazo: página entrante; victim_flush: bloque
+    uint64_t    dir_fisica;
+    const char* texto;         // pagein: algoritmo (cadena estática)
+    const char* texto_2;       // pagein: origen (cadena estática)
+    char        file[TRAZA_FT_MAX];
+    char        tag[TRAZA_FT_MAX];
+    char        file_2[TRAZA_FT_MAX];   // reemplazo: página entrante
+    char        tag_2[TRAZA_FT_MAX];
+    char        valor[TRAZA_VALOR_MAX];
+} t_traza_evento;
+
+typedef struct {
+    _Atomic size_t  seq;
+    t_traza_evento  ev;
+} t_traza_celda;
+
+static t_log*          g_logger   = NULL;
+static FILE*           g_grabacion = NULL;   // TRAZA_PAGINAS (NULL = sin grabar)
+static t_traza_celda*  g_celdas   = NULL;
+static size_t          g_mascara  = 0;
+static _Atomic size_t  g_enq      = 0;
+static _Atomic size_t  g_deq      = 0;
+static _Atomic size_t  g_escritos = 0;   // eventos ya logueados por el drenador
+static _Atomic int     g_activo   = 0;
+static _Atomic int     g_fin      = 0;
+
+static pthread_t       g_hilo;
+static pthread_mutex_t g_mtx      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_cond_hay = PTHREAD_COND_INITIALIZER;   // despierta al drenador
+static pthread_cond_t  g_cond_vaciado = PTHREAD_COND_INITIALIZER;
+
+// ---------------------------------------------------------------------------
+// Formato (mismo texto que las líneas históricas)
+// ---------------------------------------------------------------------------
+static void _escribir(const t_traza_evento* ev) {
+    switch (ev->tipo) {
+        case TRAZA_ACCESO_LEER:
+        case TRAZA_ACCESO_ESCRIBIR:
+            log_info(g_logger, "Query %u: Acción: %s - Dirección Física: %llu - Valor: %s",
+                     ev->query_id,
+                     ev->tipo == TRAZA_ACCESO_LEER ? "LEER" : "ESCRIBIR",
+                     (unsigned long long)ev->dir_fisica,
+                     ev->valor);
+            break;
+        case TRAZA_MISS:
+            log_info(g_logger, "Query %u: - Memoria Miss - File: %s - Tag: %s - Pagina: %u",
+                     ev->query_id, ev->file, ev->tag, ev->pagina);
+            break;
+        case TRAZA_ASIGNA_MARCO:
+            log_info(g_logger, "Query %u: Se asigna el Marco: %d a la Página: %u perteneciente al - File: %s - Tag: %s",
+                     ev->query_id, ev->marco, ev->pagina, ev->file, ev->tag);
+            break;
+        case TRAZA_LIBERA_MARCO:
+            log_info(g_logger, "Query %u: Se libera el Marco: %d perteneciente al - File: %s - Tag: %s",
+                     ev->query_id, ev->marco, ev->file, ev->tag);
+            break;
+        case TRAZA_REEMPLAZO:
+            log_info(g_logger, "## Query %u: Se reemplaza la página %s:%s/%u por la %s:%s/%u",
+                     ev->query_id, ev->file, ev->tag, ev->pagina,
+                     ev->file_2, ev->tag_2, ev->pagina_2);
+            break;
+        case TRAZA_PAGEIN:
+            if (ev->texto_2[0]) {
+                log_info(g_logger, "[MEM] PageIn(%s) %s -> pag=%u -> marco=%d",
+                         ev->texto, ev->texto_2, ev->pagina, ev->marco);
+            } else {
+                log_info(g_logger, "[MEM] PageIn(%s) -> pag=%u -> marco=%d",
+                         ev->texto, ev->pagina, ev->marco);
+            }
+            break;
+        case TRAZA_VICTIM_FLUSH:
+            log_debug(g_logger, "[MEM] victim_flush(q=%u) %s:%s pag=%u blk=%u",
+                      ev->query_id, ev->file, ev->tag, ev->pagina, ev->pagina_2);
+            break;
+        case TRAZA_PAGINA:
+            fprintf(g_grabacion, "%s:%s %u %c\n", ev->file, ev->tag, ev->pagina, ev->valor[0]);
+            break;
+        default:
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Ring
+// ---------------------------------------------------------------------------
+static int _encolar(const t_traza_evento* ev) {
+    size_t pos = atomic_load_explicit(&g_enq, memory_order_relaxed);
+
+    while (1) {
+        t_traza_celda* c = &g_celdas[pos & g_mascara];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_enq, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                c->ev = *ev;
+                atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0;   // lleno
+        } else {
+            pos = atomic_load_explicit(&g_enq, memory_order_relaxed);
+        }
+    }
+}
+
+static int _desencolar(t_traza_evento* ev) {
+    size_t pos = atomic_load_explicit(&g_deq, memory_order_relaxed);
+
+    while (1) {
+        t_traza_celda* c = &g_celdas[pos & g_mascara];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_deq, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *ev = c->ev;
+                atomic_store_explicit(&c->seq, pos + g_mascara + 1, memory_order_release);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0;   // vacío (o la celda todavía se está escribiendo)
+        } else {
+            pos = atomic_load_explicit(&g_deq, memory_order_relaxed);
+        }
+    }
+}
+
+static void _despertar_drenador(void) {
+    pthread_mutex_lock(&g_mtx);
+    pthread_cond_signal(&g_cond_hay);
+    pthread_mutex_unlock(&g_mtx);
+}
+
+static void* _drenador(void* arg) {
+    (void)arg;
+    t_traza_evento ev;
+
+    while (1) {
+        int escritos = 0;
+        while (_desencolar(&ev)) {
+            _escribir(&ev);
+            atomic_fetch_add_explicit(&g_escritos, 1, memory_order_release);
+            escritos++;
+        }
+
+        pthread_mutex_lock(&g_mtx);
+        if (escritos > 0) pthread_cond_broadcast(&g_cond_vaciado);
+
+        size_t enq = atomic_load(&g_enq);
+        size_t deq = atomic_load(&g_deq);
+        if (enq != deq) {
+            // Un productor reservó celda y todavía la está copiando
+            pthread_mutex_unlock(&g_mtx);
+            sched_yield();
+            continue;
+        }
+        if (atomic_load(&g_fin)) {
+            pthread_mutex_unlock(&g_mtx);
+            break;
+        }
+
+        struct timespec hasta;
+        clock_gettime(CLOCK_REALTIME, &hasta);
+        hasta.tv_nsec += TRAZA_ESPERA_MS * 1000000L;
+        if (hasta.tv_nsec >= 1000000000L) {
+            hasta.tv_sec++;
+            hasta.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&g_cond_hay, &g_mtx, &hasta);
+        pthread_mutex_unlock(&g_mtx);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Publicación de un evento
+// ---------------------------------------------------------------------------
+static int _nivel_activo(t_log_level nivel) {
+    return g_logger && nivel >= g_logger->detected_level;
+}
+
+static void _publicar(const t_traza_evento* ev) {
+    if (!atomic_load_explicit(&g_activo, memory_order_acquire)) {
+        _escribir(ev);
+        return;
+    }
+
+    // Lleno: esperar lugar en lugar de descartar o reordenar
+    while (!_encolar(ev)) {
+        _despertar_drenador();
+        sched_yield();
+    }
+}
+
+// Copia 'src' en 'dst'; devuelve 0 si no entra (el caller loguea en el momento)
+static int _copiar(char* dst, const char* src) {
+    size_t n = src ? strlen(src) : 0;
+    if (n >= TRAZA_FT_MAX) return 0;
+    memcpy(dst, src ? src : "", n + 1);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Ciclo de vida
+// ---------------------------------------------------------------------------
+void memoria_traza_iniciar(t_log* logger, uint32_t capacidad, const char* path_paginas) {
+    g_logger = logger;
+
+    if (path_paginas && path_paginas[0]) {
+        g_grabacion = fopen(path_paginas, "w");
+        if (!g_grabacion && logger) {
+            log_warning(logger, "[MEM] No se pudo abrir TRAZA_PAGINAS '%s'; no se graban accesos.", path_paginas);
+        } else if (g_grabacion) {
+            fprintf(g_grabacion, "# FILE:TAG PAGINA R|W|P (grabada por el Worker)\n");
+        }
+    }
+
+    if (capacidad == 0 || !logger) return;
+
+    size_t cap = 2;
+    while (cap < capacidad) cap <<= 1;
+
+    g_celdas = malloc(sizeof(t_traza_celda) * cap);
+    if (!g_celdas) return;
+    for (size_t i = 0; i < cap; i++) atomic_init(&g_celdas[i].seq, i);
+
+    g_mascara = cap - 1;
+    atomic_store(&g_enq, 0);
+    atomic_store(&g_deq, 0);
+    atomic_store(&g_escritos, 0);
+    atomic_store(&g_fin, 0);
+
+    if (pthread_create(&g_hilo, NULL, _drenador, NULL) != 0) {
+        log_warning(logger, "[MEM] No se pudo lanzar el hilo de traza; se loguea en línea.");
+        free(g_celdas);
+        g_celdas = NULL;
+        return;
+    }
+    atomic_store_explicit(&g_activo, 1, memory_order_release);
+}
+
+void memoria_traza_detener(void) {
+    if (atomic_load(&g_activo)) {
+        atomic_store(&g_fin, 1);
+        _despertar_drenador();
+        pthread_join(g_hilo, NULL);
+
+        atomic_store(&g_activo, 0);
+        free(g_celdas);
+        g_celdas = NULL;
+    }
+
+    if (g_grabacion) {
+        fclose(g_grabacion);
+        g_grabacion = NULL;
+    }
+}
+
+void memoria_traza_sincronizar(void) {
+    if (!atomic_load_explicit(&g_activo, memory_order_acquire)) return;
+
+    size_t objetivo = atomic_load(&g_enq);
+    if (atomic_load_explicit(&g_escritos, memory_order_acquire) >= objetivo) return;
+
+    pthread_mutex_lock(&g_mtx);
+    pthread_cond_signal(&g_cond_hay);
+    while (atomic_load_explicit(&g_escritos, memory_order_acquire) < objetivo) {
+        pthread_cond_wait(&g_cond_vaciado, &g_mtx);
+    }
+    pthread_mutex_unlock(&g_mtx);
+}
+
+// ---------------------------------------------------------------------------
+// Eventos
+// ---------------------------------------------------------------------------
+void memoria_traza_acceso(int escritura, uint32_t query_id, uint64_t dir_fisica,
+                          const char* valor, uint32_t len) {
+    if (!_nivel_activo(LOG_LEVEL_INFO)) return;
+
+    t_traza_evento ev;
+    ev.tipo       = escritura ? TRAZA_ACCESO_ESCRIBIR : TRAZA_ACCESO_LEER;
+    ev.query_id   = query_id;
+    ev.dir_fisica = dir_fisica;
+
+    uint32_t n = len < TRAZA_VALOR_MAX - 1 ? len : TRAZA_VALOR_MAX - 1;
+    memcpy(ev.valor, valor, n);
+    ev.valor[n] = '\0';
+
+    _publicar(&ev);
+}
+
+void memoria_traza_pagina(const char* file, const char* tag, uint32_t pagina, char op) {
+    if (!g_grabacion) return;
+
+    t_traza_evento ev;
+    ev.tipo     = TRAZA_PAGINA;
+    ev.pagina   = pagina;
+    ev.valor[0] = op;
+    if (!_copiar(ev.file, file) || !_copiar(ev.tag, tag)) {
+        memoria_traza_sincronizar();
+        fprintf(g_grabacion, "%s:%s %u %c\n", file ? file : "", tag ? tag : "", pagina, op);
+        return;
+    }
+    _publicar(&ev);
+}
+
+void memoria_traza_miss(uint32_t query_id, const char* file, const char* tag, uint32_t pagina) {
+    if (!_nivel_activo(LOG_LEVEL_INFO)) return;
+
+    t_traza_evento ev;
+    ev.tipo     = TRAZA_MISS;
+    ev.query_id = query_id;
+    ev.pagina   = pagina;
+    if (!_copiar(ev.file, file) || !_copiar(ev.tag, tag)) {
+        memoria_traza_sincronizar();
+        log_info(g_logger, "Query %u: - Memoria Miss - File: %s - Tag: %s - Pagina: %u",
+                 query_id, file ? file : "", tag ? tag : "", pagina);
+        return;
+    }
+    _publicar(&ev);
+}
+
+void memoria_traza_asigna_marco(uint32_t query_id, int marco, uint32_t pagina,
+                                const char* file, const char* tag) {
+    if (!_nivel_activo(LOG_LEVEL_INFO)) return;
+
+    t_traza_evento ev;
+    ev.tipo     = TRAZA_ASIGNA_MARCO;
+    ev.query_id = query_id;
+    ev.marco    = marco;
+    ev.pagina   = pagina;
+    if (!_copiar(ev.file, file) || !_copiar(ev.tag, tag)) {
+        memoria_traza_sincronizar();
+        log_info(g_logger, "Query %u: Se asigna el Marco: %d a la Página: %u perteneciente al - File: %s - Tag: %s",
+                 query_id, marco, pagina, file ? file : "", tag ? tag : "");
+        return;
+    }
+    _publicar(&ev);
+}
+
+void memoria_traza_libera_marco(uint32_t query_id, int marco, const char* file, const char* tag) {
+    if (!_nivel_activo(LOG_LEVEL_INFO)) return;
+
+    t_traza_evento ev;
+    ev.tipo     = TRAZA_LIBERA_MARCO;
+    ev.query_id = query_id;
+    ev.marco    = marco;
+    if (!_copiar(ev.file, file) || !_copiar(ev.tag, tag)) {
+        memoria_traza_sincronizar();
+        log_info(g_logger, "Query %u: Se libera el Marco: %d perteneciente al - File: %s - Tag: %s",
+                 query_id, marco, file ? file : "", tag ? tag : "");
+        return;
+    }
+    _publicar(&ev);
+}
+
+void memoria_traza_reemplazo(uint32_t query_id,
+                             const char* file_vict, const char* tag_vict, uint32_t pag_vict,
+                             const char* file, const char* tag, uint32_t pagina) {
+    if (!_nivel_activo(LOG_LEVEL_INFO)) return;
+
+    t_traza_evento ev;
+    ev.tipo     = TRAZA_REEMPLAZO;
+    ev.query_id = query_id;
+    ev.pagina   = pag_vict;
+    ev.pagina_2 = pagina;
+    if (!_copiar(ev.file, file_vict) || !_copiar(ev.tag, tag_vict) ||
+        !_copiar(ev.file_2, file) || !_copiar(ev.tag_2, tag)) {
+        memoria_traza_sincronizar();
+        log_info(g_logger, "## Query %u: Se reemplaza la página %s:%s/%u por la %s:%s/%u",
+                 query_id, file_vict ? file_vict : "", tag_vict ? tag_vict : "", pag_vict,
+                 file ? file : "", tag ? tag : "", pagina);
+        return;
+    }
+    _publicar(&ev);
+}
+
+void memoria_traza_pagein(const char* algoritmo, const char* origen, uint32_t pagina, int marco) {
+    if (!_nivel_activo(LOG_LEVEL_INFO)) return;
+
+    t_traza_evento ev;
+    ev.tipo    = TRAZA_PAGEIN;
+    ev.texto   = algoritmo;
+    ev.texto_2 = origen ? origen : "";
+    ev.pagina  = pagina;
+    ev.marco   = marco;
+    _publicar(&ev);
+}
+
+void memoria_traza_victim_flush(uint32_t query_id, const char* file, const char* tag,
+                                uint32_t pagina, uint32_t bloque) {
+    if (!_nivel_activo(LOG_LEVEL_DEBUG)) return;
+
+    t_traza_evento ev;
+    ev.tipo     = TRAZA_VICTIM_FLUSH;
+    ev.query_id = query_id;
+    ev.pagina   = pagina;
+    ev.pagina_2 = bloque;
+    if (!_copiar(ev.file, file) || !_copiar(ev.tag, tag)) {
+        _copiar(ev.file, "?");
+        _copiar(ev.tag, "?");
+    }
+    _publicar(&ev);
+}
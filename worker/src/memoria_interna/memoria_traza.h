@@ -0,0 +1,58 @@
+// ============================================================================
+// WORKER - memoria_traza.h
+// PASO A PASO GENERAL
+// 1) Los caminos calientes de memoria (accesos, misses, asignación y
+//    liberación de marcos, reemplazos) encolan eventos binarios en un ring
+//    lock-free en lugar de formatear y loguear con el mutex tomado
+// 2) Un hilo drenador formatea los eventos y escribe las líneas de log
+// 3) Antes de encolar se chequea el nivel del logger: un evento que no se
+//    va a loguear no cuesta nada
+// 4) memoria_traza_sincronizar() espera a que se escriba todo lo encolado,
+//    así las líneas obligatorias salen en orden respecto del resto del log
+// 5) Grabación opcional (TRAZA_PAGINAS): cada acceso a página sale también
+//    como "FILE:TAG PAGINA R|W|P" a un archivo, el formato que reproduce
+//    bin/worker_bench
+// ============================================================================
+
+#ifndef MEMORIA_TRAZA_H
+#define MEMORIA_TRAZA_H
+
+#include <stdint.h>
+#include <commons/log.h>
+
+// ---------------------------------------------------------------------------
+// Ciclo de vida
+// ---------------------------------------------------------------------------
+// capacidad: cantidad de eventos del ring (se redondea a potencia de 2).
+// Con capacidad 0, o si no se pudo lanzar el hilo, se loguea en el momento.
+// path_paginas: archivo donde grabar los accesos a páginas (NULL o "" = no).
+void memoria_traza_iniciar(t_log* logger, uint32_t capacidad, const char* path_paginas);
+void memoria_traza_detener(void);
+
+// Espera a que el hilo drenador escriba todo lo encolado hasta ahora
+void memoria_traza_sincronizar(void);
+
+// ---------------------------------------------------------------------------
+// Eventos (mismas líneas de log que antes, pero formateadas por el drenador)
+// ---------------------------------------------------------------------------
+void memoria_traza_acceso(int escritura, uint32_t query_id, uint64_t dir_fisica,
+                          const char* valor, uint32_t len);
+void memoria_traza_miss(uint32_t query_id, const char* file, const char* tag, uint32_t pagina);
+void memoria_traza_asigna_marco(uint32_t query_id, int marco, uint32_t pagina,
+                                const char* file, const char* tag);
+void memoria_traza_libera_marco(uint32_t query_id, int marco, const char* file, const char* tag);
+void memoria_traza_reemplazo(uint32_t query_id,
+                             const char* file_vict, const char* tag_vict, uint32_t pag_vict,
+                             const char* file, const char* tag, uint32_t pagina);
+
+// origen: "" (page-in simple), "REEMPLAZO", "LOTE" o "READ-AHEAD" (cadenas estáticas)
+void memoria_traza_pagein(const char* algoritmo, const char* origen, uint32_t pagina, int marco);
+
+// Grabación: op 'R'/'W' = acceso de demanda, 'P' = page-in por adelantado
+void memoria_traza_pagina(const char* file, const char* tag, uint32_t pagina, char op);
+
+// Diagnóstico (nivel DEBUG)
+void memoria_traza_victim_flush(uint32_t query_id, const char* file, const char* tag,
+                                uint32_t pagina, uint32_t bloque);
+
+#endif // MEMORIA_TRAZA_H
@@ -0,0 +1,108 @@
+// ============================================================================
+// WORKER - memoria_writeback.c
+// PASO A PASO GENERAL
+// 1) Abrir una conexión propia con Storage (no compartir g_fd_storage con la Query)
+// 2) Cada intervalo_ms, pedir a memoria_interna una pasada de writeback
+// 3) Así los reemplazos encuentran víctimas limpias y COMMIT tiene poco que hacer
+// ============================================================================
+
+#include "memoria_writeback.h"
+#include "memoria_interna.h"
+#include "../conexiones/storage.h"
+#include "../../../utils/src/net.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+static pthread_t        g_hilo;
+static volatile int     g_activo = 0;
+static int              g_fd_wb  = -1;
+static t_writeback_cfg  g_cfg;
+static t_log*           g_logger = NULL;
+
+// ---------------------------------------------------------------------------
+// Loop del flusher
+// ---------------------------------------------------------------------------
+static void* _writeback_loop(void* arg) {
+    (void)arg;
+
+    while (g_activo) {
+        usleep(g_cfg.intervalo_ms * 1000);
+        if (!g_activo) break;
+
+        int rc = memoria_writeback_pasada(g_fd_wb, g_cfg.ratio_dirty, g_cfg.edad_ms, g_cfg.lote);
+        if (rc < 0) {
+            if (g_logger) log_error(g_logger, "[MEM] Writeback: se perdió la conexión con Storage. Flusher detenido.");
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Arranque
+// ---------------------------------------------------------------------------
+int memoria_writeback_iniciar(
+    const char*            ip_storage,
+    const char*            puerto_storage,
+    const t_writeback_cfg* cfg,
+    t_log*                 logger
+) {
+    // 1) Deshabilitado si no hay intervalo o lote
+    if (!cfg || cfg->intervalo_ms == 0 || cfg->lote == 0) return 1;
+
+    g_cfg    = *cfg;
+    g_logger = logger;
+
+    // 2) Conexión propia + handshake (Storage exige OP_GET_BLOCK_SIZE primero)
+    g_fd_wb = conectar_a(ip_storage, puerto_storage);
+    if (g_fd_wb < 0) {
+        if (logger) log_error(logger, "[MEM] Writeback: no pude conectar a Storage %s:%s", ip_storage, puerto_storage);
+        return 0;
+    }
+
+    if (storage_get_block_size(g_fd_wb, logger) <= 0) {
+        if (logger) log_error(logger, "[MEM] Writeback: handshake con Storage falló.");
+        close(g_fd_wb);
+        g_fd_wb = -1;
+        return 0;
+    }
+
+    // 3) Lanzar el hilo
+    g_activo = 1;
+    if (pthread_create(&g_hilo, NULL, _writeback_loop, NULL) != 0) {
+        if (logger) log_error(logger, "[MEM] Writeback: no pude crear el hilo.");
+        g_activo = 0;
+        close(g_fd_wb);
+        g_fd_wb = -1;
+        return 0;
+    }
+
+    if (logger) {
+        log_info(
+            logger,
+            "[MEM] Writeback activo: intervalo=%ums ratio_dirty=%u%% edad=%ums lote=%u",
+            g_cfg.intervalo_ms,
+            g_cfg.ratio_dirty,
+            g_cfg.edad_ms,
+            g_cfg.lote
+        );
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Parada
+// ---------------------------------------------------------------------------
+void memoria_writeback_detener(void) {
+    if (g_fd_wb < 0) return;
+
+    if (g_activo) {
+        g_activo = 0;
+        pthread_join(g_hilo, NULL);
+    }
+
+    close(g_fd_wb);
+    g_fd_wb = -1;
+}
@@ -0,0 +1,31 @@
+// ============================================================================
+// WORKER - memoria_writeback.h
+// PASO A PASO GENERAL
+// 1) Configuración del flusher de páginas dirty en segundo plano
+// 2) Arranque / parada del hilo (usa su propia conexión a Storage)
+// ============================================================================
+
+#ifndef MEMORIA_WRITEBACK_H
+#define MEMORIA_WRITEBACK_H
+
+#include <stdint.h>
+#include <commons/log.h>
+
+// ---------------------------------------------------------------------------
+// Configuración (claves WRITEBACK_* del worker.cfg)
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint32_t intervalo_ms;  // 0 = flusher deshabilitado
+    uint32_t ratio_dirty;   // % de marcos dirty a partir del cual se persiste
+    uint32_t edad_ms;       // antigüedad máxima de una página dirty (0 = sin límite)
+    uint32_t lote;          // páginas por pasada
+} t_writeback_cfg;
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+int  memoria_writeback_iniciar(const char* ip_storage, const char* puerto_storage,
+                               const t_writeback_cfg* cfg, t_log* logger);
+void memoria_writeback_detener(void);
+
+#endif // MEMORIA_WRITEBACK_H
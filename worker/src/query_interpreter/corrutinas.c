@@ -0,0 +1,255 @@
+// ============================================================================
+// WORKER - corrutinas.c
+// PASO A PASO GENERAL
+// 1) Cada corrutina tiene una pila mmap con página de guarda y su ucontext
+// 2) corrutina_reanudar hace swapcontext desde el hilo del slot; las esperas
+//    anotan qué necesitan (fd, deadline o reintento) y vuelven al planificador
+// 3) corrutinas_esperar arma un poll() con los fds anotados y el deadline más
+//    cercano como timeout; un reintento (mutex tomado) espera como mucho 1 ms
+// 4) Al entrar y salir de una corrutina se restaura / guarda su query_id
+// ============================================================================
+
+#include "corrutinas.h"
+#include "../conexiones/storage.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define REINTENTO_MS 1
+
+typedef enum {
+    CO_LIBRE,        // sin función (o ya terminó)
+    CO_LISTA,
+    CO_ESPERA_FD,
+    CO_DORMIDA,
+    CO_REINTENTO
+} t_co_estado;
+
+struct t_corrutina {
+    ucontext_t      ctx;
+    char*           mapa;        // pila + página de guarda
+    size_t          tam_mapa;
+    t_co_estado     estado;
+
+    void          (*funcion)(void*);
+    void*           arg;
+
+    int             fd;          // CO_ESPERA_FD
+    short           eventos;
+    struct timespec despertar;   // CO_DORMIDA
+
+    // Contexto de la Query
+    uint32_t        query_id;
+    struct timespec deadline;
+};
+
+static __thread ucontext_t   g_ctx_planificador;
+static __thread t_corrutina* g_actual = NULL;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static int _antes(const struct timespec* a, const struct timespec* b) {
+    if (a->tv_sec != b->tv_sec) return a->tv_sec < b->tv_sec;
+    return a->tv_nsec < b->tv_nsec;
+}
+
+static int _ms_hasta(const struct timespec* t) {
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    if (!_antes(&ahora, t)) return 0;
+
+    int64_t ns = (int64_t)(t->tv_sec - ahora.tv_sec) * 1000000000LL + (t->tv_nsec - ahora.tv_nsec);
+    return (int)((ns + 999999) / 1000000);   // redondeo hacia arriba: nunca despertar antes
+}
+
+static void _suspender(void) {
+    t_corrutina* co = g_actual;
+    swapcontext(&co->ctx, &g_ctx_planificador);
+}
+
+static void _trampolin(void) {
+    t_corrutina* co = g_actual;
+    co->funcion(co->arg);
+    co->estado = CO_LIBRE;
+    _suspender();   // no vuelve: la corrutina se reinicia con corrutina_iniciar
+}
+
+// ---------------------------------------------------------------------------
+// Planificador
+// ---------------------------------------------------------------------------
+t_corrutina* corrutina_crear(size_t tam_pila) {
+    t_corrutina* co = calloc(1, sizeof(t_corrutina));
+    if (!co) return NULL;
+
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    tam_pila = (tam_pila + pagina - 1) / pagina * pagina;
+
+    co->tam_mapa = tam_pila + pagina;
+    co->mapa = mmap(NULL, co->tam_mapa, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (co->mapa == MAP_FAILED) {
+        free(co);
+        return NULL;
+    }
+    mprotect(co->mapa, pagina, PROT_NONE);   // desborde de pila -> SIGSEGV, no corrupción
+
+    co->estado = CO_LIBRE;
+    return co;
+}
+
+void corrutina_destruir(t_corrutina* co) {
+    if (!co) return;
+    munmap(co->mapa, co->tam_mapa);
+    free(co);
+}
+
+void corrutina_iniciar(t_corrutina* co, void (*funcion)(void*), void* arg) {
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+
+    getcontext(&co->ctx);
+    co->ctx.uc_stack.ss_sp   = co->mapa + pagina;
+    co->ctx.uc_stack.ss_size = co->tam_mapa - pagina;
+    co->ctx.uc_link          = NULL;
+    makecontext(&co->ctx, _trampolin, 0);
+
+    co->funcion  = funcion;
+    co->arg      = arg;
+    co->estado   = CO_LISTA;
+    co->query_id = 0;
+    memset(&co->deadline, 0, sizeof(co->deadline));
+}
+
+int corrutina_lista(const t_corrutina* co) {
+    return co->estado == CO_LISTA;
+}
+
+int corrutina_reanudar(t_corrutina* co) {
+    // 1) Entrar con el contexto de su Query
+    g_actual = co;
+    storage_set_query_id(co->query_id);
+
+    swapcontext(&g_ctx_planificador, &co->ctx);
+
+    // 2) Volvió: guardar el contexto (ejecutar_query pudo cambiarlo)
+    co->query_id = g_worker_query_id;
+    g_actual = NULL;
+
+    return co->estado == CO_LIBRE;
+}
+
+void corrutinas_esperar(t_corrutina** cos, int cant, int fd_aviso) {
+    struct pollfd* pfds = malloc(sizeof(struct pollfd) * (size_t)(cant + 1));
+    int*           due  = malloc(sizeof(int) * (size_t)(cant + 1));   // índice de corrutina por pollfd
+    if (!pfds || !due) {
+        free(pfds);
+        free(due);
+        return;
+    }
+
+    // 1) fds y timeout
+    int n = 0;
+    int timeout = -1;
+
+    if (fd_aviso >= 0) {
+        pfds[n].fd = fd_aviso;
+        pfds[n].events = POLLIN;
+        due[n++] = -1;
+    }
+
+    for (int i = 0; i < cant; i++) {
+        t_corrutina* co = cos[i];
+        int t = -1;
+
+        switch (co->estado) {
+            case CO_LISTA:
+                t = 0;
+                break;
+            case CO_ESPERA_FD:
+                pfds[n].fd = co->fd;
+                pfds[n].events = co->eventos;
+                due[n++] = i;
+                break;
+            case CO_DORMIDA:
+                t = _ms_hasta(&co->despertar);
+                break;
+            case CO_REINTENTO:
+                t = REINTENTO_MS;
+                break;
+            default:
+                break;
+        }
+        if (t >= 0 && (timeout < 0 || t < timeout)) timeout = t;
+    }
+
+    // 2) Esperar
+    int r = poll(pfds, (nfds_t)n, timeout);
+    if (r < 0 && errno != EINTR) r = 0;
+
+    // 3) Marcar listas
+    for (int k = 0; k < n && r > 0; k++) {
+        if (due[k] >= 0 && pfds[k].revents) cos[due[k]]->estado = CO_LISTA;
+    }
+
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    for (int i = 0; i < cant; i++) {
+        t_corrutina* co = cos[i];
+        if (co->estado == CO_REINTENTO ||
+            (co->estado == CO_DORMIDA && !_antes(&ahora, &co->despertar))) {
+            co->estado = CO_LISTA;
+        }
+    }
+
+    free(pfds);
+    free(due);
+}
+
+// ---------------------------------------------------------------------------
+// Dentro de una corrutina
+// ---------------------------------------------------------------------------
+int corrutina_activa(void) {
+    return g_actual != NULL;
+}
+
+void corrutina_esperar_fd(int fd, short eventos) {
+    if (!g_actual) return;
+
+    // Si ya está listo (ej: respuestas de un lote) no hace falta suspender
+    struct pollfd pfd = { .fd = fd, .events = eventos, .revents = 0 };
+    if (poll(&pfd, 1, 0) > 0) return;
+
+    g_actual->fd      = fd;
+    g_actual->eventos = eventos;
+    g_actual->estado  = CO_ESPERA_FD;
+    _suspender();
+}
+
+void corrutina_dormir_hasta(const struct timespec* deadline) {
+    if (!g_actual) {
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL) == EINTR) {
+            // reintentar hasta llegar al deadline
+        }
+        return;
+    }
+
+    g_actual->despertar = *deadline;
+    g_actual->estado    = CO_DORMIDA;
+    _suspender();
+}
+
+void corrutina_ceder(void) {
+    if (!g_actual) return;
+
+    g_actual->estado = CO_REINTENTO;
+    _suspender();
+}
+
+struct timespec* corrutina_deadline(void) {
+    return g_actual ? &g_actual->deadline : NULL;
+}
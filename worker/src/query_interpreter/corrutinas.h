@@ -0,0 +1,62 @@
+// ============================================================================
+// WORKER - corrutinas.h
+// PASO A PASO GENERAL
+// 1) Corrutinas con pila propia (ucontext) para correr varias Queries en un
+//    mismo hilo de slot (clave CORRUTINAS_POR_SLOT)
+// 2) Una Query se suspende mientras espera a Storage, paga el retardo de
+//    memoria o encuentra tomado el mutex de memoria; el hilo sigue con otra
+// 3) El hilo del slot es el planificador: reanuda las listas y, si no hay
+//    ninguna, espera con poll() los fds y deadlines de las suspendidas
+// 4) El contexto de la Query vive en su corrutina: g_worker_query_id se
+//    guarda y restaura en cada cambio y el deadline del retardo es propio
+// Fuera de una corrutina no se suspende nada (esperar_fd vuelve enseguida y
+// el recv bloquea como siempre, dormir_hasta duerme el hilo): el código de
+// Storage y memoria sigue funcionando igual en el flusher o sin corrutinas.
+// ============================================================================
+
+#ifndef CORRUTINAS_H
+#define CORRUTINAS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef struct t_corrutina t_corrutina;
+
+// ---------------------------------------------------------------------------
+// Planificador (hilo del slot)
+// ---------------------------------------------------------------------------
+t_corrutina* corrutina_crear(size_t tam_pila);
+void         corrutina_destruir(t_corrutina* co);
+
+// Prepara la corrutina para correr funcion(arg) desde el principio
+void corrutina_iniciar(t_corrutina* co, void (*funcion)(void*), void* arg);
+
+// 1 si se puede reanudar ya
+int  corrutina_lista(const t_corrutina* co);
+
+// Corre hasta que se suspenda o termine. Devuelve 1 si terminó.
+int  corrutina_reanudar(t_corrutina* co);
+
+// Bloquea el hilo hasta que alguna corrutina suspendida pueda seguir (o haya
+// datos en fd_aviso, si es >= 0) y marca como listas las que correspondan
+void corrutinas_esperar(t_corrutina** cos, int cant, int fd_aviso);
+
+// ---------------------------------------------------------------------------
+// Dentro de una corrutina
+// ---------------------------------------------------------------------------
+int  corrutina_activa(void);
+
+// Suspende hasta que fd tenga 'eventos' (POLLIN / POLLOUT)
+void corrutina_esperar_fd(int fd, short eventos);
+
+// Suspende hasta 'deadline' (CLOCK_MONOTONIC)
+void corrutina_dormir_hasta(const struct timespec* deadline);
+
+// Cede el hilo y vuelve a intentar más tarde (recurso tomado por otro)
+void corrutina_ceder(void);
+
+// Deadline del retardo de memoria de la Query en curso (NULL fuera de una corrutina)
+struct timespec* corrutina_deadline(void);
+
+#endif // CORRUTINAS_H
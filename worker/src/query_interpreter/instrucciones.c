@@ -1,7 +1,8 @@
 // ============================================================================
 // WORKER - instrucciones.c
 // PASO A PASO GENERAL
-// 1) Decodificar opcode y despachar a la función correspondiente
+// 1) Tabla de instrucciones: resolver opcode -> código al parsear y
+//    despachar código -> función al ejecutar
 // 2) Ejecutar CREATE / TAG / TRUNCATE / WRITE / READ / COMMIT / FLUSH / DELETE / END
 // 3) Usar memoria_interna para READ/WRITE/FLUSH y Storage para I/O persistente
 // 4) Notificar al Master resultados de READ y END
@@ -20,71 +21,154 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <pthread.h>
 #include <commons/log.h>
 
 // ---------------------------------------------------------------------------
-// NORMALIZACIÓN File:Tag
-// - Evita el bug de tener 2 representaciones:
-//     (file="metroid", tag="v1") vs (file="metroid:v1", tag="")
-// - Devuelve un file_tag_t que apunta a buffers provistos por el caller.
-//   (válidos durante toda la ejecución de la instrucción actual)
+// Tabla de instrucciones
+//
+// El opcode (hasta 8 caracteres) se empaqueta en un uint64_t y se busca en un
+// hash abierto de TAM_HASH posiciones: al parsear es una multiplicación y
+// una o dos comparaciones de enteros, sin strcmp. Al ejecutar, el código es
+// el índice directo en g_instrucciones.
 // ---------------------------------------------------------------------------
-static inline int _ft_tag_vacio(const char* t) {
-    return (!t || t[0] == '\0');
+#define TAM_HASH 32   // potencia de 2 > INSTR_MAX_CODIGOS
+
+typedef struct {
+    const char*     nombre;
+    bool            requiere_file;
+    t_funcion_instr funcion;
+} t_entrada_instr;
+
+static int _x_create  (const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+static int _x_tag     (const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+static int _x_truncate(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+static int _x_write   (const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+static int _x_read    (const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+static int _x_commit  (const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+static int _x_flush   (const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+static int _x_delete  (const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+static int _x_end     (const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx);
+
+static t_entrada_instr g_instrucciones[INSTR_MAX_CODIGOS] = {
+    [INSTR_CREATE]   = { "CREATE",   true,  _x_create   },
+    [INSTR_TAG]      = { "TAG",      true,  _x_tag      },
+    [INSTR_TRUNCATE] = { "TRUNCATE", true,  _x_truncate },
+    [INSTR_WRITE]    = { "WRITE",    true,  _x_write    },
+    [INSTR_READ]     = { "READ",     true,  _x_read     },
+    [INSTR_COMMIT]   = { "COMMIT",   true,  _x_commit   },
+    [INSTR_FLUSH]    = { "FLUSH",    true,  _x_flush    },
+    [INSTR_DELETE]   = { "DELETE",   true,  _x_delete   },
+    [INSTR_END]      = { "END",      false, _x_end      },
+};
+static int g_cant_instrucciones = INSTR_CANT_BASE;
+
+static uint64_t        g_hash_clave[TAM_HASH];
+static uint8_t         g_hash_codigo[TAM_HASH];   // 0 = posición libre
+static pthread_once_t  g_hash_once      = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_mutex_registro = PTHREAD_MUTEX_INITIALIZER;
+
+// Clave empaquetada: los bytes del nombre en un uint64_t (0 si no entra)
+static inline uint64_t _clave(const char* nombre) {
+    uint64_t clave = 0;
+    size_t   n     = strnlen(nombre, 9);
+    if (n == 0 || n > 8) return 0;
+    memcpy(&clave, nombre, n);
+    return clave;
 }
 
-static file_tag_t ft_normalize_to_buffers(
-    file_tag_t in,
-    char* file_buf, size_t file_buf_sz,
-    char* tag_buf,  size_t tag_buf_sz
-) {
-    const char* f = in.file ? in.file : "";
-    const char* t = in.tag  ? in.tag  : "";
-
-    if (file_buf_sz > 0) file_buf[0] = '\0';
-    if (tag_buf_sz  > 0) tag_buf[0]  = '\0';
-
-    // Caso 1: viene separado correctamente (tag no vacío)
-    if (!_ft_tag_vacio(t)) {
-        if (file_buf_sz > 0) {
-            strncpy(file_buf, f, file_buf_sz - 1);
-            file_buf[file_buf_sz - 1] = '\0';
-        }
-        if (tag_buf_sz > 0) {
-            strncpy(tag_buf, t, tag_buf_sz - 1);
-            tag_buf[tag_buf_sz - 1] = '\0';
-        }
-        return (file_tag_t){ .file = file_buf, .tag = tag_buf };
-    }
+static inline uint32_t _hash(uint64_t clave) {
+    return (uint32_t)((clave * 0x9E3779B97F4A7C15ULL) >> 59) & (TAM_HASH - 1);
+}
 
-    // Caso 2: tag vacío pero file viene como "file:tag" -> split
-    const char* sep = strchr(f, ':');
-    if (sep) {
-        size_t left_len = (size_t)(sep - f);
+static void _hash_insertar(uint64_t clave, int codigo) {
+    uint32_t h = _hash(clave);
+    while (g_hash_codigo[h] != 0) h = (h + 1) & (TAM_HASH - 1);
+    g_hash_clave[h]  = clave;
+    g_hash_codigo[h] = (uint8_t)codigo;
+}
+
+static void _hash_iniciar(void) {
+    for (int c = 1; c < INSTR_CANT_BASE; c++) {
+        _hash_insertar(_clave(g_instrucciones[c].nombre), c);
+    }
+}
 
-        if (file_buf_sz > 0) {
-            size_t n = left_len < (file_buf_sz - 1) ? left_len : (file_buf_sz - 1);
-            memcpy(file_buf, f, n);
-            file_buf[n] = '\0';
-        }
+t_codigo_instr instruccion_codigo(const char* opcode) {
+    pthread_once(&g_hash_once, _hash_iniciar);
 
-        const char* right = sep + 1;
-        if (tag_buf_sz > 0) {
-            strncpy(tag_buf, right, tag_buf_sz - 1);
-            tag_buf[tag_buf_sz - 1] = '\0';
-        }
+    uint64_t clave = opcode ? _clave(opcode) : 0;
+    if (clave == 0) return INSTR_DESCONOCIDA;
 
-        return (file_tag_t){ .file = file_buf, .tag = tag_buf };
+    for (uint32_t h = _hash(clave); g_hash_codigo[h] != 0; h = (h + 1) & (TAM_HASH - 1)) {
+        if (g_hash_clave[h] == clave) return (t_codigo_instr)g_hash_codigo[h];
     }
+    return INSTR_DESCONOCIDA;
+}
+
+int instruccion_registrar(const char* nombre, bool requiere_file, t_funcion_instr funcion) {
+    if (!nombre || !funcion || _clave(nombre) == 0) return -1;
 
-    // Caso 3: no hay ':' y tag vacío -> copiar file y dejar tag vacío
-    if (file_buf_sz > 0) {
-        strncpy(file_buf, f, file_buf_sz - 1);
-        file_buf[file_buf_sz - 1] = '\0';
+    pthread_mutex_lock(&g_mutex_registro);
+    int codigo = -1;
+    if (instruccion_codigo(nombre) == INSTR_DESCONOCIDA &&
+        g_cant_instrucciones < INSTR_MAX_CODIGOS) {
+        codigo = g_cant_instrucciones++;
+        g_instrucciones[codigo] = (t_entrada_instr){ nombre, requiere_file, funcion };
+        _hash_insertar(_clave(nombre), codigo);
     }
-    if (tag_buf_sz > 0) tag_buf[0] = '\0';
+    pthread_mutex_unlock(&g_mutex_registro);
+
+    return codigo;
+}
+
+// Adaptadores de las instrucciones base a t_funcion_instr
+static int _x_create(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)inst; (void)ft_dest;
+    return instr_create(ctx->query_id, ft, ctx->logger, ctx->fd_storage);
+}
+
+static int _x_tag(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)inst;
+    return instr_tag(ctx->query_id, ft, ft_dest, ctx->logger, ctx->fd_storage);
+}
+
+static int _x_truncate(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)ft_dest;
+    return instr_truncate(ctx->query_id, inst, ft, ctx->logger, ctx->fd_storage);
+}
+
+static int _x_write(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)ft_dest;
+    return instr_write(ctx->query_id, inst, ft, ctx->logger, ctx->fd_storage, ctx->retardo_ms);
+}
+
+static int _x_read(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)ft_dest;
+    return instr_read(ctx->query_id, inst, ft, ctx->logger, ctx->fd_storage, ctx->fd_master, ctx->retardo_ms,
+                      ctx->lote);
+}
 
-    return (file_tag_t){ .file = file_buf, .tag = tag_buf };
+static int _x_commit(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)inst; (void)ft_dest;
+    return instr_commit(ctx->query_id, ft, ctx->logger, ctx->fd_storage);
+}
+
+static int _x_flush(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)inst; (void)ft_dest;
+    return instr_flush(ctx->query_id, ft, ctx->logger, ctx->fd_storage);
+}
+
+static int _x_delete(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)inst; (void)ft_dest;
+    return instr_delete(ctx->query_id, ft, ctx->logger, ctx->fd_storage);
+}
+
+// END: NO llamar a instr_end() acá. Solo devolvemos 0 y el intérprete se
+// encarga de la finalización (flush + QUERY_END).
+static int _x_end(const instruccion_t* inst, file_tag_t ft, file_tag_t ft_dest, const t_ctx_instr* ctx) {
+    (void)inst; (void)ft; (void)ft_dest; (void)ctx;
+    return 0;
 }
 
 // ---------------------------------------------------------------------------
@@ -97,22 +181,22 @@ static file_tag_t ft_normalize_to_buffers(
 // ---------------------------------------------------------------------------
 int ejecutar_instruccion(
     int            query_id,
-    instruccion_t* inst,
+    const instruccion_t* inst,
     t_log*         logger,
     int            fd_storage,
     int            fd_master,
     uint32_t       retardo_ms,
-    int            pc_actual
+    int            pc_actual,
+    t_lote_lecturas* lote
 ) {
-    // 1) Si es END, finalización lógica de la Query
-    //    NO llamar a instr_end() acá. Solo devolvemos 0 y el intérprete
-    //    se encarga de la finalización (flush + QUERY_END).
-    if (strcmp(inst->opcode, "END") == 0) {
-        return 0;
+    // 1) Entrada de la tabla según el código resuelto al parsear
+    const t_entrada_instr* e = NULL;
+    if (inst->codigo > INSTR_DESCONOCIDA && (int)inst->codigo < g_cant_instrucciones) {
+        e = &g_instrucciones[inst->codigo];
     }
 
-    // 2) Validar que haya al menos un File:Tag
-    if (inst->file_count <= 0) {
+    // 2) Validar que haya al menos un File:Tag (salvo END y similares)
+    if ((!e || e->requiere_file) && inst->file_count <= 0) {
         log_error(
             logger,
             "[Q%d] Instrucción '%s' requiere File:Tag.",
@@ -122,62 +206,34 @@ int ejecutar_instruccion(
         return -1;  // error
     }
 
-    // 3) Tomar File:Tag principal y segundo (si existe)
-    //    + NORMALIZAR para evitar "file:tag" mezclado en el campo file.
-    file_tag_t ft_raw      = inst->files[0];
-    file_tag_t ft_dest_raw = (inst->file_count > 1)
-                               ? inst->files[1]
-                               : (file_tag_t){ NULL, NULL };
-
-    char ft_file_buf[256], ft_tag_buf[256];
-    char fd_file_buf[256], fd_tag_buf[256];
-
-    file_tag_t ft = ft_normalize_to_buffers(
-        ft_raw,
-        ft_file_buf, sizeof(ft_file_buf),
-        ft_tag_buf,  sizeof(ft_tag_buf)
-    );
-
-    file_tag_t ft_dest = ft_normalize_to_buffers(
-        ft_dest_raw,
-        fd_file_buf, sizeof(fd_file_buf),
-        fd_tag_buf,  sizeof(fd_tag_buf)
-    );
-
-    // 4) Despachar según opcode
-    if (strcmp(inst->opcode, "CREATE") == 0) {
-        return instr_create(query_id, ft, logger, fd_storage);
-
-    } else if (strcmp(inst->opcode, "TAG") == 0) {
-        return instr_tag(query_id, ft, ft_dest, logger, fd_storage);
-
-    } else if (strcmp(inst->opcode, "TRUNCATE") == 0) {
-        return instr_truncate(query_id, inst, ft, logger, fd_storage);
-
-    } else if (strcmp(inst->opcode, "WRITE") == 0) {
-        return instr_write(query_id, inst, ft, logger, fd_storage, retardo_ms);
-
-    } else if (strcmp(inst->opcode, "READ") == 0) {
-        return instr_read(query_id, inst, ft, logger, fd_storage, fd_master, retardo_ms);
-
-    } else if (strcmp(inst->opcode, "COMMIT") == 0) {
-        return instr_commit(query_id, ft, logger, fd_storage);
-
-    } else if (strcmp(inst->opcode, "FLUSH") == 0) {
-        return instr_flush(query_id, ft, logger, fd_storage);
-
-    } else if (strcmp(inst->opcode, "DELETE") == 0) {
-        return instr_delete(query_id, ft, logger, fd_storage);
+    // 3) Si no se reconoce el opcode, loguear y considerar error
+    if (!e) {
+        log_warning(
+            logger,
+            "[Q%d] Instrucción '%s' desconocida.",
+            query_id,
+            inst->opcode
+        );
+        return -1;
     }
 
-    // 5) Si no se reconoce el opcode, loguear y considerar error
-    log_warning(
-        logger,
-        "[Q%d] Instrucción '%s' desconocida.",
-        query_id,
-        inst->opcode
-    );
-    return -1;
+    // 4) Tomar File:Tag principal y segundo (si existe). Vienen normalizados
+    //    desde el parseo (tag nunca NULL).
+    file_tag_t vacio   = { "", "" };
+    file_tag_t ft      = (inst->file_count > 0) ? inst->files[0] : vacio;
+    file_tag_t ft_dest = (inst->file_count > 1) ? inst->files[1] : vacio;
+
+    // 5) Despachar
+    t_ctx_instr ctx = {
+        .query_id   = query_id,
+        .logger     = logger,
+        .fd_storage = fd_storage,
+        .fd_master  = fd_master,
+        .retardo_ms = retardo_ms,
+        .pc         = pc_actual,
+        .lote       = lote
+    };
+    return e->funcion(inst, ft, ft_dest, &ctx);
 }
 
 // ---------------------------------------------------------------------------
@@ -237,7 +293,10 @@ int instr_tag(
         return -1;
     }
 
-    // 3) Éxito
+    // 3) El destino comparte en memoria los bloques que ya tiene el origen
+    memoria_tag(ft_origen, ft_destino, query_id);
+
+    // 4) Éxito
     return 1;
 }
 
@@ -246,7 +305,7 @@ int instr_tag(
 // ---------------------------------------------------------------------------
 int instr_truncate(
     int            query_id,
-    instruccion_t* inst,
+    const instruccion_t* inst,
     file_tag_t     ft,
     t_log*         logger,
     int            fd_storage
@@ -262,7 +321,7 @@ int instr_truncate(
     }
 
     // 2) Interpretar parámetro como cantidad de bytes
-    uint32_t nuevo_tam_bytes = (uint32_t)atoi(inst->params[0]);
+    uint32_t nuevo_tam_bytes = inst->valores[0];
 
     // 3) Loguear operación
     log_info(
@@ -271,8 +330,12 @@ int instr_truncate(
         query_id
     );
 
-    // 4) Enviar TRUNCATE a Storage
-    if (!storage_truncate(ft, nuevo_tam_bytes, fd_storage, logger)) {
+    // 4) Enviar TRUNCATE a Storage (sin writeback del File:Tag en vuelo)
+    memoria_retener_writeback(ft);
+    int ok = storage_truncate(ft, nuevo_tam_bytes, fd_storage, logger);
+    memoria_soltar_writeback(ft);
+
+    if (!ok) {
         log_error(
             logger,
             "[Q%d] Error en TRUNCATE",
@@ -281,7 +344,10 @@ int instr_truncate(
         return -1;
     }
 
-    // 5) Éxito
+    // 5) Las copias del pool compartido del host ya no valen
+    memoria_truncado(ft);
+
+    // 6) Éxito
     return 1;
 }
 
@@ -290,7 +356,7 @@ int instr_truncate(
 // ---------------------------------------------------------------------------
 int instr_write(
     int            query_id,
-    instruccion_t* inst,
+    const instruccion_t* inst,
     file_tag_t     ft,
     t_log*         logger,
     int            fd_storage,
@@ -307,7 +373,7 @@ int instr_write(
     }
 
     // 2) Obtener dirección base y contenido
-    uint32_t    dir_base = (uint32_t)atoi(inst->params[0]);
+    uint32_t    dir_base = inst->valores[0];
     const char* content  = inst->params[1];
     uint32_t    size     = (uint32_t)strlen(content);
 
@@ -348,12 +414,13 @@ int instr_write(
 // ---------------------------------------------------------------------------
 int instr_read(
     int            query_id,
-    instruccion_t* inst,
+    const instruccion_t* inst,
     file_tag_t     ft,
     t_log*         logger,
     int            fd_storage,
     int            fd_master,
-    uint32_t       retardo_ms
+    uint32_t       retardo_ms,
+    t_lote_lecturas* lote
 ) {
     // 1) Validar parámetros (dir_base y size)
     if (inst->param_count < 2) {
@@ -366,8 +433,8 @@ int instr_read(
     }
 
     // 2) Obtener dirección base y tamaño a leer
-    uint32_t dir_base = (uint32_t)atoi(inst->params[0]);
-    uint32_t size     = (uint32_t)atoi(inst->params[1]);
+    uint32_t dir_base = inst->valores[0];
+    uint32_t size     = inst->valores[1];
 
     // 3) Loguear operación
     log_info(
@@ -376,8 +443,8 @@ int instr_read(
         query_id
     );
 
-    // 4) Reservar buffer para el contenido
-    char* buffer = malloc(size + 1);
+    // 4) Reservar buffer para el contenido (bytes crudos, sin terminador)
+    char* buffer = malloc(size ? size : 1);
     if (!buffer) {
         log_error(
             logger,
@@ -412,11 +479,12 @@ int instr_read(
         return -1;   // el intérprete va a tomar esto como error de instrucción
     }
 
-    // 6) Terminar string leído
-    buffer[size] = '\0';
-
-    // 7) Enviar resultado al Master
-    if (enviar_resultado_a_master(fd_master, (uint32_t)query_id, buffer, logger) != 0) {
+    // 6) Enviar los size bytes leídos con su dirección (un '\0' en el medio
+    //    no corta nada) al Master, o encolarlos en el lote de la Query
+    int rc_envio = lote
+        ? lote_lecturas_agregar(lote, dir_base, buffer, size, logger)
+        : enviar_resultado_a_master(fd_master, (uint32_t)query_id, dir_base, buffer, size, logger);
+    if (rc_envio != 0) {
         log_error(
             logger,
             "[Q%d] READ ok en memoria, pero falló el envío a Master.",
@@ -434,7 +502,7 @@ int instr_read(
         size
     );
 
-    // 8) Liberar buffer y continuar
+    // 7) Liberar buffer y continuar
     free(buffer);
     return 1;
 }
@@ -547,8 +615,11 @@ int instr_delete(
         query_id
     );
 
-    // 2) Pedir DELETE a Storage
+    // 2) Pedir DELETE a Storage (sin writeback del File:Tag en vuelo)
+    memoria_retener_writeback(ft);
+
     if (!storage_delete(ft, fd_storage, logger)) {
+        memoria_soltar_writeback(ft);
         log_error(
             logger,
             "[Q%d] Error en DELETE",
@@ -557,6 +628,10 @@ int instr_delete(
         return -1;
     }
 
+    // 3) Olvidar sus páginas en memoria (no hay nada que persistir)
+    memoria_descartar(ft);
+    memoria_soltar_writeback(ft);
+
     return 1;
 }
 
@@ -570,16 +645,21 @@ int instr_end(
     int               final_pc,
     t_query_resultado estado   // OK / ERROR / CANCELADA
 ) {
-    // 1) Flush implícito (ya loguea adentro)
+    // 1) Resumen de memoria de la Query (antes de liberar su estado)
+    t_query_end_metricas met;
+    int hay_met = memoria_resumen_query((uint32_t)query_id, &met);
+
+    // 2) Flush implícito (ya loguea adentro)
     //    END NORMAL NO PERSISTE: solo libera (descarta dirty si existiera).
     memoria_liberar_implicito((uint32_t)query_id);
 
-    // 2) Notificar END al Master, con el estado recibido
+    // 3) Notificar END al Master, con el estado recibido y el resumen
     if (enviar_end_a_master(
             fd_master,
             (uint32_t)query_id,
             (uint32_t)final_pc,
             estado,
+            hay_met ? &met : NULL,
             logger) != 0) {
         log_error(logger, "[Q%d] Error enviando END a Master.", query_id);
         return -1;
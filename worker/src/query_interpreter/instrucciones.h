@@ -4,27 +4,65 @@
 // 1) Define el dispatcher de instrucciones de la Query
 // 2) Declara funciones por operación (CREATE/TAG/TRUNCATE/WRITE/READ/.../END)
 // 3) Integra memoria interna, Storage y Master
+// 4) Tabla de instrucciones: nombre -> código al parsear (clave empaquetada
+//    de 8 bytes, hash abierto) y código -> función al ejecutar. Se pueden
+//    registrar instrucciones nuevas sin tocar el dispatcher.
 // ============================================================================
 
 #ifndef INSTRUCCIONES_H
 #define INSTRUCCIONES_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <commons/log.h>
 #include "instrucciones_parser.h"
 #include "../../../utils/src/proto.h"
+#include "../conexiones/master.h"
+
+// ---------------------------------------------------------------------------
+// Tabla de instrucciones
+// ---------------------------------------------------------------------------
+// Lo que recibe cada instrucción además de sus parámetros
+typedef struct {
+    int      query_id;
+    t_log*   logger;
+    int      fd_storage;
+    int      fd_master;
+    uint32_t retardo_ms;
+    int      pc;
+    t_lote_lecturas* lote;   // READ en lote hacia Master (NULL = uno por READ)
+} t_ctx_instr;
+
+// ft / ft_dest: primer y segundo File:Tag ("" si no vienen).
+// Mismo contrato que ejecutar_instruccion (>0 sigue, 0 END, <0 error)
+typedef int (*t_funcion_instr)(
+    const instruccion_t* inst,
+    file_tag_t           ft,
+    file_tag_t           ft_dest,
+    const t_ctx_instr*   ctx
+);
+
+// Registra una instrucción (nombre de hasta 8 caracteres, no se copia: tiene
+// que vivir todo el proceso). Llamar antes de
+// arrancar los slots: la tabla se lee sin lock. Devuelve el código asignado
+// o -1 (nombre inválido o repetido, tabla llena).
+int instruccion_registrar(const char* nombre, bool requiere_file, t_funcion_instr funcion);
+
+// Código de un opcode (INSTR_DESCONOCIDA si no está registrado)
+t_codigo_instr instruccion_codigo(const char* opcode);
 
 // ---------------------------------------------------------------------------
 // Dispatcher principal
 // ---------------------------------------------------------------------------
 int ejecutar_instruccion(
     int           query_id,
-    instruccion_t* inst,
+    const instruccion_t* inst,
     t_log*        logger,
     int           fd_storage,
     int           fd_master,
     uint32_t      retardo_ms,
-    int           pc_actual
+    int           pc_actual,
+    t_lote_lecturas* lote
 );
 
 // ---------------------------------------------------------------------------
@@ -32,9 +70,10 @@ int ejecutar_instruccion(
 // ---------------------------------------------------------------------------
 int instr_create (int query_id, file_tag_t ft, t_log* logger, int fd_storage);
 int instr_tag    (int query_id, file_tag_t ft_origen, file_tag_t ft_destino, t_log* logger, int fd_storage);
-int instr_truncate(int query_id, instruccion_t* inst, file_tag_t ft, t_log* logger, int fd_storage);
-int instr_write  (int query_id, instruccion_t* inst, file_tag_t ft, t_log* logger, int fd_storage, uint32_t retardo_ms);
-int instr_read   (int query_id, instruccion_t* inst, file_tag_t ft, t_log* logger, int fd_storage, int fd_master, uint32_t retardo_ms);
+int instr_truncate(int query_id, const instruccion_t* inst, file_tag_t ft, t_log* logger, int fd_storage);
+int instr_write  (int query_id, const instruccion_t* inst, file_tag_t ft, t_log* logger, int fd_storage, uint32_t retardo_ms);
+int instr_read   (int query_id, const instruccion_t* inst, file_tag_t ft, t_log* logger, int fd_storage, int fd_master, uint32_t retardo_ms,
+                  t_lote_lecturas* lote);
 int instr_commit (int query_id, file_tag_t ft, t_log* logger, int fd_storage);
 int instr_flush  (int query_id, file_tag_t ft, t_log* logger, int fd_storage);
 int instr_delete (int query_id, file_tag_t ft, t_log* logger, int fd_storage);
@@ -2,27 +2,62 @@
 // WORKER - instrucciones_parser.h
 // PASO A PASO GENERAL
 // 1) Define file_tag_t para parámetros "file:tag"
-// 2) Define instruccion_t con opcode, params y files
-// 3) Expone funciones de parseo y destrucción de instrucciones
+// 2) Define instruccion_t con opcode, params y files de capacidad fija
+// 3) Expone el parseo en el lugar: los punteros apuntan a la línea (que se
+//    modifica), sin reservar memoria; la línea tiene que vivir lo mismo que
+//    la instrucción (en query_programa.c, el buffer del script)
+// 4) El código de operación se resuelve al parsear (tabla de instrucciones
+//    de instrucciones.c); el compilador de scripts (query_programa.c)
+//    completa los parámetros numéricos ya convertidos
 // ============================================================================
 
 #ifndef INSTRUCTION_PARSER_H
 #define INSTRUCTION_PARSER_H
 
+#include <stdint.h>
+
 typedef struct {
     char* file;
     char* tag;
 } file_tag_t;
 
+typedef enum {
+    INSTR_DESCONOCIDA = 0,
+    INSTR_CREATE,
+    INSTR_TAG,
+    INSTR_TRUNCATE,
+    INSTR_WRITE,
+    INSTR_READ,
+    INSTR_COMMIT,
+    INSTR_FLUSH,
+    INSTR_DELETE,
+    INSTR_END,
+    INSTR_CANT_BASE          // los registrados con instruccion_registrar siguen desde acá
+} t_codigo_instr;
+
+#define INSTR_MAX_CODIGOS 24
+
+// Ninguna instrucción usa más de 2 File:Tag ni 2 parámetros; lo que sobre
+// en la línea se ignora
+#define INSTR_MAX_FILES   4
+#define INSTR_MAX_PARAMS  4
+#define INSTR_MAX_VALORES 2
+
 typedef struct {
     char*      opcode;
-    char**     params;
+    char*      params[INSTR_MAX_PARAMS];
     int        param_count;
-    file_tag_t* files;
+    file_tag_t files[INSTR_MAX_FILES];   // tag nunca NULL ("" si no hay ':')
     int        file_count;
+
+    t_codigo_instr codigo;                       // INSTR_DESCONOCIDA si no está registrado
+
+    // Completados al compilar el script
+    uint32_t       valores[INSTR_MAX_VALORES];   // atoi de params[i] (si existe)
 } instruccion_t;
 
-instruccion_t* parsear_linea(const char* linea);
-void           destruir_instruccion(instruccion_t* inst);
+// Tokeniza 'linea' en el lugar. Devuelve 0 si hay instrucción, -1 si la
+// línea está vacía.
+int parsear_linea(char* linea, instruccion_t* out);
 
 #endif
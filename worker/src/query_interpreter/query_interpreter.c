@@ -3,15 +3,20 @@
 // PASO A PASO GENERAL
 // 1) Armar el path completo del archivo de Query
 // 2) Loguear la recepción de la Query con su path
-// 3) Posicionarse en el PC inicial (saltando comentarios/blancos)
-// 4) Ejecutar línea a línea: parsear, loguear FETCH, ejecutar instrucción
-// 5) Loguear instrucción realizada y actualizar PC
+// 3) Obtener el programa compilado del script (caché por path + mtime) y
+//    usar el PC inicial como índice directo
+// 4) Ejecutar instrucción a instrucción: loguear FETCH, ejecutar
+// 5) Loguear instrucción realizada y actualizar PC (los READ pueden ir en
+//    lote: se mandan por umbral y siempre antes del END / ACK de desalojo)
 // 6) Finalizar Query con END explícito, error o END implícito
+// Si el QC abrió un canal directo, los READ van por ahí y el canal se cierra
+// (con confirmación del QC) antes del END / ACK que sale por el Master.
 // ============================================================================
 
 #include "query_interpreter.h"
 #include "instrucciones_parser.h"
 #include "instrucciones.h"
+#include "query_programa.h"
 #include "../memoria_interna/memoria_interna.h"
 
 #include <stdio.h>
@@ -19,11 +24,10 @@
 #include <string.h>
 #include <unistd.h>
 #include <commons/log.h>
-#include <sys/select.h>
-#include <errno.h>
 
 // Ajustá estos paths si tu estructura de carpetas es distinta:
 #include "../conexiones/master.h"
+#include "../conexiones/query_control.h"
 #include "../../../utils/src/net.h"
 #include "../../../utils/src/paquete.h"
 #include "../../../utils/src/proto.h"
@@ -32,12 +36,6 @@
 // ---------------------------------------------------------------------------
 // Helpers internos
 // ---------------------------------------------------------------------------
-static inline int _es_blanco_o_comentario(const char* s) {
-    if (!s) return 1;
-    while (*s == ' ' || *s == '\t') s++;
-    return (*s == '\0' || *s == '#' || *s == ';');
-}
-
 static void _armar_fullpath(char* dst, size_t dstsz, const char* base, const char* file) {
     if (!base || !base[0]) {
         snprintf(dst, dstsz, "%s", file ? file : "");
@@ -49,148 +47,85 @@ static void _armar_fullpath(char* dst, size_t dstsz, const char* base, const cha
     else       snprintf(dst, dstsz, "%s/%s", base, file ? file : "");
 }
 
-static void _nombre_instr_de_linea(const char* line, char* out, size_t outsz) {
-    out[0] = '\0';
-    if (!line || !out || outsz == 0) return;
-
-    const char* p = line;
-    while (*p == ' ' || *p == '\t') p++;
-
-    size_t i = 0;
-    while (*p && *p != ' ' && *p != '\t' && i + 1 < outsz) {
-        out[i++] = *p++;
-    }
-    out[i] = '\0';
-}
-
-// Leemos un u32 del payload de un paquete (mismo estilo que en main.c)
-static int _leer_u32_payload(const t_paquete* p, size_t* off, uint32_t* out) {
-    if (!p || !out || !off) return -1;
-    if (*off + sizeof(uint32_t) > p->buffer.size) return -1;
-    memcpy(out, (const char*) p->buffer.stream + *off, sizeof(uint32_t));
-    *off += sizeof(uint32_t);
-    return 0;
+// Todo READ hecho llega al QC antes que lo que sigue (END o ACK de desalojo)
+static void _entregar_lecturas(t_lote_lecturas* lote, int* fd_qc, uint32_t query_id, t_log* logger) {
+    lote_lecturas_enviar(lote, logger);
+    query_control_cerrar_canal(fd_qc, query_id, logger);
 }
 
 // ---------------------------------------------------------------------------
 // Chequeo de desalojo desde Master (no bloqueante)
 // ---------------------------------------------------------------------------
+// El socket del Master lo lee solo el loop de main.c: un DESALOJO queda
+// anotado en la palabra atómica del contexto de la Query (query_slots.c) y
+// acá se atiende. El caso común (nada pedido) es una lectura relajada.
 // Devuelve:
 //   1 -> hubo desalojo para ESTA query y YA se atendió (flush + ACK)
-//   0 -> no hay nada (o mensaje no relevante), seguir ejecutando
-//  -1 -> error grave de socket / protocolo
+//   0 -> no hay nada, seguir ejecutando
+//  -1 -> error enviando el ACK al Master
 static int check_desalojo_desde_master(
-    int         fd_master,
-    uint32_t    query_id,
-    t_log*      logger
+    int               fd_master,
+    int               fd_storage,
+    uint32_t          query_id,
+    _Atomic uint16_t* desalojo,
+    const t_programa* prog,
+    uint32_t          pc_siguiente,
+    t_lote_lecturas*  lote,
+    int*              fd_qc,
+    t_log*            logger
 ) {
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(fd_master, &readfds);
-
-    struct timeval tv;
-    tv.tv_sec  = 0;
-    tv.tv_usec = 0;  // timeout 0 => "asomo la cabeza" pero no bloqueo
-
-    int r = select(fd_master + 1, &readfds, NULL, NULL, &tv);
-    if (r < 0) {
-        log_error(logger, "select() falló en Worker durante ejecución de Query %u: %s",
-                  query_id, strerror(errno));
-        return -1;
+    if (atomic_load_explicit(desalojo, memory_order_relaxed) == 0) {
+        return 0;
     }
 
-    if (r == 0) {
-        // No hay datos pendientes de Master
+    // Consumir el pedido
+    uint16_t op = atomic_exchange_explicit(desalojo, 0, memory_order_acquire);
+    if (op == 0) {
         return 0;
     }
 
-    // Hay algo para leer del Master
-    uint16_t op = 0;
-    t_paquete p_rx;
-    paquete_iniciar(&p_rx);
+    // Log obligatorio de Desalojo de Query (warning para que resalte)
+    log_warning(
+        logger,
+        "## Query %u: Desalojada por pedido del Master (opcode=%u)",
+        query_id,
+        op
+    );
 
-    int rc = recibir_paquete(fd_master, &op, &p_rx);
-    if (rc != 0) {
-        log_error(
-            logger,
-            "Error recibiendo mensaje de Master mientras ejecutaba Query %u (rc=%d)",
-            query_id,
-            rc
+    // Se retoma en la instrucción siguiente: las lecturas ya hechas (también
+    // las que siguen en el lote) salen antes del ACK y el Master las reenvía
+    // al QC hasta recibirlo; por el canal directo, el QC confirma antes
+    uint32_t pc_actual = pc_siguiente;
+    t_query_end_metricas met;
+    memoria_flush_implicito(query_id, fd_storage, &met);
+
+    _entregar_lecturas(lote, fd_qc, query_id, logger);
+
+    int rc_ack = 0;
+    if (op == OP_DESALOJO_QUERY) {
+        // Se va a retomar: el Master guarda dónde empieza la instrucción del
+        // PC para no releer el script
+        rc_ack = master_enviar_desalojo_prioridad_ok(
+            fd_master, query_id, pc_actual,
+            programa_offset(prog, pc_actual), prog->version, &met
         );
-        paquete_destruir(&p_rx);
-        return -1;
+    } else { // OP_DESALOJO_POR_CANCELACION
+        rc_ack = master_enviar_desalojo_cancelacion_ok(fd_master, query_id, pc_actual);
     }
 
-    if (op == OP_DESALOJO_QUERY || op == OP_DESALOJO_POR_CANCELACION) {
-        size_t   off    = 0;
-        uint32_t qid_rx = 0;
-
-        if (_leer_u32_payload(&p_rx, &off, &qid_rx) != 0) {
-            log_error(
-                logger,
-                "Payload de DESALOJO inválido durante ejecución de Query %u",
-                query_id
-            );
-            paquete_destruir(&p_rx);
-            return -1;
-        }
-
-        if (qid_rx != query_id) {
-            // No es para esta Query. Por simplicidad lo ignoramos y seguimos.
-            log_warning(
-                logger,
-                "Recibí DESALOJO para Query %u pero estoy ejecutando %u. Ignoro.",
-                qid_rx,
-                query_id
-            );
-            paquete_destruir(&p_rx);
-            return 0;
-        }
-
-        // Log obligatorio de Desalojo de Query (warning para que resalte)
-        log_warning(
+    if (rc_ack != 0) {
+        log_error(
             logger,
-            "## Query %u: Desalojada por pedido del Master (opcode=%u)",
+            "Error enviando ACK de desalojo (Q:%u, PC:%u, opcode=%u)",
             query_id,
+            pc_actual,
             op
         );
-
-        uint32_t pc_actual = query_pc_actual(query_id);
-        memoria_flush_implicito(query_id);
-
-        int rc_ack = 0;
-        if (op == OP_DESALOJO_QUERY) {
-            rc_ack = master_enviar_desalojo_prioridad_ok(fd_master, query_id, pc_actual);
-        } else { // OP_DESALOJO_POR_CANCELACION
-            rc_ack = master_enviar_desalojo_cancelacion_ok(fd_master, query_id, pc_actual);
-        }
-
-        if (rc_ack != 0) {
-            log_error(
-                logger,
-                "Error enviando ACK de desalojo (Q:%u, PC:%u, opcode=%u)",
-                query_id,
-                pc_actual,
-                op
-            );
-            paquete_destruir(&p_rx);
-            return -1;
-        }
-
-        paquete_destruir(&p_rx);
-        // Avisamos al intérprete: se desalojó esta Query y ya se atendió todo
-        return 1;
+        return -1;
     }
 
-    // Mensaje inesperado mientras ejecutamos la Query: lo logueamos y lo descartamos.
-    log_warning(
-        logger,
-        "Mensaje inesperado (opcode=%u) mientras ejecutaba Query %u. Se descarta.",
-        op,
-        query_id
-    );
-    paquete_destruir(&p_rx);
-    return 0;
+    // Avisamos al intérprete: se desalojó esta Query y ya se atendió todo
+    return 1;
 }
 
 // ---------------------------------------------------------------------------
@@ -201,10 +136,14 @@ int ejecutar_query(
     const char* queries_path,
     const char* filename,
     uint32_t    pc_inicial,
+    uint32_t    offset_inicial,
+    uint32_t    version_script,
+    _Atomic uint16_t* desalojo,
     t_log*      logger,
     int         fd_storage,
     int         fd_master,
-    uint32_t    retardo_ms
+    uint32_t    retardo_ms,
+    const t_canal_qc* canal_qc
 ) {
     storage_set_query_id(query_id);
     // 1) Validar nombre de archivo
@@ -219,9 +158,10 @@ int ejecutar_query(
     char fullpath[512];
     _armar_fullpath(fullpath, sizeof(fullpath), queries_path, filename);
 
-    // 3) Abrir el archivo de Query
-    FILE* f = fopen(fullpath, "r");
-    if (!f) {
+    // 3) Obtener el script compilado (se compila solo la primera vez; si no
+    //    está en caché y el Master mandó el offset del PC, solo lo que falta)
+    t_programa* prog = programa_obtener(fullpath, pc_inicial, offset_inicial, version_script, logger);
+    if (!prog) {
         log_error(
             logger,
             "## Query %u: No pude abrir archivo %s. Verificar existencia y permisos.",
@@ -241,49 +181,43 @@ int ejecutar_query(
         fullpath
     );
 
-    // 5) Preparar buffers y PC
-    char*    line       = NULL;
-    size_t   len        = 0;
-    uint32_t pc         = 0;
+    // 5) Preparar PC
+    uint32_t pc         = pc_inicial;
     int      seguir     = 1;   // 1 = continuar, 0 = terminar
     int      desalojada = 0;   // 1 = la Query fue desalojada desde Master
 
-    // 6) Avanzar hasta el PC inicial contando solo líneas ejecutables
-    while (pc < pc_inicial) {
-        ssize_t r = getline(&line, &len, f);
-        if (r == -1) {
-            log_error(
-                logger,
-                "## Query %u: PC inicial (%u) fuera de rango del archivo.",
-                query_id,
-                pc_inicial
-            );
-            free(line);
-            fclose(f);
-            // PC inicial inválido -> QUERY_ERROR
-            instr_end(query_id, logger, fd_master, pc_inicial, QUERY_ERROR);
-            return 0;
-        }
-        line[strcspn(line, "\r\n")] = 0;
-        if (_es_blanco_o_comentario(line)) continue;
-        pc++;
+    // 6) El PC cuenta solo instrucciones: es el índice en el programa
+    if (!programa_pc_valido(prog, pc_inicial)) {
+        log_error(
+            logger,
+            "## Query %u: PC inicial (%u) fuera de rango del archivo.",
+            query_id,
+            pc_inicial
+        );
+        programa_liberar(prog);
+        // PC inicial inválido -> QUERY_ERROR
+        instr_end(query_id, logger, fd_master, pc_inicial, QUERY_ERROR);
+        return 0;
     }
 
-    // 7) Registrar PC inicial para posible desalojo
+    // 7) Registrar PC inicial para posible desalojo y preparar la salida de
+    //    los READ (canal directo al QC si lo hay, si no el Master)
     memoria_registrar_pc(query_id, pc);
-
-    // 8) Loop principal de ejecución: leer línea a línea
-    while (seguir && getline(&line, &len, f) != -1) {
-        // 8.1) Normalizar fin de línea
-        line[strcspn(line, "\r\n")] = 0;
-
-        // 8.2) Saltar líneas blancas o comentarios
-        if (_es_blanco_o_comentario(line)) {
-            continue;
+    int fd_qc = query_control_abrir_canal(canal_qc, query_id, logger);
+    t_lote_lecturas* lote = (fd_qc >= 0)
+        ? lote_lecturas_crear_directo(fd_qc, query_id)
+        : lote_lecturas_crear(fd_master, query_id);
+
+    // 8) Loop principal de ejecución
+    const instruccion_t* inst;
+    while (seguir && (inst = programa_instruccion(prog, pc)) != NULL) {
+        // 8.1) Lecturas en lote que ya esperaron LOTE_LECTURAS_MS
+        if (lote_lecturas_vencido(lote)) {
+            lote_lecturas_enviar(lote, logger);
         }
 
-        // 8.3) Antes de parsear/ejecutar, verificamos si Master pidió desalojo
-        int chk = check_desalojo_desde_master(fd_master, query_id, logger);
+        // 8.2) Antes de ejecutar, verificamos si Master pidió desalojo
+        int chk = check_desalojo_desde_master(fd_master, fd_storage, query_id, desalojo, prog, pc, lote, &fd_qc, logger);
         if (chk < 0) {
             // Error de comunicación grave → cortamos y devolvemos error
             log_error(
@@ -302,31 +236,10 @@ int ejecutar_query(
             break;
         }
 
-        // 8.4) Parsear línea a instruccion_t
-        instruccion_t* inst = parsear_linea(line);
-        if (!inst) {
-            log_warning(
-                logger,
-                "## Query %u (PC:%u): Línea inválida. Deteniendo ejecución.",
-                query_id,
-                pc
-            );
-
-            // Consideramos esto error de la Query → END con error
-            instr_end(query_id, logger, fd_master, pc, QUERY_ERROR);
-            seguir = 0;
-            break;
-        }
-
-        // 8.5) Obtener nombre de instrucción (sin parámetros)
-        char instr_name[64];
-        _nombre_instr_de_linea(line, instr_name, sizeof(instr_name));
-        if (instr_name[0] == '\0') {
-            strncpy(instr_name, "INSTRUCCION", sizeof(instr_name) - 1);
-            instr_name[sizeof(instr_name) - 1] = '\0';
-        }
+        // 8.3) Instrucción ya parseada; el nombre (sin parámetros) es su opcode
+        const char* instr_name = inst->opcode;
 
-        // 8.6) Log obligatorio de FETCH (sin parámetros)
+        // 8.4) Log obligatorio de FETCH (sin parámetros)
         log_info(
             logger,
             "## Query %u: FETCH - Program Counter: %u - %s",
@@ -335,10 +248,10 @@ int ejecutar_query(
             instr_name
         );
 
-        // 8.7) Actualizar PC actual en memoria para desalojo
+        // 8.5) Actualizar PC actual en memoria para desalojo
         memoria_registrar_pc(query_id, pc);
 
-        // 8.8) Ejecutar instrucción
+        // 8.6) Ejecutar instrucción
         // Contrato:
         //   rc > 0  -> instrucción OK, continuar
         //   rc == 0 -> END explícito
@@ -350,11 +263,12 @@ int ejecutar_query(
             fd_storage,
             fd_master,
             retardo_ms,
-            (int)pc
+            (int)pc,
+            lote
         );
 
         if (rc > 0) {
-            // 8.9) Ejecución OK: loguear y avanzar PC
+            // 8.7) Ejecución OK: loguear y avanzar PC
             log_info(
                 logger,
                 "## Query %u: - Instrucción realizada: %s",
@@ -366,6 +280,7 @@ int ejecutar_query(
         } else {
             // rc == 0 -> END explícito
             // rc < 0  -> error
+            _entregar_lecturas(lote, &fd_qc, query_id, logger);
             if (rc == 0) {
                 log_info(
                     logger,
@@ -390,13 +305,13 @@ int ejecutar_query(
 
             seguir = 0;
         }
-
-        destruir_instruccion(inst);
     }
 
-    // 9) Liberar recursos de lectura y cerrar archivo
-    if (line) free(line);
-    fclose(f);
+    // 9) Soltar el programa (queda en la caché para la próxima Query) y
+    //    mandar lo que quede del lote (cerrando el canal directo)
+    programa_liberar(prog);
+    _entregar_lecturas(lote, &fd_qc, query_id, logger);
+    lote_lecturas_destruir(lote);
 
     // 10) Finalización según motivo
     if (!desalojada && seguir != 0) {
@@ -2,24 +2,32 @@
 // WORKER - query_interpreter.h
 // PASO A PASO GENERAL
 // 1) Expone ejecutar_query para correr una Query completa
-// 2) Recibe IDs, path, archivo, PC inicial y FDs de Storage/Master
+// 2) Recibe IDs, path, archivo, PC inicial (con su offset en el script, si
+//    el Master lo tiene), la señal de desalojo, FDs de Storage/Master y el
+//    canal directo de resultados al QC (si el Master mandó uno)
 // ============================================================================
 
 #ifndef QUERY_INTERPRETER_H
 #define QUERY_INTERPRETER_H
 
 #include <stdint.h>
+#include <stdatomic.h>
 #include <commons/log.h>
+#include "../conexiones/query_control.h"
 
 int ejecutar_query(
     uint32_t    query_id,
     const char* queries_path,
     const char* filename,
     uint32_t    pc_inicial,
+    uint32_t    offset_inicial,    // 0 = desconocido
+    uint32_t    version_script,
+    _Atomic uint16_t* desalojo,     // OP_DESALOJO_* pedido por el Master (0 = nada)
     t_log*      logger,
     int         fd_storage,
     int         fd_master,
-    uint32_t    retardo_ms
+    uint32_t    retardo_ms,
+    const t_canal_qc* canal_qc      // ip NULL = los READ van por el Master
 );
 
 #endif
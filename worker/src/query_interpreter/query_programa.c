@@ -0,0 +1,276 @@
+// ============================================================================
+// WORKER - query_programa.c
+// PASO A PASO GENERAL
+// 1) Abrir el script y tomar (mtime, tamaño) del mismo fd
+// 2) Buscar en la caché: si está vigente se reusa; si cambió se retira
+// 3) Compilar: leer el script a un buffer, saltear blancos/comentarios,
+//    parsear cada línea en el lugar (ya resuelve el código de operación) y
+//    convertir los enteros (sin malloc por línea ni por token)
+// 4) Liberar por contador de referencias (un programa retirado se destruye
+//    cuando lo suelta la última Query que lo estaba ejecutando)
+// 5) Retomar con offset del Master: si no está en caché y la versión
+//    coincide, seek al offset y compilar desde ahí (programa parcial)
+// ============================================================================
+
+#include "query_programa.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <commons/collections/list.h>
+
+static t_list*         g_programas       = NULL;
+static pthread_mutex_t g_mutex_programas = PTHREAD_MUTEX_INITIALIZER;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static inline int _es_blanco_o_comentario(const char* s) {
+    if (!s) return 1;
+    while (*s == ' ' || *s == '\t') s++;
+    return (*s == '\0' || *s == '#' || *s == ';');
+}
+
+static void _completar(instruccion_t* inst) {
+    for (int i = 0; i < INSTR_MAX_VALORES; i++) {
+        inst->valores[i] = (i < inst->param_count && inst->params[i])
+                             ? (uint32_t)atoi(inst->params[i])
+                             : 0;
+    }
+}
+
+// Firma del script para validar offsets que vienen del Master (FNV-1a de
+// mtime y tamaño). 0 queda reservado para "sin versión".
+static uint32_t _version(const struct stat* st) {
+    uint64_t campos[3] = {
+        (uint64_t)st->st_mtim.tv_sec,
+        (uint64_t)st->st_mtim.tv_nsec,
+        (uint64_t)st->st_size
+    };
+    const unsigned char* b = (const unsigned char*)campos;
+
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(campos); i++) {
+        h ^= b[i];
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+static void _programa_destruir(t_programa* prog) {
+    if (!prog) return;
+
+    free(prog->instrucciones);
+    free(prog->offsets);
+    free(prog->texto);
+    free(prog->path);
+    free(prog);
+}
+
+// ---------------------------------------------------------------------------
+// Compilación
+// ---------------------------------------------------------------------------
+// base/desde: PC y byte de la primera instrucción a compilar (0/0 = todo).
+// En un programa parcial el offset tiene que caer al principio de una línea
+// ejecutable; si no, devuelve NULL y se compila completo.
+static t_programa* _compilar(int fd, const char* fullpath, const struct stat* st,
+                             uint32_t base, uint32_t desde) {
+    // 1) Programa vacío con la clave de la caché
+    t_programa* prog = calloc(1, sizeof(t_programa));
+    if (!prog) return NULL;
+
+    prog->path    = strdup(fullpath);
+    prog->mtime   = st->st_mtim;
+    prog->tam     = st->st_size;
+    prog->version = _version(st);
+    prog->base    = base;
+    prog->vigente = 1;
+
+    // 2) Traer el script (desde el offset) a un solo buffer: las
+    //    instrucciones se parsean en el lugar y apuntan a él
+    size_t tam_texto = (st->st_size > (off_t)desde) ? (size_t)(st->st_size - desde) : 0;
+    prog->texto = malloc(tam_texto + 1);
+
+    int    ok    = (prog->path != NULL && prog->texto != NULL);
+    size_t leido = 0;
+    while (ok && leido < tam_texto) {
+        ssize_t r = pread(fd, prog->texto + leido, tam_texto - leido, (off_t)(desde + leido));
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) ok = 0;
+        if (r <= 0) break;   // r == 0: se achicó mientras tanto
+        leido += (size_t)r;
+    }
+    tam_texto = leido;
+
+    uint32_t capacidad = 0;
+    char*    p   = prog->texto;
+    char*    fin = ok ? prog->texto + tam_texto : p;
+    if (ok) *fin = '\0';
+
+    // 3) Una instrucción por línea ejecutable
+    while (ok && p < fin) {
+        char* linea = p;
+        char* nl    = memchr(p, '\n', (size_t)(fin - p));
+        if (nl) {
+            *nl = '\0';
+            p = nl + 1;
+        } else {
+            p = fin;
+        }
+        linea[strcspn(linea, "\r")] = '\0';
+
+        if (_es_blanco_o_comentario(linea)) {
+            if (desde > 0 && prog->cantidad == 0) ok = 0;   // offset desalineado
+            continue;
+        }
+
+        if (prog->cantidad == capacidad) {
+            uint32_t nueva = capacidad ? capacidad * 2 : 16;
+            instruccion_t* arr = realloc(prog->instrucciones, sizeof(instruccion_t) * nueva);
+            uint32_t*      ofs = arr ? realloc(prog->offsets, sizeof(uint32_t) * nueva) : NULL;
+            if (arr) prog->instrucciones = arr;
+            if (!ofs) {
+                ok = 0;
+                break;
+            }
+            prog->offsets = ofs;
+            capacidad = nueva;
+        }
+
+        instruccion_t* inst = &prog->instrucciones[prog->cantidad];
+        if (parsear_linea(linea, inst) != 0) continue;   // solo separadores
+
+        prog->offsets[prog->cantidad++] = desde + (uint32_t)(linea - prog->texto);
+        _completar(inst);
+    }
+
+    if (!ok) {
+        _programa_destruir(prog);
+        return NULL;
+    }
+    return prog;
+}
+
+// Retomar en el offset que mandó el Master sin leer lo anterior
+static t_programa* _compilar_desde(int fd, const char* fullpath, const struct stat* st,
+                                   uint32_t pc, uint32_t offset, uint32_t version) {
+    // 1) Tiene que ser el mismo script que generó el offset
+    if (pc == 0 || offset == 0 || version != _version(st)) return NULL;
+    if ((off_t)offset > st->st_size) return NULL;
+
+    // 2) El byte anterior cierra una línea
+    char anterior = 0;
+    if (pread(fd, &anterior, 1, (off_t)offset - 1) != 1 || anterior != '\n') return NULL;
+
+    return _compilar(fd, fullpath, st, pc, offset);
+}
+
+// ---------------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------------
+t_programa* programa_obtener(
+    const char* fullpath,
+    uint32_t    pc,
+    uint32_t    offset,
+    uint32_t    version,
+    t_log*      logger
+) {
+    // 1) Abrir y tomar la clave del mismo fd (si cambia después, la próxima
+    //    Query lo ve con otro mtime)
+    int fd = open(fullpath, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_mutex_programas);
+    if (!g_programas) g_programas = list_create();
+
+    // 2) Buscar en la caché
+    t_programa* prog = NULL;
+    for (int i = 0; i < list_size(g_programas); i++) {
+        t_programa* p = list_get(g_programas, i);
+        if (strcmp(p->path, fullpath) != 0) continue;
+
+        if (p->mtime.tv_sec == st.st_mtim.tv_sec &&
+            p->mtime.tv_nsec == st.st_mtim.tv_nsec &&
+            p->tam == st.st_size) {
+            prog = p;
+        } else {
+            // El script cambió: se retira, lo liberan las Queries que lo usan
+            list_remove(g_programas, i);
+            p->vigente = 0;
+            if (p->refs == 0) _programa_destruir(p);
+        }
+        break;
+    }
+
+    // 3) No estaba: retomar desde el offset del Master (parcial, no se
+    //    cachea) o compilar el script completo
+    if (!prog) {
+        prog = _compilar_desde(fd, fullpath, &st, pc, offset, version);
+        if (prog) {
+            prog->vigente = 0;
+            prog->refs++;
+            pthread_mutex_unlock(&g_mutex_programas);
+            close(fd);
+            log_debug(logger, "[PROG] %s retomado en PC %u desde el byte %u (%u instrucciones)",
+                      fullpath, pc, offset, prog->cantidad);
+            return prog;
+        }
+
+        prog = _compilar(fd, fullpath, &st, 0, 0);
+        if (prog) {
+            list_add(g_programas, prog);
+            log_debug(logger, "[PROG] %s compilado: %u instrucciones", fullpath, prog->cantidad);
+        } else {
+            log_error(logger, "[PROG] No pude compilar %s", fullpath);
+        }
+    }
+
+    if (prog) prog->refs++;
+    pthread_mutex_unlock(&g_mutex_programas);
+
+    close(fd);
+    return prog;
+}
+
+const instruccion_t* programa_instruccion(const t_programa* prog, uint32_t pc) {
+    if (pc < prog->base || pc - prog->base >= prog->cantidad) return NULL;
+    return &prog->instrucciones[pc - prog->base];
+}
+
+int programa_pc_valido(const t_programa* prog, uint32_t pc) {
+    return pc >= prog->base && pc - prog->base <= prog->cantidad;
+}
+
+uint32_t programa_offset(const t_programa* prog, uint32_t pc) {
+    if (pc < prog->base) return 0;
+    if (pc - prog->base < prog->cantidad) return prog->offsets[pc - prog->base];
+    return (uint32_t)prog->tam;
+}
+
+void programa_liberar(t_programa* prog) {
+    if (!prog) return;
+
+    pthread_mutex_lock(&g_mutex_programas);
+    prog->refs--;
+    if (!prog->vigente && prog->refs == 0) _programa_destruir(prog);
+    pthread_mutex_unlock(&g_mutex_programas);
+}
+
+void programa_cache_destruir(void) {
+    pthread_mutex_lock(&g_mutex_programas);
+    if (g_programas) {
+        list_destroy_and_destroy_elements(g_programas, (void*)_programa_destruir);
+        g_programas = NULL;
+    }
+    pthread_mutex_unlock(&g_mutex_programas);
+}
@@ -0,0 +1,69 @@
+// ============================================================================
+// WORKER - query_programa.h
+// PASO A PASO GENERAL
+// 1) Compila un script de Query una sola vez: un arreglo de instrucciones
+//    ya parseadas (código de operación, File:Tag separados, enteros convertidos)
+// 2) El PC es el índice directo en ese arreglo (sin blancos ni comentarios)
+// 3) Los programas se cachean por (path, mtime, tamaño): si el archivo cambia
+//    se recompila y el viejo se libera cuando lo suelta la última Query
+// 4) Compartido entre slots y corrutinas: se toma con programa_obtener y se
+//    devuelve con programa_liberar (contador de referencias)
+// 5) Índice de offsets: cada instrucción guarda el byte donde empieza su
+//    línea. Al desalojar, el offset del PC y la versión del script viajan al
+//    Master, que los reenvía en la próxima ASIGNACION_QUERY. Un Worker que no
+//    tiene el script en caché retoma con un solo seek y compila solo lo que
+//    falta (programa parcial, no se cachea).
+// ============================================================================
+
+#ifndef QUERY_PROGRAMA_H
+#define QUERY_PROGRAMA_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include <commons/log.h>
+#include "instrucciones_parser.h"
+
+typedef struct {
+    char*           path;
+    struct timespec mtime;
+    off_t           tam;
+
+    char*           texto;           // el script; las instrucciones apuntan acá
+    instruccion_t*  instrucciones;   // solo lectura una vez compilado
+    uint32_t*       offsets;         // byte de inicio de cada instrucción
+    uint32_t        base;            // PC de instrucciones[0] (0 salvo parciales)
+    uint32_t        cantidad;
+    uint32_t        version;         // firma de (mtime, tamaño)
+
+    int             refs;
+    int             vigente;         // 0 = reemplazado, se libera con refs == 0
+} t_programa;
+
+// Devuelve el programa del script (compilándolo si hace falta) con una
+// referencia tomada. NULL si no se pudo abrir o compilar.
+// offset/version vienen del Master (0 si no los tiene): si el script no está
+// en caché y la versión coincide, se compila desde ese byte con base = pc.
+t_programa* programa_obtener(
+    const char* fullpath,
+    uint32_t    pc,
+    uint32_t    offset,
+    uint32_t    version,
+    t_log*      logger
+);
+
+// Instrucción del PC, o NULL si el programa ya terminó (o pc < base)
+const instruccion_t* programa_instruccion(const t_programa* prog, uint32_t pc);
+
+// 1 si pc está dentro del programa o es justo el final
+int      programa_pc_valido(const t_programa* prog, uint32_t pc);
+
+// Byte donde empieza la instrucción pc (el tamaño del script si es el final)
+uint32_t programa_offset(const t_programa* prog, uint32_t pc);
+
+void programa_liberar(t_programa* prog);
+
+// Salida del Worker (sin Queries en curso)
+void programa_cache_destruir(void);
+
+#endif // QUERY_PROGRAMA_H
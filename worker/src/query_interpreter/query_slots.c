@@ -0,0 +1,406 @@
+// ============================================================================
+// WORKER - query_slots.c
+// PASO A PASO GENERAL
+// 1) slots_iniciar: por cada slot, uno o más ejecutores (uno por corrutina)
+//    con su propia conexión a Storage (handshake incluido) y un hilo
+// 2) slots_asignar: crear el contexto de la Query, encolarlo en g_pendientes
+//    y despertar a los slots
+// 3) Sin corrutinas, el hilo del slot toma una pendiente y corre
+//    ejecutar_query bloqueándose en cada I/O. Con corrutinas, el hilo es el
+//    planificador: llena los ejecutores libres, reanuda las corrutinas listas
+//    y, si no hay ninguna, espera con poll() (ver corrutinas.c)
+// 4) slots_desalojar: el pedido del Master queda en una palabra atómica del
+//    contexto de la Query (pendiente o en ejecución); el intérprete recibe su
+//    dirección y la mira entre instrucciones sin lock ni syscall
+// ============================================================================
+
+#include "query_slots.h"
+#include "query_interpreter.h"
+#include "corrutinas.h"
+#include "../conexiones/storage.h"
+#include "../../../utils/src/net.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <commons/collections/list.h>
+
+#define PILA_CORRUTINA (256 * 1024)
+
+// Contexto de una Query asignada a este Worker (bajo g_mtx)
+typedef struct {
+    uint32_t query_id;
+    char*    filename;
+    uint32_t pc_inicial;
+    uint32_t offset_inicial; // byte del PC inicial en el script (0 = desconocido)
+    uint32_t version_script;
+    t_canal_qc canal_qc;            // canal directo de resultados (ip NULL = no hay)
+    _Atomic uint16_t desalojo_op;   // DESALOJO todavía no atendido por el intérprete
+} t_contexto_query;
+
+// Lo necesario para correr una Query: conexión a Storage y, en modo
+// corrutinas, la corrutina que la ejecuta
+typedef struct {
+    int               fd_storage;
+    bool              propio;      // fd abierto acá (el primero es g_fd_storage)
+    t_corrutina*      co;
+    t_contexto_query* query;       // NULL = libre
+} t_ejecutor;
+
+typedef struct {
+    pthread_t     hilo;
+    t_ejecutor*   ejecutores;
+    uint32_t      cant_ejecutores;
+    t_corrutina** cos;             // para corrutinas_esperar
+    int           fd_aviso;        // eventfd: hay pendientes (modo corrutinas)
+} t_slot;
+
+static t_slot*         g_slots        = NULL;
+static uint32_t        g_cant         = 0;
+static bool            g_corrutinas   = false;
+static t_list*         g_pendientes   = NULL;   // t_contexto_query* sin ejecutor
+static t_list*         g_en_ejecucion = NULL;   // t_contexto_query*
+static pthread_mutex_t g_mtx          = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_cond_hay     = PTHREAD_COND_INITIALIZER;
+static volatile int    g_activo       = 0;
+
+static const char* g_queries_path = NULL;
+static uint32_t    g_retardo_ms   = 0;
+static int         g_fd_master    = -1;
+static t_log*      g_logger       = NULL;
+
+// ---------------------------------------------------------------------------
+// Contextos
+// ---------------------------------------------------------------------------
+static void _destruir_contexto(void* elem) {
+    t_contexto_query* q = (t_contexto_query*) elem;
+    free(q->filename);
+    free(q->canal_qc.ip);
+    free(q);
+}
+
+// Requiere g_mtx. Pasa la primera pendiente a 'en ejecución' (NULL si no hay)
+static t_contexto_query* _tomar_pendiente(void) {
+    if (list_is_empty(g_pendientes)) return NULL;
+
+    t_contexto_query* q = list_remove(g_pendientes, 0);
+    list_add(g_en_ejecucion, q);
+    return q;
+}
+
+// Ejecuta la Query del ejecutor (en el hilo del slot o en su corrutina)
+static void _ejecutar(void* arg) {
+    t_ejecutor*       ej = (t_ejecutor*) arg;
+    t_contexto_query* q  = ej->query;
+
+    pthread_mutex_lock(&g_mtx);
+    int fd_master = g_fd_master;
+    pthread_mutex_unlock(&g_mtx);
+
+    int exec_ok = ejecutar_query(
+        q->query_id,
+        g_queries_path,
+        q->filename,
+        q->pc_inicial,
+        q->offset_inicial,
+        q->version_script,
+        &q->desalojo_op,
+        g_logger,
+        ej->fd_storage,
+        fd_master,
+        g_retardo_ms,
+        &q->canal_qc
+    );
+
+    if (!exec_ok) {
+        log_error(g_logger, "Fallo ejecutando Query %u.", q->query_id);
+    }
+}
+
+// Libera el contexto (un DESALOJO que llegó tarde se descarta con él)
+static void _terminar(t_ejecutor* ej) {
+    pthread_mutex_lock(&g_mtx);
+    list_remove_element(g_en_ejecucion, ej->query);
+    pthread_mutex_unlock(&g_mtx);
+
+    _destruir_contexto(ej->query);
+    ej->query = NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Hilo de cada slot
+// ---------------------------------------------------------------------------
+static void* _slot_loop(void* arg) {
+    t_slot*     s  = (t_slot*) arg;
+    t_ejecutor* ej = &s->ejecutores[0];
+
+    while (1) {
+        // 1) Esperar una Query pendiente
+        pthread_mutex_lock(&g_mtx);
+        while (g_activo && list_is_empty(g_pendientes)) {
+            pthread_cond_wait(&g_cond_hay, &g_mtx);
+        }
+        ej->query = _tomar_pendiente();
+        pthread_mutex_unlock(&g_mtx);
+
+        if (!ej->query) break;   // detenido y sin trabajo
+
+        // 2) Ejecutar con la conexión a Storage del slot
+        _ejecutar(ej);
+        _terminar(ej);
+    }
+
+    return NULL;
+}
+
+static void* _slot_loop_corrutinas(void* arg) {
+    t_slot* s = (t_slot*) arg;
+
+    while (1) {
+        // 1) Ejecutores libres toman pendientes
+        uint32_t ocupados = 0;
+
+        pthread_mutex_lock(&g_mtx);
+        for (uint32_t i = 0; i < s->cant_ejecutores; i++) {
+            t_ejecutor* ej = &s->ejecutores[i];
+            if (!ej->query && (ej->query = _tomar_pendiente()) != NULL) {
+                corrutina_iniciar(ej->co, _ejecutar, ej);
+            }
+            if (ej->query) ocupados++;
+        }
+        int seguir = g_activo || ocupados > 0;
+        pthread_mutex_unlock(&g_mtx);
+
+        if (!seguir) break;
+
+        // 2) Reanudar las listas
+        int hubo = 0;
+        for (uint32_t i = 0; i < s->cant_ejecutores; i++) {
+            t_ejecutor* ej = &s->ejecutores[i];
+            if (!ej->query || !corrutina_lista(ej->co)) continue;
+
+            hubo = 1;
+            if (corrutina_reanudar(ej->co)) _terminar(ej);
+        }
+        if (hubo) continue;
+
+        // 3) Nadie puede seguir: esperar I/O, deadlines o una asignación nueva
+        corrutinas_esperar(s->cos, (int)s->cant_ejecutores, s->fd_aviso);
+
+        uint64_t v;
+        while (read(s->fd_aviso, &v, sizeof(v)) > 0) {
+            // vaciar el contador
+        }
+    }
+
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Arranque
+// ---------------------------------------------------------------------------
+// Conexión a Storage del ejecutor (fd_storage >= 0: reusar esa)
+static int _abrir_storage(t_ejecutor* ej, int fd_storage, const char* ip, const char* puerto, t_log* logger) {
+    if (fd_storage >= 0) {
+        ej->fd_storage = fd_storage;
+        ej->propio     = false;
+        return 1;
+    }
+
+    ej->fd_storage = conectar_a(ip, puerto);
+    if (ej->fd_storage < 0 || storage_get_block_size(ej->fd_storage, logger) <= 0) {
+        if (ej->fd_storage >= 0) close(ej->fd_storage);
+        ej->fd_storage = -1;
+        return 0;
+    }
+    ej->propio = true;
+    return 1;
+}
+
+static void _cerrar_slot(t_slot* s) {
+    for (uint32_t i = 0; i < s->cant_ejecutores; i++) {
+        t_ejecutor* ej = &s->ejecutores[i];
+        if (ej->propio) close(ej->fd_storage);
+        if (ej->co) corrutina_destruir(ej->co);
+    }
+    if (s->fd_aviso >= 0) close(s->fd_aviso);
+    free(s->ejecutores);
+    free(s->cos);
+}
+
+uint32_t slots_iniciar(
+    uint32_t    cant,
+    uint32_t    corrutinas_por_slot,
+    int         fd_storage,
+    const char* ip_storage,
+    const char* puerto_storage,
+    const char* queries_path,
+    uint32_t    retardo_ms,
+    t_log*      logger
+) {
+    if (cant == 0) cant = 1;
+    if (corrutinas_por_slot == 0) corrutinas_por_slot = 1;
+
+    g_queries_path = queries_path;
+    g_retardo_ms   = retardo_ms;
+    g_logger       = logger;
+    g_corrutinas   = corrutinas_por_slot > 1;
+
+    g_slots        = calloc(cant, sizeof(t_slot));
+    g_pendientes   = list_create();
+    g_en_ejecucion = list_create();
+    if (!g_slots || !g_pendientes || !g_en_ejecucion) return 0;
+
+    g_activo = 1;
+
+    uint32_t capacidad = 0;
+    for (uint32_t i = 0; i < cant; i++) {
+        t_slot* s = &g_slots[g_cant];
+        s->fd_aviso   = -1;
+        s->ejecutores = calloc(corrutinas_por_slot, sizeof(t_ejecutor));
+        s->cos        = calloc(corrutinas_por_slot, sizeof(t_corrutina*));
+        if (!s->ejecutores || !s->cos) {
+            _cerrar_slot(s);
+            break;
+        }
+
+        // 1) Ejecutores: conexión a Storage (+ corrutina). Si falla alguno, el
+        //    slot sigue con los que ya tiene
+        for (uint32_t k = 0; k < corrutinas_por_slot; k++) {
+            t_ejecutor* ej = &s->ejecutores[k];
+            int primero = (g_cant == 0 && k == 0);
+
+            if (!_abrir_storage(ej, primero ? fd_storage : -1, ip_storage, puerto_storage, logger)) {
+                if (logger) log_warning(logger, "Slot %u: no pude conectar a Storage %s:%s.",
+                                        i, ip_storage, puerto_storage);
+                break;
+            }
+            if (g_corrutinas) {
+                ej->co = corrutina_crear(PILA_CORRUTINA);
+                if (!ej->co) {
+                    if (ej->propio) close(ej->fd_storage);
+                    break;
+                }
+                s->cos[k] = ej->co;
+            }
+            s->cant_ejecutores++;
+        }
+
+        if (g_corrutinas && s->cant_ejecutores > 0) {
+            s->fd_aviso = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        }
+
+        // 2) Hilo del slot
+        if (s->cant_ejecutores == 0 || (g_corrutinas && s->fd_aviso < 0) ||
+            pthread_create(&s->hilo, NULL, g_corrutinas ? _slot_loop_corrutinas : _slot_loop, s) != 0) {
+            if (logger) log_warning(logger, "Slot %u: no pude iniciarlo. Sigo con %u slots.", i, g_cant);
+            _cerrar_slot(s);
+            break;
+        }
+
+        capacidad += s->cant_ejecutores;
+        g_cant++;
+    }
+
+    if (capacidad > 1 && logger) {
+        log_info(logger, "Slots de ejecución: %u hilos, %u Queries en paralelo%s",
+                 g_cant, capacidad, g_corrutinas ? " (corrutinas)" : "");
+    }
+    return capacidad;
+}
+
+void slots_set_fd_master(int fd_master) {
+    pthread_mutex_lock(&g_mtx);
+    g_fd_master = fd_master;
+    pthread_mutex_unlock(&g_mtx);
+}
+
+// ---------------------------------------------------------------------------
+// Despacho (hilo de main)
+// ---------------------------------------------------------------------------
+static void _avisar_slots(void) {
+    uint64_t uno = 1;
+    for (uint32_t i = 0; i < g_cant; i++) {
+        if (g_slots[i].fd_aviso >= 0 && write(g_slots[i].fd_aviso, &uno, sizeof(uno)) < 0) {
+            // contador saturado: el slot ya tiene un aviso pendiente
+        }
+    }
+}
+
+void slots_asignar(
+    uint32_t query_id,
+    char*    filename,
+    uint32_t pc_inicial,
+    uint32_t offset_inicial,
+    uint32_t version_script,
+    t_canal_qc canal_qc
+) {
+    t_contexto_query* q = malloc(sizeof(t_contexto_query));
+    q->query_id       = query_id;
+    q->filename       = filename;
+    q->pc_inicial     = pc_inicial;
+    q->offset_inicial = offset_inicial;
+    q->version_script = version_script;
+    q->canal_qc       = canal_qc;
+    atomic_init(&q->desalojo_op, 0);
+
+    pthread_mutex_lock(&g_mtx);
+    list_add(g_pendientes, q);
+    pthread_cond_signal(&g_cond_hay);
+    pthread_mutex_unlock(&g_mtx);
+
+    _avisar_slots();
+}
+
+static t_contexto_query* _buscar(t_list* l, uint32_t query_id) {
+    for (int i = 0; i < list_size(l); i++) {
+        t_contexto_query* q = list_get(l, i);
+        if (q->query_id == query_id) return q;
+    }
+    return NULL;
+}
+
+int slots_desalojar(uint32_t query_id, uint16_t op) {
+    pthread_mutex_lock(&g_mtx);
+
+    // Si todavía está pendiente, el intérprete la desaloja antes de la
+    // primera instrucción
+    t_contexto_query* q = _buscar(g_en_ejecucion, query_id);
+    if (!q) q = _buscar(g_pendientes, query_id);
+    if (q) atomic_store_explicit(&q->desalojo_op, op, memory_order_release);
+
+    pthread_mutex_unlock(&g_mtx);
+    return q != NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Parada
+// ---------------------------------------------------------------------------
+void slots_detener(void) {
+    if (!g_slots) return;
+
+    // 1) Sin Master no llegan más asignaciones: las pendientes se descartan
+    pthread_mutex_lock(&g_mtx);
+    g_activo = 0;
+    list_clean_and_destroy_elements(g_pendientes, _destruir_contexto);
+    pthread_cond_broadcast(&g_cond_hay);
+    pthread_mutex_unlock(&g_mtx);
+    _avisar_slots();
+
+    // 2) Esperar las Queries en curso y cerrar las conexiones propias
+    for (uint32_t i = 0; i < g_cant; i++) {
+        pthread_join(g_slots[i].hilo, NULL);
+        _cerrar_slot(&g_slots[i]);
+    }
+
+    list_destroy(g_pendientes);
+    list_destroy(g_en_ejecucion);
+    free(g_slots);
+    g_pendientes   = NULL;
+    g_en_ejecucion = NULL;
+    g_slots        = NULL;
+    g_cant         = 0;
+}
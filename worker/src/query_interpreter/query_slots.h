@@ -0,0 +1,59 @@
+// ============================================================================
+// WORKER - query_slots.h
+// PASO A PASO GENERAL
+// 1) SLOTS_EJECUCION hilos, cada uno con su propia conexión a Storage,
+//    ejecutan Queries en paralelo (el slot 0 usa g_fd_storage)
+// 2) El loop de main.c solo despacha: ASIGNACION_QUERY encola la Query y un
+//    slot libre la toma; DESALOJO marca el pedido en el contexto de la Query
+// 3) El intérprete consulta ese pedido entre instrucciones (ya no lee el
+//    socket del Master): es una palabra atómica del contexto, sin lock
+// 4) Con CORRUTINAS_POR_SLOT > 1 cada slot corre esa cantidad de Queries en
+//    corrutinas que se turnan el hilo mientras esperan I/O (ver corrutinas.h)
+// El HELLO_WORKER informa la capacidad total (slots x corrutinas) para que el
+// Master asigne hasta esa cantidad de Queries a la vez.
+// ============================================================================
+
+#ifndef QUERY_SLOTS_H
+#define QUERY_SLOTS_H
+
+#include <stdint.h>
+#include <commons/log.h>
+#include "../conexiones/query_control.h"
+
+// Devuelve cuántas Queries se pueden ejecutar a la vez (0 si no arrancó
+// ningún slot). Cada Query en paralelo usa su propia conexión a Storage; si
+// alguna no se pudo abrir, se sigue con menos.
+uint32_t slots_iniciar(
+    uint32_t    cant,
+    uint32_t    corrutinas_por_slot,
+    int         fd_storage,
+    const char* ip_storage,
+    const char* puerto_storage,
+    const char* queries_path,
+    uint32_t    retardo_ms,
+    t_log*      logger
+);
+
+// Los slots arrancan antes del HELLO (que informa cuántos quedaron): el fd
+// del Master se fija después, antes de la primera asignación
+void slots_set_fd_master(int fd_master);
+
+// Toma ownership de filename y de canal_qc.ip. offset/version: posición del
+// PC en el script que informó el Worker que la desalojó (0 si no hay)
+void slots_asignar(
+    uint32_t   query_id,
+    char*      filename,
+    uint32_t   pc_inicial,
+    uint32_t   offset_inicial,
+    uint32_t   version_script,
+    t_canal_qc canal_qc
+);
+
+// op = OP_DESALOJO_QUERY / OP_DESALOJO_POR_CANCELACION.
+// Devuelve 1 si la Query está asignada a este Worker (el slot responde el ACK)
+int slots_desalojar(uint32_t query_id, uint16_t op);
+
+// Espera a que terminen las Queries en curso y cierra las conexiones propias
+void slots_detener(void);
+
+#endif // QUERY_SLOTS_H